@@ -378,15 +378,13 @@ void compute_comp_sds_hist(char *fname, char **sds_names, int nsds, int nd_info,
   int irow, irank, isds;
   int nrows, ncols, ndata;
   int *fill_cnt, **hist_cnt;
-  int32 start[4], edge[4];
+  sds_block_t blk;
 
   sds_info.sd_id = -1;
   for (isds=0; isds<nsds; isds++)
   {
     sds_info.sds_id = -1;
     strcpy(sds_info.name, sds_names[isds]);
-    for (irank=0; irank<4; irank++)
-      start[irank] = edge[irank] = 0;
     sds_info.range[0] = sds_info.range[1] = -111;
     if (get_sds_info(fname, &sds_info) != -1)
     {
@@ -424,7 +422,7 @@ void compute_comp_sds_hist(char *fname, char **sds_names, int nsds, int nd_info,
         if (rank == 1)
         {
           nrows = 1;
-	  edge[0] = ncols = ndata = sds_info.dim_size[0];
+	  ncols = ndata = sds_info.dim_size[0];
         }
         else
         {
@@ -432,14 +430,12 @@ void compute_comp_sds_hist(char *fname, char **sds_names, int nsds, int nd_info,
           if (bsq == 1)
           {
             nrows = sds_info.dim_size[rank-2];
-            ncols = ndata = edge[rank-1] = sds_info.dim_size[rank-1];
+            ncols = ndata = sds_info.dim_size[rank-1];
             for (irank=0; irank<rank-2; irank++)
             {
 	      n_layer *= sds_info.dim_size[irank];
               ndata *= sds_info.dim_size[irank];
-              edge[irank] = sds_info.dim_size[irank];
             }
-            edge[rank-2] = 1;
 	    max_m = sds_info.dim_size[1];
           }
           else
@@ -450,10 +446,7 @@ void compute_comp_sds_hist(char *fname, char **sds_names, int nsds, int nd_info,
 	    {
 	      n_layer *= sds_info.dim_size[irank];
 	      ndata *= sds_info.dim_size[irank];
-	      edge[irank] = sds_info.dim_size[irank];
 	    }
-	    edge[0] = 1;
-	    edge[1] = sds_info.dim_size[1];
 	    max_m = sds_info.dim_size[3];
           }
         }
@@ -472,7 +465,9 @@ void compute_comp_sds_hist(char *fname, char **sds_names, int nsds, int nd_info,
 	  fprintf(stderr, "Cannot allocate memory for hist_cnt in read_sds_values\n");	
 	if ((fill_cnt = (int *)calloc(n_layer, sizeof(int))) == NULL)
 	  fprintf(stderr, "Cannot allocate memory for fill_cnt in read_sds_values\n");	
-        if ((data_in != NULL) && (hist_cnt != NULL) && (fill_cnt != NULL)) 
+        blk.buf = NULL;
+        if ((data_in != NULL) && (hist_cnt != NULL) && (fill_cnt != NULL) &&
+	    (open_sds_block(&sds_info, &blk, 'R', 1, 0L) != -1))
 	{
           for (layer_id=0; layer_id<n_layer; layer_id++)
 	    fill_cnt[layer_id] = 0;
@@ -481,13 +476,7 @@ void compute_comp_sds_hist(char *fname, char **sds_names, int nsds, int nd_info,
 	      hist_cnt[layer_id][irange] = 0;
           for (irow=0; irow<nrows; irow++)
           {
-            if (rank == 1) start[0] = 0;
-	    else
-	    {
-	      if (bsq == 1) start[rank-2] = irow;
-	      else start[0] = irow;
-	    }
-	    if (SDreaddata(sds_info.sds_id, start, NULL, edge, data_in) == FAIL)
+	    if (read_sds_block_rows(&blk, irow, 1, data_in) == -1)
 	      fprintf(stderr, "Failed to read data row for SDS %s\n", sds_info.name);
 	    else
             {
@@ -506,6 +495,7 @@ void compute_comp_sds_hist(char *fname, char **sds_names, int nsds, int nd_info,
           } /* for (irow=0;  . .  ) */
           print_comp_sds_hist(&sds_info, hist_cnt, fill_cnt, n_layer, hist_range);
 	}
+	if (blk.buf != NULL) close_sds_block(&blk);
 	Free2D((void **)hist_cnt);
 	free(fill_cnt);
         free(data_in);
@@ -105,6 +105,8 @@
 "                             specified with this option, then the names of\n"\
 "                             all the SDSs in the file are displayed.\n" \
 "    -of=<filename>           Output filename.\n" \
+SDS_COMPRESS_HELP("         ", "                             ") \
+QA_SLICED_HELP("                  ", "                             ") \
 "    -meta                    Copy metadata from the input file to the\n"\
 "                             output file.\n" \
 "    -mask=<mask1>[,AND|OR,<mask2>[,..]] \n" \
@@ -153,9 +155,21 @@
 "                             element of the 4th dimesnsion of the 4D SDS\n"\
 "                             Surface_Refl).  \n" \
 " \n" \
+"                             The filename may also be a GeoTIFF file, such\n"\
+"                             as a Landsat QA band, in which case the SDS\n"\
+"                             name is the band: band1 for the first band.\n"\
+"                             Pixels equal to the fill value of the band are\n"\
+"                             fill: the value of its GDAL_NODATA tag, or 1,\n"\
+"                             the Landsat QA fill value, if it has none. Write\n"\
+"                             the band as band1:<fill value> to set it.\n"\
+"                             For example,\n" \
+"                                -mask=LC08_BQA.TIF,band1,4==1\n"\
+" \n" \
 "    -on=<ON value>           User defined output ON value. \n" \
 " \n" \
 "    -off=<OFF value>         User defined output OFF value. \n" \
+"                             The ON and OFF values cannot be 2, the\n"\
+"                             value of the fill pixels of the mask.\n"\
 " \n" \
 "Examples: \n" \
 "    create_mask -of=land_mask.hdf -on=255 -off=0 \n" \
@@ -193,6 +207,8 @@
 "                             specified with this option, then the names of \n"\
 "                             all the SDSs in the file are displayed.\n" \
 "    -of=<filename>           Output filename.\n" \
+SDS_COMPRESS_HELP("         ", "                             ") \
+QA_SLICED_HELP("                  ", "                             ") \
 "    -meta                    Copy metadata from the input file to the\n"\
 "                             output file.\n" \
 "    -mask=<mask1>[,AND|OR,<mask2>[,..]]\n" \
@@ -240,9 +256,21 @@
 "                             element of the 4th dimesnsion of the 4D SDS\n"\
 "                             Surface_Refl).  \n" \
 " \n" \
+"                             The filename may also be a GeoTIFF file, such\n"\
+"                             as a Landsat QA band, in which case the SDS\n"\
+"                             name is the band: band1 for the first band.\n"\
+"                             Pixels equal to the fill value of the band are\n"\
+"                             fill: the value of its GDAL_NODATA tag, or 1,\n"\
+"                             the Landsat QA fill value, if it has none. Write\n"\
+"                             the band as band1:<fill value> to set it.\n"\
+"                             For example,\n" \
+"                                -mask=LC08_BQA.TIF,band1,4==1\n"\
+" \n" \
 "    -on=<ON value>           User defined output ON value. \n" \
 " \n" \
 "    -off=<OFF value>         User defined output OFF value. \n" \
+"                             The ON and OFF values cannot be 2, the\n"\
+"                             value of the fill pixels of the mask.\n"\
 " \n"
 
 
@@ -401,6 +429,7 @@ int parse_cmd_create_mask(int argc, char **argv, char *mask_str, char *out_fname
   char on_val_str[20];
   char off_val_str[20];
 	char fill_val_str[20];
+  char comp_str[MAX_STR_LEN];
 		
   *on_val = ON_VAL;
   *off_val = OFF_VAL;
@@ -418,6 +447,11 @@ int parse_cmd_create_mask(int argc, char **argv, char *mask_str, char *out_fname
     else if (strstr(argv[i], "-on=") != NULL) get_arg_val(argv[i], on_val_str);
     else if (strstr(argv[i], "-off=") != NULL) get_arg_val(argv[i], off_val_str);
     else if (strstr(argv[i], "-of=") != NULL) get_arg_val(argv[i], out_fname);
+    else if (strcmp(argv[i], "-sliced") == 0) set_qa_sliced(1);
+    else if (strstr(argv[i], "-compress=") != NULL) {
+      get_arg_val(argv[i], comp_str);
+      if (set_sds_compress(comp_str) == -1) st = -1;
+    }
 				else if (strstr(argv[i], "-fill=") != NULL) get_arg_val(argv[i], fill_val_str);
     else fprintf(stderr, "Igonoring invalid argument %s\n", argv[i]);
   }
@@ -442,6 +476,14 @@ int parse_cmd_create_mask(int argc, char **argv, char *mask_str, char *out_fname
       fprintf(stderr, "Output mask SDS values (ON and OFF) invalid: %s %s\n", on_val_str, off_val_str);
       fprintf(stderr, "Ouput SDS values (ON and OFF) set to default: %d %d\n", *on_val, *off_val);
     }
+    else if ((*off_val == MASK_FILL) || (*on_val == MASK_FILL))
+    {
+      /* the mask fill value is the _FillValue of the output SDS */
+      *off_val = OFF_VAL; *on_val = ON_VAL;
+      fprintf(stderr, "Output mask SDS values (ON and OFF) cannot be the mask fill value %d: %s %s\n",
+	      MASK_FILL, on_val_str, off_val_str);
+      fprintf(stderr, "Ouput SDS values (ON and OFF) set to default: %d %d\n", *on_val, *off_val);
+    }
   }
   return st;
 }
@@ -481,12 +523,7 @@ void generate_mask(char *m_str, char *out_fname, int on_val, int off_val)
   int n_op = 0, i_op, j_op;
   int obs_num[MAX_NUM_OP];
   void *data_qa[MAX_NUM_OP];
-  int32 edge[4] = {0, 0, 0, 0};
-  int32 start[4] = {0, 0, 0, 0}; 
-  
-  /* int32 edge[4] = {0, 0};
-     int32 start[4] = {0, 0}; */
-  
+  sds_block_t out_blk, qa_blk[MAX_NUM_OP];
   int32 *data_qa_nadd[MAX_NUM_OP];
   char sdsi_name[MAX_SDS_NAME_LEN];
   char sdsj_name[MAX_SDS_NAME_LEN];
@@ -514,6 +551,7 @@ void generate_mask(char *m_str, char *out_fname, int on_val, int off_val)
     {
       strcpy(out_sds_info.name, "Mask_sds");
       out_sds_info.data_type = DFNT_UINT8;
+      out_sds_info.data_size = DFKNTsize(DFNT_UINT8);
       out_sds_info.sd_id = out_sds_info.sds_id = -1;
       rank = qa_sds_info[0].rank;
       out_sds_info.rank = 2; 
@@ -533,8 +571,14 @@ void generate_mask(char *m_str, char *out_fname, int on_val, int off_val)
           fprintf(stderr, "Cannot allocate memory for mask_row in generate_mask\n");
         st = open_qa_sds_nsds((char *)NULL, (sds_t *)NULL, (sds_t *)NULL, (sds_t *)NULL, 1, 
 			qa_fnames, qa_sds_info, qa_sdsc_info, qa_sds_nobs_info, fqa_l2g, n_op);
+        if (open_qa_sds_blocks(qa_sds_info, n_op, qa_blk, 0L) == -1)
+          st = -1;
         if (st != -1)
           st = malloc_qa_sds(qa_sds_info, n_op, fqa_l2g, data_qa, data_qa_nadd);
+        /* the mask fill value is the SDS fill value, so rows of it need not be written */
+        write_attr_fval(out_sds_info.sds_id, DFNT_UINT8, 1, MASK_FILL, ATTR_FILL_NAME);
+        if (open_sds_block(&out_sds_info, &out_blk, 'W', 1, 0L) == -1)
+          st = -1;
 
         if ((st != -1) && (mask_row != NULL))
         {
@@ -548,18 +592,20 @@ void generate_mask(char *m_str, char *out_fname, int on_val, int off_val)
             }
             else obs_num[i_op] = 1;
 
-	  edge[0] = 1; edge[1] = out_sds_info.dim_size[1];
           for (irow=0; irow<out_sds_info.dim_size[0]; irow++)
           {
-	    start[0] = irow;
-            read_qa_sds(qa_sds_info, qa_sdsc_info, qa_sds_nobs_info, n_op, data_qa, data_qa_nadd,
-                            irow, res_l, fqa_l2g, obs_num);
+            read_qa_sds(qa_sds_info, qa_sdsc_info, qa_sds_nobs_info, qa_blk, n_op, data_qa, 
+			    data_qa_nadd, irow, res_l, fqa_l2g, obs_num);
             process_mask_data(data_qa, out_sds_info.dim_size[1], qa_sds_info, n_op, sel_qa_op,
 		bit_mask_arr, mask_val_arr, rel_op, res_s, mask_row, on_val, off_val, MASK_FILL);
-	    if (SDwritedata(out_sds_info.sds_id, start, NULL, edge, (VOIDP)mask_row) == FAIL)
+	    if (write_sds_block_rows(&out_blk, irow, 1, (VOIDP)mask_row) == -1)
 	      fprintf(stderr, "Error writing a line of data to output SDS in generate_mask\n");
           } /* for (irow=0; . . . */
         }
+        if (out_blk.buf != NULL)
+          if (close_sds_block(&out_blk) == -1)
+	    fprintf(stderr, "Error writing a line of data to output SDS in generate_mask\n");
+        close_qa_sds_blocks(qa_blk, n_op);
 
         /* close all SDS and HDF files */
         for (i_op=0; i_op<=n_op; i_op++)
@@ -599,14 +599,15 @@ void comp_stat(sds_t *in_sds_info, int fcnt, int out_sd_id, char *range1,
   float32 *sds_std;
   int fid, isds, nsds;
   int ic, st_c, offset;
-  int in_rank, out_rank;
+  int out_rank;
   sds_t out_sds_info[6];
   int ndata_in, range[2];
   int i, n, m, dim_sz[4];
   int nop_in, nop_out, npix;
   int irow, icol, nrows = 0, ncols = 0;
-  int32 in_start[4], in_edge[4];
-  int32 out_start[4], out_edge[4];
+  int nblk;
+  long blk_mem;
+  sds_block_t *in_blk, out_blk[6];
   double sum, sum2, avg, avg2;
   double min = 0, max = 0, std, sds_val = 0.0;
   void *sds_sum, *sds_mean;
@@ -654,7 +655,7 @@ void comp_stat(sds_t *in_sds_info, int fcnt, int out_sd_id, char *range1,
       if (isds == 2) out_sds_info[isds].data_type = DFNT_FLOAT32;
       else if (isds == 3) out_sds_info[isds].data_type = DFNT_INT16;
       else out_sds_info[isds].data_type = out_dt;
-      out_sds_info[isds].data_size = DFKNTsize(out_dt);;
+      out_sds_info[isds].data_size = DFKNTsize(out_sds_info[isds].data_type);
       out_sds_info[isds].rank=out_rank;
       for (i=0; i<out_rank; i++)
         out_sds_info[isds].dim_size[i] = dim_sz[i];    
@@ -682,10 +683,10 @@ void comp_stat(sds_t *in_sds_info, int fcnt, int out_sd_id, char *range1,
   if ((sds_data = (void **)Calloc2D(fcnt, ndata_in, in_sds_info[0].data_size)) == NULL)
     fprintf(stderr, "Cannot allocate memory for sds_data \n");
   
-  if ((sds_sum = (void *)calloc(ncols, in_sds_info[0].data_size)) == NULL)
+  if ((sds_sum = (void *)calloc(ncols, DFKNTsize(out_dt))) == NULL)
     fprintf(stderr, "Cannot allocate memory for sds_sum \n");
   
-  if ((sds_mean = (void *)calloc(ncols, in_sds_info[0].data_size)) == NULL)
+  if ((sds_mean = (void *)calloc(ncols, DFKNTsize(out_dt))) == NULL)
     fprintf(stderr, "Cannot allocate memory for sds_mean \n");
   
   if ((sds_std = (float32 *)calloc(ncols, sizeof(float32))) == NULL)
@@ -694,37 +695,40 @@ void comp_stat(sds_t *in_sds_info, int fcnt, int out_sd_id, char *range1,
   if ((sds_npix = (int16 *)calloc(ncols, sizeof(int16))) == NULL)
     fprintf(stderr, "Cannot allocate memory for sds_npix \n");
   
-  if ((sds_min = (void *)calloc(ncols, in_sds_info[0].data_size)) == NULL)
+  if ((sds_min = (void *)calloc(ncols, DFKNTsize(out_dt))) == NULL)
     fprintf(stderr, "Cannot allocate memory for sds_min \n");
   
-  if ((sds_max = (void *)calloc(ncols, in_sds_info[0].data_size)) == NULL)
+  if ((sds_max = (void *)calloc(ncols, DFKNTsize(out_dt))) == NULL)
     fprintf(stderr, "Cannot allocate memory for sds_max \n");
 
-  get_sds_edge(&in_sds_info[0], in_edge); 
-
-  get_sds_edge(&out_sds_info[isds], out_edge); 
+  if ((in_blk = (sds_block_t *)calloc(fcnt, sizeof(sds_block_t))) == NULL)
+    fprintf(stderr, "Cannot allocate memory for in_blk \n");
 
   compute_sds_start_offset(&in_sds_info[0], n, m, &st_c, &offset);
 
-  in_rank = in_sds_info[0].rank;
-
-  for (i=0; i<in_rank; i++) 
-    in_start[i] = 0;
+  /* share the block memory budget among all the input and output SDS */
+  for (isds=0, nblk=fcnt; isds<nsds; isds++)
+    if (param_st[isds] == 1) nblk++;
+  blk_mem = SDS_BLOCK_MEM_TOTAL/nblk;
+  if (blk_mem > SDS_BLOCK_MEM_SIZE) blk_mem = SDS_BLOCK_MEM_SIZE;
 
-  for (i=0; i<out_rank; i++) 
-    out_start[i] = 0;
+  if (in_blk == NULL) nrows = 0;
+  else
+    for (fid=0; fid<fcnt; fid++)
+      if (open_sds_block(&in_sds_info[fid], &in_blk[fid], 'R', 1, blk_mem) == -1)
+        nrows = 0;
+  for (isds=0; isds<nsds; isds++)
+  {
+    out_blk[isds].buf = NULL;
+    if (param_st[isds] == 1)
+      if (open_sds_block(&out_sds_info[isds], &out_blk[isds], 'W', 1, blk_mem) == -1)
+        nrows = 0;
+  }
 
   for (irow=0; irow<nrows; irow++)
   {
-    if ((in_rank == 2) || (in_sds_info[0].dim_size[0] > in_sds_info[0].dim_size[in_rank-1]))
-      in_start[0] = irow;
-    else in_start[in_rank-2] = irow;
-    if ((out_rank == 2) || (out_sds_info[isds].dim_size[0] > out_sds_info[isds].dim_size[out_rank-1]))
-      out_start[0] = irow;                      
-    else out_start[out_rank-2] = irow;
-
     for (fid=0; fid<fcnt; fid++)
-      if (SDreaddata(in_sds_info[fid].sds_id, in_start, NULL, in_edge, sds_data[fid]) == FAIL)
+      if (read_sds_block_rows(&in_blk[fid], irow, 1, sds_data[fid]) == -1)
 	fprintf(stderr, "Error reading data line %d from SDS %s\n", irow, in_sds_info[fid].name);
 
     ic = st_c;
@@ -771,7 +775,7 @@ void comp_stat(sds_t *in_sds_info, int fcnt, int out_sd_id, char *range1,
       sds_npix[icol] = (int16)npix;
       sds_std[icol] = (float32)std;
 
-      switch(in_sds_info[0].data_type)
+      switch(out_dt)
       {
 	case 5 : ((float32 *)sds_mean)[icol] = (float32)avg;
 		 ((float32 *)sds_sum)[icol] = (float32)sum;
@@ -814,44 +818,55 @@ void comp_stat(sds_t *in_sds_info, int fcnt, int out_sd_id, char *range1,
 
     if (param_st[0] == 1)
     {
-      if (SDwritedata(out_sds_info[0].sds_id, out_start, NULL, out_edge, sds_sum) == FAIL)
+      if (write_sds_block_rows(&out_blk[0], irow, 1, sds_sum) == -1)
         fprintf(stderr, "Error writing data line %d to SDS %s\n", irow, out_sds_info[0].name); 
     }
 
     if (param_st[1] == 1)
     {
-      if (SDwritedata(out_sds_info[1].sds_id, out_start, NULL, out_edge, sds_mean) == FAIL)
+      if (write_sds_block_rows(&out_blk[1], irow, 1, sds_mean) == -1)
         fprintf(stderr, "Error writing data line %d to SDS %s\n", irow, out_sds_info[1].name); 
     }
 
     if (param_st[2] == 1)
     {
-      if (SDwritedata(out_sds_info[2].sds_id, out_start, NULL, out_edge, (VOIDP)sds_std) == FAIL)
+      if (write_sds_block_rows(&out_blk[2], irow, 1, (VOIDP)sds_std) == -1)
         fprintf(stderr, "Error writing data line %d to SDS %s\n", irow, out_sds_info[2].name); 
     }
 
     if (param_st[3] == 1)
     {
-      if (SDwritedata(out_sds_info[3].sds_id, out_start, NULL, out_edge, (VOIDP)sds_npix) == FAIL)
+      if (write_sds_block_rows(&out_blk[3], irow, 1, (VOIDP)sds_npix) == -1)
         fprintf(stderr, "Error writing data line %d to SDS %s\n", irow, out_sds_info[3].name); 
     }
 
     if (param_st[4] == 1)
     {
-      if (SDwritedata(out_sds_info[4].sds_id, out_start, NULL, out_edge, sds_min) == FAIL)
+      if (write_sds_block_rows(&out_blk[4], irow, 1, sds_min) == -1)
         fprintf(stderr, "Error writing data line %d to SDS %s\n", irow, out_sds_info[4].name); 
     }
 
     if (param_st[5] == 1)
     {
-      if (SDwritedata(out_sds_info[5].sds_id, out_start, NULL, out_edge, sds_max) == FAIL)
+      if (write_sds_block_rows(&out_blk[5], irow, 1, sds_max) == -1)
         fprintf(stderr, "Error writing data line %d to SDS %s\n", irow, out_sds_info[5].name); 
     }
   }
 
   for (isds=0; isds<nsds; isds++)
     if (param_st[isds] == 1)
+    {
+      if (out_blk[isds].buf != NULL)
+        if (close_sds_block(&out_blk[isds]) == -1)
+          fprintf(stderr, "Error writing data lines to SDS %s\n", out_sds_info[isds].name);
       SDendaccess(out_sds_info[isds].sds_id);
+    }
+  if (in_blk != NULL)
+  {
+    for (fid=0; fid<fcnt; fid++)
+      if (in_blk[fid].buf != NULL) close_sds_block(&in_blk[fid]);
+    free(in_blk);
+  }
 
   Free2D((void **)sds_data);
   free(sds_mean);
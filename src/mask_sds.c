@@ -120,6 +120,8 @@
 "                            the names of all the SDSs in the file are\n" \
 "                            displayed. \n" \
 "    -of=<filename>          Output filename.\n" \
+SDS_COMPRESS_HELP("        ", "                            ") \
+QA_SLICED_HELP("                 ", "                            ") \
 "    -sds=<SDS list>         List of SDSs present in the input file to be\n"\
 "                            masked and written to the output file.  SDS\n"\
 "                            names must be specified separated by commas\n" \
@@ -189,6 +191,14 @@
 "                            element of the 3rd dimension and 2nd element \n" \
 "                            of the 4th dimesnsion of the 4D SDS\n"\
 "                            Surface_Refl). \n" \
+"                            The filename may also be a GeoTIFF file, such\n"\
+"                            as a Landsat QA band, in which case the SDS\n"\
+"                            name is the band: band1 for the first band.\n"\
+"                            Pixels equal to the fill value of the band are\n"\
+"                            fill: the value of its GDAL_NODATA tag, or 1,\n"\
+"                            the Landsat QA fill value, if it has none. Write\n"\
+"                            the band as band1:<fill value> to set it.\n"\
+"                            For example, -mask=LC08_BQA.TIF,band1,4==1\n"\
 "    filename                Input filename \n" \
 "\n" \
 "EXAMPLE \n" \
@@ -265,6 +275,8 @@
 "                            the names of all the SDSs in the file are\n" \
 "                            displayed. \n" \
 "    -of=<filename>          Output filename.\n" \
+SDS_COMPRESS_HELP("        ", "                            ") \
+QA_SLICED_HELP("                 ", "                            ") \
 "    -sds=<SDS list>         List of SDSs present in the input file to be\n"\
 "                            masked and written to the output file.  SDS\n"\
 "                            names must be specified separated by commas\n"\
@@ -333,6 +345,14 @@
 "                            Surface_Refl.1.2 = the layer defined by the 1st\n"\
 "                            element of the 3rd dimension and 2nd element of\n"\
 "                            the 4th dimesnsion of the 4D SDS Surface_Refl).\n"\
+"                            The filename may also be a GeoTIFF file, such\n"\
+"                            as a Landsat QA band, in which case the SDS\n"\
+"                            name is the band: band1 for the first band.\n"\
+"                            Pixels equal to the fill value of the band are\n"\
+"                            fill: the value of its GDAL_NODATA tag, or 1,\n"\
+"                            the Landsat QA fill value, if it has none. Write\n"\
+"                            the band as band1:<fill value> to set it.\n"\
+"                            For example, -mask=LC08_BQA.TIF,band1,4==1\n"\
 "    filename                Input filename \n" \
 "\n" 
 
@@ -708,6 +728,7 @@ int parse_cmd_mask_sds(int argc, char **argv, int *arg_cnt, char **arg_list, int
   int i, k;
   int st = 1;
   char fill_str[20];
+  char comp_str[MAX_STR_LEN];
   char out_fname[MAX_PATH_LENGTH];
   
   *sds_cnt = *m_opt = *f_opt = 0;
@@ -723,6 +744,12 @@ int parse_cmd_mask_sds(int argc, char **argv, int *arg_cnt, char **arg_list, int
       else if ((is_arg_id(argv[i], "-m=") == 0) || (is_arg_id(argv[i], "-mask=") == 0))
 	get_arg_val(argv[i], m_str);
       else if (strcmp(argv[i], "-meta") == 0) *m_opt = 1;
+      else if (strcmp(argv[i], "-sliced") == 0) set_qa_sliced(1);
+      else if (is_arg_id(argv[i], "-compress=") == 0)
+	{
+	  get_arg_val(argv[i], comp_str);
+	  if (set_sds_compress(comp_str) == -1) st = -1;
+	}
       else if (is_arg_id(argv[i], "-fill=") == 0) 
       {
 	*f_opt = 1;
@@ -804,7 +831,7 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 {
   int out_hdf_st;
   uint8 *data_mask;
-  int rank, data_size;
+  int data_size;
   int len, p1, obs_num_in;
   int st, i_op, j_op, n_op;
   int max = 0, min = 0, diff_max, diff_min;
@@ -816,7 +843,8 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
   int st_c[MAX_NSDS], offset[MAX_NSDS], n[MAX_NSDS], m[MAX_NSDS];
   char **qa_fnames, num_str[10], org_sds_name[MAX_SDS_NAME_LEN];
   int32 *data_qa_nadd[MAX_NUM_OP], *data_in_nadd = NULL; 
-  int32 **in_edge, **in_start, **out_edge, **out_start;
+  long blk_mem;
+  sds_block_t *in_blk = NULL, *out_blk = NULL, qa_blk[MAX_NUM_OP];
   sds_t sds_info, in_sds_nobs_info, *in_sds_info, *in_sdsc_info = NULL, *out_sds_info = NULL;
   sds_t qa_sdsc_info[MAX_NUM_OP], qa_sds_info[MAX_NUM_OP], qa_sds_nobs_info[MAX_NUM_OP];
   unsigned long bit_mask_arr[MAX_NUM_OP], mask_val_arr[MAX_NUM_OP];
@@ -944,10 +972,10 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 	    st = get_res_factors(&in_sds_info[0], qa_sds_info, n_op, res_l, res_s);
 	  if (st != -1)
 	    {
-	      in_edge = (int32 **)Calloc2D(nsds, 4, sizeof(int32));
-	      in_start = (int32 **)Calloc2D(nsds, 4, sizeof(int32));
-	      out_edge = (int32 **)Calloc2D(nsds, 4, sizeof(int32));
-	      out_start = (int32 **)Calloc2D(nsds, 4, sizeof(int32));
+	      if ((in_blk = (sds_block_t *)calloc(nsds, sizeof(sds_block_t))) == NULL)
+		fprintf(stderr, "Cannot allocate memory for in_blk in mask_nsds()\n");
+	      if ((out_blk = (sds_block_t *)calloc(nsds, sizeof(sds_block_t))) == NULL)
+		fprintf(stderr, "Cannot allocate memory for out_blk in mask_nsds()\n");
 	      if (fin_l2g == 1)
 		{
 		  strcpy(sds_info.name, "nadd_obs_row"); sds_info.rank = 1; 
@@ -970,37 +998,17 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 	      create_out_sds(in_sds_info, out_sds_info, nsds, arg_list[arg_cnt], m_str, n, m, 
 			     out_sd_id, out_hdf_st, mask_fill);
 
+	      /* share the block memory budget among the input and output SDS */
+	      blk_mem = SDS_BLOCK_MEM_TOTAL/(2*nsds);
+	      if (blk_mem > SDS_BLOCK_MEM_SIZE) blk_mem = SDS_BLOCK_MEM_SIZE;
+	      if ((in_blk == NULL) || (out_blk == NULL)) st = -1;
 	      for (isds=0; isds<nsds; isds++)
 		{
-		  rank = in_sds_info[isds].rank;
-		  if (rank == 2)
-		    {
-		      in_edge[isds][0] = out_edge[isds][0] = 1;
-		      in_edge[isds][1] = out_edge[isds][1] = in_sds_info[isds].dim_size[1];
-		    }
-		  else if (rank > 2)
-		    {
-		      for (i=0; i<rank; i++)
-			in_edge[isds][i] = out_edge[isds][i] = in_sds_info[isds].dim_size[i];
-		      if ((n[isds] == -1) && (m[isds] == -1))
-			{
-			  if (in_sds_info[isds].dim_size[0] > in_sds_info[isds].dim_size[rank-1])
-			    in_edge[isds][0] = out_edge[isds][0] = 1;
-			  else in_edge[isds][rank-2] = out_edge[isds][rank-2] = 1;
-			}
-		      else
-			{
-			  out_edge[isds][0] = 1; out_edge[isds][1] = out_sds_info[isds].dim_size[1];
-			  if (in_sds_info[isds].dim_size[0] > in_sds_info[isds].dim_size[rank-1])
-			    { 
-			      in_edge[isds][0] = 1;
-			    }
-			  else 
-			    {
-			      in_edge[isds][rank-2] = 1;
-			    }
-			}
-		    }
+		  if ((st != -1) && (open_sds_block(&in_sds_info[isds], &in_blk[isds], 'R', 1, blk_mem) == -1))
+		    st = -1;
+		  if ((st != -1) && (out_hdf_st == 1) && (out_sd_id != -1))
+		    if (open_sds_block(&out_sds_info[isds], &out_blk[isds], 'W', 1, blk_mem) == -1)
+		      st = -1;
 		  compute_sds_start_offset(&in_sds_info[isds], n[isds], m[isds], &st_c[isds], &offset[isds]); 
 		} /* for (isds=0; . . . ) */
 
@@ -1018,16 +1026,17 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 	      }
 	      else data_out = NULL;
 	      
-	      if ((data_in != NULL) && (data_mask != NULL))
+	      if ((data_in != NULL) && (data_mask != NULL) && (st != -1))
 		{	
 		  st = open_qa_sds_nsds(arg_list[0], in_sds_info, in_sdsc_info, &in_sds_nobs_info, nsds, qa_fnames,
 					qa_sds_info, qa_sdsc_info, qa_sds_nobs_info, fqa_l2g, n_op);
 		  if (st != -1)
 		    st = malloc_qa_sds(qa_sds_info, n_op, fqa_l2g, data_qa, data_qa_nadd);
+		  if (st != -1)
+		    st = open_qa_sds_blocks(qa_sds_info, n_op, qa_blk, blk_mem);
 		  
 		  if (st != -1)
 		    {
-		      rank = in_sds_info[0].rank;
 		      for (i_op=0; i_op<=n_op; i_op++)
 			if (fqa_l2g[i_op] == 1)
 			  {
@@ -1040,17 +1049,14 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 		      
 		      for (irow=0; irow<nrow; irow++)
 			{
-			  read_qa_sds(qa_sds_info, qa_sdsc_info, qa_sds_nobs_info, n_op, data_qa, data_qa_nadd,
-				      irow, res_l, fqa_l2g, obs_num);
+			  read_qa_sds(qa_sds_info, qa_sdsc_info, qa_sds_nobs_info, qa_blk, n_op, data_qa, 
+				      data_qa_nadd, irow, res_l, fqa_l2g, obs_num);
 			  
 			  process_mask_data(data_qa, ndata_mask, qa_sds_info, n_op, sel_qa_op, bit_mask_arr, 
 					    mask_val_arr, rel_op, res_s, data_mask, YES, NO, MASK_FILL);
 			  
 			  for (isds=0; isds<nsds; isds++)
 			    {
-			      if ((rank == 2) || (in_sds_info[isds].dim_size[0] > in_sds_info[isds].dim_size[rank-1]))
-				in_start[isds][0] = irow;
-			      else in_start[isds][rank-2] = irow;
 			      if (fin_l2g == 1)
 				{
 				  len = (int)strlen(in_sdsc_info[isds].name);
@@ -1061,14 +1067,12 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 				    read_sdsc_data(&in_sdsc_info[isds], &in_sds_nobs_info, data_in[isds], 
 						   data_in_nadd, irow, obs_num_in);
 				  else
-				    if (SDreaddata(in_sds_info[isds].sds_id, in_start[isds], NULL, in_edge[isds], 
-						   (VOIDP)data_in[isds]) == FAIL)
+				    if (read_sds_block_rows(&in_blk[isds], irow, 1, data_in[isds]) == -1)
 				      fprintf(stderr, "Cannot read data line from SDS %s in mask_sds()\n", 
 					      in_sds_info[isds].name);
 				}
 			      else
-				if (SDreaddata(in_sds_info[isds].sds_id, in_start[isds], NULL, in_edge[isds], 
-					       (VOIDP)data_in[isds]) == FAIL)
+				if (read_sds_block_rows(&in_blk[isds], irow, 1, data_in[isds]) == -1)
 				  fprintf(stderr, "Cannot read data line from SDS %s in mask_sds()\n", 
 					  in_sds_info[isds].name);
 			    } /* for (isds=0; . . .  */
@@ -1080,17 +1084,13 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 			    {
 			      for (isds=0; isds<nsds; isds++)
 				{
-				  if ((rank>2) && (n[isds] == -1) && (m[isds] == -1) && 
-				      (in_sds_info[isds].dim_size[rank-1] > in_sds_info[isds].dim_size[0]))
-				    out_start[isds][rank-2] = irow;
-				  else out_start[isds][0] = irow;
-				  if (SDwritedata(out_sds_info[isds].sds_id, out_start[isds], NULL, out_edge[isds], 
-						  data_out[isds]) == FAIL)
+				  if (write_sds_block_rows(&out_blk[isds], irow, 1, data_out[isds]) == -1)
 				    fprintf(stderr, "Cannot write data line to SDS %s in mask_nsds()\n", 
 					    out_sds_info[isds].name);
 				}
 			    }
 			} /* for (irow=0;  . .  ) */
+		      close_qa_sds_blocks(qa_blk, n_op);
 		      
 		      if ((m_opt == 1) && (out_hdf_st == 1))
 			copy_metadata(in_sds_info[0].sd_id, out_sds_info[0].sd_id);
@@ -1123,7 +1123,13 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 		      
 		      if (out_hdf_st == 1) 
 			for (isds=0; isds<nsds; isds++)
-			  if (out_sds_info[isds].sds_id != -1) SDendaccess(out_sds_info[isds].sds_id);
+			  {
+			    if (out_blk[isds].buf != NULL)
+			      if (close_sds_block(&out_blk[isds]) == -1)
+				fprintf(stderr, "Cannot write data line to SDS %s in mask_nsds()\n", 
+					out_sds_info[isds].name);
+			    if (out_sds_info[isds].sds_id != -1) SDendaccess(out_sds_info[isds].sds_id);
+			  }
 		      close_qa_hdf_nsds(arg_list[0], in_sds_info, nsds, qa_fnames, qa_sds_info, n_op);
 		      for (isds=0; isds<nsds; isds++)
 			if (in_sds_info[isds].sds_id != -1) 
@@ -1167,10 +1173,13 @@ int mask_nsds(int fin_l2g, int *fqa_l2g, char *m_str, char **arg_list, int arg_c
 		  if (out_hdf_st == 1)
 		    Free2D((void **)data_out);
 		} /* if ((data_in != NULL) && . . .  ) */
-	      Free2D((void **)in_edge);
-	      Free2D((void **)in_start);
-	      Free2D((void **)out_edge);
-	      Free2D((void **)out_start);
+	      for (isds=0; isds<nsds; isds++)
+		{
+		  if ((in_blk != NULL) && (in_blk[isds].buf != NULL)) close_sds_block(&in_blk[isds]);
+		  if ((out_blk != NULL) && (out_blk[isds].buf != NULL)) close_sds_block(&out_blk[isds]);
+		}
+	      if (in_blk != NULL) free(in_blk);
+	      if (out_blk != NULL) free(out_blk);
 	    } /* if (st != -1)  */
 	  free(in_sds_info);
 	  if (out_hdf_st == 1) free(out_sds_info);
@@ -55,6 +55,22 @@
 #include "str_op.h"
 #include "meta.h"
 #include "mask_sds_lib.h"
+#include "mask_tiff.h"
+
+/* sd_id of a GeoTIFF QA operand, whose sds_id is its slot in qa_tiff[] */
+#define QA_TIFF_SD_ID -2
+
+static qa_tiff_t *qa_tiff[MAX_NUM_OP];
+
+/* Word of the bit-sliced mask evaluation, holding one bit of QA_WORD_NPIX
+   pixels. 8 and 16-bit QA rows are transposed into QA_SLICE_NBITS bitplanes
+   of such words. */
+typedef unsigned long long qa_word_t;
+#define QA_WORD_NPIX 64
+#define QA_SLICE_NBITS 16
+
+/* The mask is evaluated on bitplanes, set by set_qa_sliced */
+static int qa_sliced = 0;
 
 static unsigned int BIT[] = {
   0x1,        0x2,        0x4,        0x8,
@@ -67,6 +83,89 @@ static unsigned int BIT[] = {
   0x10000000, 0x20000000, 0x40000000, 0x80000000
 };
 
+static int open_qa_tiff_sds(char *fname, sds_t *sds_info)
+/*
+ * Open the band of a GeoTIFF QA operand named by sds_info->name in a free
+ * slot of qa_tiff[] and describe it in sds_info as a 2D SDS. The fill value
+ * is that of the band, or the Landsat QA fill value if the band has none.
+ * Return 1 on success and -1 on failure.
+ */
+{
+  int slot, nrows, ncols, nbits, is_signed;
+  long fill;
+
+  sds_info->sd_id = sds_info->sds_id = -1;
+  for (slot=0; slot<MAX_NUM_OP; slot++)
+    if (qa_tiff[slot] == NULL) break;
+  if (slot >= MAX_NUM_OP)
+  {
+    fprintf(stderr, "Too many GeoTIFF QA files open in open_qa_tiff_sds\n");
+    return -1;
+  }
+  if ((qa_tiff[slot] = open_qa_tiff(fname, sds_info->name)) == NULL)
+    return -1;
+
+  get_qa_tiff_info(qa_tiff[slot], &nrows, &ncols, &nbits, &is_signed);
+  sds_info->sd_id = QA_TIFF_SD_ID;
+  sds_info->sds_id = slot;
+  sds_info->sds_index = -1;
+  sds_info->nattr = 0;
+  sds_info->rank = 2;
+  sds_info->dim_size[0] = nrows;
+  sds_info->dim_size[1] = ncols;
+  switch(nbits)
+  {
+    case 8: sds_info->data_type = (is_signed) ? DFNT_INT8 : DFNT_UINT8;
+	    sds_info->range[1] = (is_signed) ? 127 : 255; break;
+    case 16: sds_info->data_type = (is_signed) ? DFNT_INT16 : DFNT_UINT16;
+	     sds_info->range[1] = (is_signed) ? 32767 : 65535; break;
+    default: sds_info->data_type = (is_signed) ? DFNT_INT32 : DFNT_UINT32;
+	     sds_info->range[1] = 2147483647; break;
+  }
+  sds_info->data_size = nbits/8;
+  if (!get_qa_tiff_fill(qa_tiff[slot], &fill))
+    fill = QA_TIFF_FILL;
+  sds_info->fill_val = fill;
+  sds_info->fill_fval = (float32)fill;
+  sds_info->range[0] = (is_signed) ? -sds_info->range[1] - 1 : 0;
+  return 1;
+}
+
+static void close_qa_tiff_sds(sds_t *sds_info)
+/*
+ * Close the band of a GeoTIFF QA operand, if an operand sharing it has not
+ * already closed it.
+ */
+{
+  if ((sds_info->sds_id >= 0) && (sds_info->sds_id < MAX_NUM_OP))
+  {
+    close_qa_tiff(qa_tiff[sds_info->sds_id]);
+    qa_tiff[sds_info->sds_id] = NULL;
+  }
+  sds_info->sd_id = sds_info->sds_id = -1;
+}
+
+static int open_qa_operand(char *fname, sds_t *sds_info)
+/*
+ * Open the SDS, or the GeoTIFF band, of a QA operand for reading.
+ */
+{
+  if (is_tiff_file(fname))
+    return open_qa_tiff_sds(fname, sds_info);
+  return open_sds(fname, sds_info, 'R');
+}
+
+static int read_qa_rows(sds_t *sds_info, sds_block_t *blk, int row, void *data)
+/*
+ * Read one row of a QA operand, through its read block for an SDS or
+ * through libtiff for a GeoTIFF band.
+ */
+{
+  if (sds_info->sd_id == QA_TIFF_SD_ID)
+    return read_qa_tiff_row(qa_tiff[sds_info->sds_id], row, data);
+  return read_sds_block_rows(blk, row, 1, data);
+}
+
 int get_mask_string(char *m_str, char **arg_mask_str, int *val_opt, int *l2g_st)
 
 /*
@@ -223,7 +322,9 @@ int check_fsds_bit_str_val(char *fname, char *sname, char *bit_str, int *opt, in
 
   meta_cnt = 0;
   /* len = (int)strlen(fname); */
-  if ((ametadata = get_attr_metadata(fname, "ArchiveMetadata.0")) != NULL)
+  if (is_tiff_file(fname))
+    ametadata = NULL;
+  else if ((ametadata = get_attr_metadata(fname, "ArchiveMetadata.0")) != NULL)
   {
     strcpy(meta_name, "NUMBEROFOVERLAPGRANULES");
     get_sel_metadata(ametadata, meta_name, meta_val, &meta_cnt, 0);
@@ -250,7 +351,11 @@ int check_fsds_bit_str_val(char *fname, char *sname, char *bit_str, int *opt, in
     }
   }
   sds_info.sd_id = sds_info.sds_id = -1;
-  if ((st = get_sds_info(fname, &sds_info)) != -1)
+  if (is_tiff_file(fname))
+    st = open_qa_tiff_sds(fname, &sds_info);
+  else
+    st = get_sds_info(fname, &sds_info);
+  if (st != -1)
   {
     sz = 8*sds_info.data_size;
     c = bit_str[0];
@@ -262,6 +367,8 @@ int check_fsds_bit_str_val(char *fname, char *sname, char *bit_str, int *opt, in
     }
     else *opt = 1;
   }
+  if (sds_info.sd_id == QA_TIFF_SD_ID)
+    close_qa_tiff_sds(&sds_info);
   if (sds_info.sds_id != -1) SDendaccess(sds_info.sds_id);
   if (sds_info.sd_id != -1) SDend(sds_info.sd_id);
   return st;
@@ -667,7 +774,7 @@ int open_qa_sds(char *fname, sds_t *sds_info, char **qa_fnames, sds_t *qa_sds_in
 	}
         if (j >= i)
         {
-          if (open_sds(qa_fnames[i], &qa_sds_info[i], 'R') == -1)
+          if (open_qa_operand(qa_fnames[i], &qa_sds_info[i]) == -1)
           {
             status = -1;
             if (qa_sds_info[i].sds_id != -1) SDendaccess(qa_sds_info[i].sds_id);
@@ -693,7 +800,7 @@ int open_qa_sds(char *fname, sds_t *sds_info, char **qa_fnames, sds_t *qa_sds_in
       }
       if (j >= i)
       {
-        if (open_sds(qa_fnames[i], &qa_sds_info[i], 'R') == -1)
+        if (open_qa_operand(qa_fnames[i], &qa_sds_info[i]) == -1)
         {
           status = -1;
           if (qa_sds_info[i].sds_id != -1) SDendaccess(qa_sds_info[i].sds_id);
@@ -827,7 +934,7 @@ int open_qa_sds_nsds(char *fname, sds_t *sds_info, sds_t *sdsc_info, sds_t *sds_
       }
       if (j >= i)
       {
-        if (open_sds(qa_fnames[i], &qa_sds_info[i], 'R') == -1)
+        if (open_qa_operand(qa_fnames[i], &qa_sds_info[i]) == -1)
         {
           status = -1;
           if (qa_sds_info[i].sds_id != -1) SDendaccess(qa_sds_info[i].sds_id);
@@ -851,33 +958,56 @@ int open_qa_sds_nsds(char *fname, sds_t *sds_info, sds_t *sdsc_info, sds_t *sds_
   return status;
 }
 
-void read_qa_sds(sds_t *qa_sds_info, sds_t *qa_sdsc_info, sds_t *qa_sds_nobs_info, int n_op, void **data_qa, int32 **data_qa_nadd, int irow, int *res_l, int *fqa_l2g, int *obs_num)
+int open_qa_sds_blocks(sds_t *qa_sds_info, int n_op, sds_block_t *qa_blk, long mem_size)
+/*
+ * Open a read block on each distinct QA SDS. Operands sharing an SDS with
+ * an earlier operand use the block of that operand, and operands whose SDS
+ * could not be opened get no buffer, as do GeoTIFF operands, which buffer
+ * their own rows. Return 1 on success and -1 on failure.
+ */
 {
-  int i, j, k, rank;
-  int32 edge[4] = {0, 0, 0, 0};
-  int32 start[4] = {0, 0, 0, 0};
+  int i, j;
 
-  rank = qa_sds_info[0].rank;
-  for (i=0; i<rank; i++)
-    edge[i] = qa_sds_info[0].dim_size[i];
-
-  if ((rank == 2) || (qa_sds_info[0].dim_size[0] > qa_sds_info[0].dim_size[rank-1]))
-  { 
-    start[0] = irow/res_l[0]; edge[0] = 1; 
+  for (i=0; i<=n_op; i++)
+  {
+    qa_blk[i].buf = NULL;
+    qa_blk[i].mode = 'R';
+    qa_blk[i].first_row = -1;
   }
-  else 
-  { 
-    start[rank-2] = irow/res_l[0]; edge[rank-2] = 1; 
-  } 
-  if ((fqa_l2g[0] == 0) || (obs_num[0] == 1))
+  for (i=0; i<=n_op; i++)
   {
-    if (SDreaddata(qa_sds_info[0].sds_id, start, NULL, edge, data_qa[0]) == FAIL)
-      fprintf(stderr, "Cannot read data line from SDS %s in mask_sds_lib:read_qa_sds()\n", 
-		qa_sds_info[0].name);
+    for (j=0; j<i; j++)
+      if ((qa_sds_info[i].sd_id == qa_sds_info[j].sd_id) &&
+		(qa_sds_info[i].sds_id == qa_sds_info[j].sds_id))
+        break;
+    if ((j >= i) && (qa_sds_info[i].sds_id != -1) &&
+		(qa_sds_info[i].sd_id != QA_TIFF_SD_ID) &&
+		(open_sds_block(&qa_sds_info[i], &qa_blk[i], 'R', 1, mem_size) == -1))
+    {
+      close_qa_sds_blocks(qa_blk, n_op);
+      return -1;
+    }
   }
+  return 1;
+}
+
+void close_qa_sds_blocks(sds_block_t *qa_blk, int n_op)
+{
+  int i;
+
+  for (i=0; i<=n_op; i++)
+    close_sds_block(&qa_blk[i]);
+}
+
+void read_qa_sds(sds_t *qa_sds_info, sds_t *qa_sdsc_info, sds_t *qa_sds_nobs_info, sds_block_t *qa_blk, int n_op, void **data_qa, int32 **data_qa_nadd, int irow, int *res_l, int *fqa_l2g, int *obs_num)
+{
+  int i, j;
+
+  if ((fqa_l2g[0] == 0) || (obs_num[0] == 1))
+    read_qa_rows(&qa_sds_info[0], &qa_blk[0], irow/res_l[0], data_qa[0]);
   else
     read_sdsc_data(&qa_sdsc_info[0], &qa_sds_nobs_info[0], data_qa[0], data_qa_nadd[0], 
-		start[0], obs_num[0]);
+		irow/res_l[0], obs_num[0]);
 
   for (i=1; i<=n_op; i++)
   {
@@ -890,14 +1020,10 @@ void read_qa_sds(sds_t *qa_sds_info, sds_t *qa_sdsc_info, sds_t *qa_sds_nobs_inf
 	else 
         {
 	  if (obs_num[i] == 1)
-	  {
-	    if (SDreaddata(qa_sds_info[i].sds_id, start, NULL, edge, data_qa[i]) == FAIL)
-      	      fprintf(stderr, "Cannot read data line from SDS %s in mask_sds_lib:read_qa_sds()\n", 
-			qa_sds_info[i].name);
-	  }
+	    read_qa_rows(&qa_sds_info[j], &qa_blk[j], irow/res_l[0], data_qa[i]);
 	  else
 	    read_sdsc_data(&qa_sdsc_info[i], &qa_sds_nobs_info[i], data_qa[i], data_qa_nadd[i], 
-                start[0], obs_num[i]);
+                irow/res_l[0], obs_num[i]);
 	}
 	break;
       }
@@ -906,28 +1032,11 @@ void read_qa_sds(sds_t *qa_sds_info, sds_t *qa_sdsc_info, sds_t *qa_sds_nobs_inf
     {
       if ((res_l[i] == 1) || (irow%res_l[i] == 0))
       {
-        rank = qa_sds_info[i].rank;
-        for (k=0; k<4; k++)
-          start[k] = edge[k] = 0;
-        for (k=0; k<rank; k++)
-          edge[k] = qa_sds_info[i].dim_size[k];
-        if ((rank == 2) || (qa_sds_info[i].dim_size[0] > qa_sds_info[i].dim_size[rank-1]))
-        { 
-          start[0] = irow/res_l[i]; edge[0] = 1;
-        }
-        else
-        { 
-          start[rank-2] = irow/res_l[i]; edge[rank-2] = 1;
-        }
         if ((fqa_l2g[i] == 0) || (obs_num[i] == 1))
-        {
-          if (SDreaddata(qa_sds_info[i].sds_id, start, NULL, edge, data_qa[i]) == FAIL)
-            fprintf(stderr, "Cannot read data line from SDS %s in mask_sds_lib:read_qa_sds()\n", 
-                      qa_sds_info[i].name);
-        }
+          read_qa_rows(&qa_sds_info[i], &qa_blk[i], irow/res_l[i], data_qa[i]);
         else
           read_sdsc_data(&qa_sdsc_info[i], &qa_sds_nobs_info[i], data_qa[i], data_qa_nadd[i],
-                      start[0], obs_num[i]);
+                      irow/res_l[i], obs_num[i]);
       }
     }
   } /* for (i=1; . . . ) */
@@ -1019,6 +1128,11 @@ void close_qa_hdf(char *hdf_fname, sds_t *sds_info, char **qa_fnames, sds_t *qa_
 
   for (i=0; i<=n_op; i++)
   {
+    if (qa_sds_info[i].sd_id == QA_TIFF_SD_ID)
+    {
+      close_qa_tiff_sds(&qa_sds_info[i]);
+      continue;
+    }
     if ((p1 = sd_charpos(qa_sds_info[i].name, '.', 0)) == -1)
       strcpy(sdsi_name, qa_sds_info[i].name);
     else sd_strmid(qa_sds_info[i].name, 0, p1, sdsi_name);
@@ -1066,6 +1180,11 @@ void close_qa_hdf_nsds(char *hdf_fname, sds_t *sds_info, int nsds, char **qa_fna
 
   for (i=0; i<=n_op; i++)
   {
+    if (qa_sds_info[i].sd_id == QA_TIFF_SD_ID)
+    {
+      close_qa_tiff_sds(&qa_sds_info[i]);
+      continue;
+    }
     if ((p1 = sd_charpos(qa_sds_info[i].name, '.', 0)) == -1)
       strcpy(sdsi_name, qa_sds_info[i].name);
     else sd_strmid(qa_sds_info[i].name, 0, p1, sdsi_name);
@@ -1120,6 +1239,263 @@ void close_qa_hdf_nsds(char *hdf_fname, sds_t *sds_info, int nsds, char **qa_fna
   }
 }
 
+static int is_qa_sliceable(sds_t *qa_sds_info, int n_op, unsigned long *bit_mask_arr,
+	unsigned long *mask_val_arr)
+/*
+ * Return 1 if every operand is an 8 or 16-bit SDS whose bit mask and value
+ * are within its bits, so the mask can be evaluated on bitplanes.
+ */
+{
+  int i_op;
+  unsigned long max_val;
+
+  for (i_op=0; i_op<=n_op; i_op++)
+  {
+    switch(qa_sds_info[i_op].data_type)
+    {
+      case 20: case 21: max_val = 0xff; break;
+      case 22: case 23: max_val = 0xffff; break;
+      default: return 0;
+    }
+    if ((bit_mask_arr[i_op] > max_val) || (mask_val_arr[i_op] > max_val))
+      return 0;
+  }
+  return 1;
+}
+
+static qa_word_t transpose_qa_bits(qa_word_t x)
+/*
+ * Transpose the 8x8 bit matrix held in x, byte k being row k: bit b of byte
+ * k goes to bit k of byte b.
+ */
+{
+  qa_word_t t;
+
+  t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+  x ^= t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+  x ^= t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+  x ^= t ^ (t << 28);
+  return x;
+}
+
+static void transpose_qa_bytes(qa_word_t *w)
+/*
+ * Transpose the 8x8 byte matrix held in w[0..7], w[k] being row k: byte b
+ * of w[k] goes to byte k of w[b].
+ */
+{
+  int k;
+  qa_word_t t;
+
+  for (k=0; k<4; k++)
+  {
+    t = ((w[k] >> 32) ^ w[k+4]) & 0x00000000FFFFFFFFULL;
+    w[k] ^= t << 32;
+    w[k+4] ^= t;
+  }
+  for (k=0; k<6; k+=(k == 1) ? 3 : 1)
+  {
+    t = ((w[k] >> 16) ^ w[k+2]) & 0x0000FFFF0000FFFFULL;
+    w[k] ^= t << 16;
+    w[k+2] ^= t;
+  }
+  for (k=0; k<8; k+=2)
+  {
+    t = ((w[k] >> 8) ^ w[k+1]) & 0x00FF00FF00FF00FFULL;
+    w[k] ^= t << 8;
+    w[k+1] ^= t;
+  }
+}
+
+static long get_qa_fill_bits(sds_t *sds_info)
+/*
+ * Return the fill value of an 8 or 16-bit operand as the bits of a sample,
+ * or -1 if no sample can be fill.
+ */
+{
+  long fill_bits = sds_info->fill_val;
+
+  switch(sds_info->data_type)
+  {
+    case 20: return ((fill_bits < -128) || (fill_bits > 127)) ? -1 : (uint8)fill_bits;
+    case 21: return (uint8)fill_bits;
+    case 22: return ((fill_bits < -32768) || (fill_bits > 32767)) ? -1 : (uint16)fill_bits;
+    case 23: return (uint16)fill_bits;
+  }
+  return -1;
+}
+
+static void slice_qa_pixels(sds_t *sds_info, long fill_bits, void *data, int *j, int offset,
+	int res_s, int npix, qa_word_t *plane, qa_word_t *fill)
+/*
+ * Transpose npix pixels of a QA row, from element *j on, into bitplanes: bit
+ * k of plane[b] is bit b of pixel k. Each byte of the samples is transposed
+ * as 8x8 bit matrices of 8 pixels, then as an 8x8 byte matrix across the
+ * pixel groups. Bit k of fill is set if pixel k is the fill value. *j is
+ * advanced past the pixels.
+ */
+{
+  int k, b, g, h, nbits;
+  uint16 val[QA_WORD_NPIX];
+  qa_word_t w[8], x;
+
+  /* gather the pixels, without a division each when they follow each other */
+  nbits = ((sds_info->data_type == 20) || (sds_info->data_type == 21)) ? 8 : 16;
+  if ((offset == 1) && (res_s == 1))
+  {
+    if (nbits == 8)
+      for (k=0; k<npix; k++)
+	val[k] = ((uint8 *)data)[*j + k];
+    else
+      for (k=0; k<npix; k++)
+	val[k] = ((uint16 *)data)[*j + k];
+    *j += npix;
+  }
+  else if (nbits == 8)
+    for (k=0; k<npix; k++, *j += offset)
+      val[k] = ((uint8 *)data)[*j/res_s];
+  else
+    for (k=0; k<npix; k++, *j += offset)
+      val[k] = ((uint16 *)data)[*j/res_s];
+  for (k=npix; k<QA_WORD_NPIX; k++)
+    val[k] = 0;
+
+  for (h=0; h<nbits/8; h++)
+  {
+    for (g=0; g<8; g++)
+    {
+      x = 0;
+      for (k=0; k<8; k++)
+	x |= (qa_word_t)((val[8*g+k] >> (8*h)) & 0xff) << (8*k);
+      w[g] = transpose_qa_bits(x);
+    }
+    transpose_qa_bytes(w);
+    for (b=0; b<8; b++)
+      plane[8*h+b] = w[b];
+  }
+  for (b=nbits; b<QA_SLICE_NBITS; b++)
+    plane[b] = 0;
+
+  x = 0;
+  if (fill_bits != -1)
+    for (b=0, x=~(qa_word_t)0; b<nbits; b++)
+      x &= ((fill_bits >> b) & 1) ? plane[b] : ~plane[b];
+  *fill = x;
+}
+
+static qa_word_t spread_qa_bits(unsigned int x)
+/*
+ * Spread the 8 bits of x to the low bit of each byte: bit k to byte k.
+ */
+{
+  qa_word_t w = x & 0xff;
+
+  w = (w | (w << 28)) & 0x0000000F0000000FULL;
+  w = (w | (w << 14)) & 0x0003000300030003ULL;
+  w = (w | (w << 7)) & 0x0101010101010101ULL;
+  return w;
+}
+
+static qa_word_t eval_qa_planes(qa_word_t *plane, unsigned long bit_mask, unsigned long mask_val,
+	int rel_op)
+/*
+ * Compare the masked value of each pixel of the bitplanes with mask_val,
+ * from the most significant bit down, and return the word of the pixels
+ * for which the relation holds.
+ */
+{
+  int b;
+  qa_word_t p, eq, lt, gt;
+
+  eq = ~(qa_word_t)0;
+  lt = gt = 0;
+  for (b=QA_SLICE_NBITS-1; b>=0; b--)
+  {
+    if (((bit_mask | mask_val) & BIT[b]) == 0)
+      continue;
+    p = (bit_mask & BIT[b]) ? plane[b] : 0;
+    if (mask_val & BIT[b]) { lt |= eq & ~p; eq &= p; }
+    else { gt |= eq & p; eq &= ~p; }
+  }
+  switch(rel_op)
+  {
+    case 0: return eq;
+    case 1: return lt;
+    case 2: return gt;
+    case 3: return lt | eq;
+    case 4: return gt | eq;
+    case 5: return ~eq;
+  }
+  return 0;
+}
+
+static void process_mask_data_sliced(void **data_qa, int ncols, sds_t *qa_sds_info, int n_op,
+	int *sel_qa_op, unsigned long *bit_mask_arr, unsigned long *mask_val_arr, int *rel_op,
+	int *res_s, int *j, int *offset, uint8 *mask_row, int on_val, int off_val, int mask_fill)
+/*
+ * Same as process_mask_data, QA_WORD_NPIX pixels at a time on the bitplanes
+ * of the operands. Operands reading the same pixels of the same row share
+ * their bitplanes. The mask is written 8 pixels at a time, each byte of a
+ * word holding one pixel.
+ */
+{
+  int i, k, g, n, npix, i_op, k_op;
+  int src[MAX_NUM_OP];
+  long fill_bits[MAX_NUM_OP];
+  qa_word_t plane[MAX_NUM_OP][QA_SLICE_NBITS], fill[MAX_NUM_OP];
+  qa_word_t sel, fill_fin, sel_fin, s, f, ones, out;
+
+  for (i_op=0; i_op<=n_op; i_op++)
+  {
+    fill_bits[i_op] = get_qa_fill_bits(&qa_sds_info[i_op]);
+    for (k_op=0; k_op<i_op; k_op++)
+      if ((data_qa[k_op] == data_qa[i_op]) && (j[k_op] == j[i_op]) &&
+	  (offset[k_op] == offset[i_op]) && (res_s[k_op] == res_s[i_op]) &&
+	  (qa_sds_info[k_op].data_type == qa_sds_info[i_op].data_type) &&
+	  (fill_bits[k_op] == fill_bits[i_op]))
+	break;
+    src[i_op] = (k_op < i_op) ? src[k_op] : i_op;
+  }
+
+  ones = 0x0101010101010101ULL;
+  for (i=0; i<ncols; i+=QA_WORD_NPIX)
+  {
+    npix = (ncols - i < QA_WORD_NPIX) ? ncols - i : QA_WORD_NPIX;
+    for (i_op=0; i_op<=n_op; i_op++)
+      if (src[i_op] == i_op)
+	slice_qa_pixels(&qa_sds_info[i_op], fill_bits[i_op], data_qa[i_op], &j[i_op],
+			offset[i_op], res_s[i_op], npix, plane[i_op], &fill[i_op]);
+
+    fill_fin = fill[0];
+    sel_fin = eval_qa_planes(plane[0], bit_mask_arr[0], mask_val_arr[0], rel_op[0]);
+    for (i_op=1; i_op<=n_op; i_op++)
+    {
+      fill_fin |= fill[src[i_op]];
+      sel = eval_qa_planes(plane[src[i_op]], bit_mask_arr[i_op], mask_val_arr[i_op], rel_op[i_op]);
+      if (sel_qa_op[i_op-1] == 1) sel_fin &= sel;
+      else if (sel_qa_op[i_op-1] == 2) sel_fin |= sel;
+    }
+
+    /* each byte of out is the mask of one pixel: the fill, ON or OFF value */
+    for (g=0; g<npix; g+=8)
+    {
+      s = spread_qa_bits((unsigned int)(sel_fin >> g));
+      f = spread_qa_bits((unsigned int)(fill_fin >> g));
+      out = (f*(uint8)mask_fill) | (~(f*0xff) & ((s*(uint8)on_val) | ((s ^ ones)*(uint8)off_val)));
+      n = (npix - g < 8) ? npix - g : 8;
+      for (k=0; k<n; k++)
+	mask_row[i+g+k] = (uint8)(out >> (8*k));
+    }
+  }
+}
+
+void set_qa_sliced(int sliced)
+{
+  qa_sliced = sliced;
+}
+
 void process_mask_data(void **data_qa, int ncols, sds_t *qa_sds_info, int n_op, int *sel_qa_op, 
 	unsigned long *bit_mask_arr, unsigned long *mask_val_arr, int *rel_op, int *res_s, 
 	uint8 *mask_row, int on_val, int off_val, int mask_fill)
@@ -1139,6 +1515,16 @@ void process_mask_data(void **data_qa, int ncols, sds_t *qa_sds_info, int n_op,
     compute_sds_start_offset(&qa_sds_info[i_op], n, m, &j[i_op], &offset[i_op]);
   }
 
+  /* With -sliced, 8 and 16-bit QA is evaluated on bitplanes, a word of
+     pixels at a time */
+  if (qa_sliced && is_qa_sliceable(qa_sds_info, n_op, bit_mask_arr, mask_val_arr))
+  {
+    process_mask_data_sliced(data_qa, ncols, qa_sds_info, n_op, sel_qa_op, bit_mask_arr,
+			     mask_val_arr, rel_op, res_s, j, offset, mask_row, on_val, off_val,
+			     mask_fill);
+    return;
+  }
+
   for (i=0; i<ncols; i++)
   {
     mask_st = 1;
@@ -1270,6 +1656,16 @@ int get_qa_sds_info(char **fnames, sds_t *sds_info, sds_t *sdsc_info, int *l2g_s
   for (i_op=0; i_op<=n_op; i_op++)
   {
     sds_info[i_op].sd_id = sds_info[i_op].sds_id = -1;
+    if (is_tiff_file(fnames[i_op]))
+    {
+      if (open_qa_tiff_sds(fnames[i_op], &sds_info[i_op]) == -1)
+      {
+        st = -1;
+        break;
+      }
+      close_qa_tiff_sds(&sds_info[i_op]);
+      continue;
+    }
     if (get_sds_info(fnames[i_op], &sds_info[i_op]) == -1)
     {
       if (sds_info[i_op].sds_id != -1) SDendaccess(sds_info[i_op].sds_id);
@@ -47,6 +47,13 @@
 !END
 *****************************************************************************/
 
+/* Help of the -sliced option of the mask tools, pad following the option
+   name up to the column of the descriptions, indented by indent */
+#define QA_SLICED_HELP(pad, indent) \
+"    -sliced" pad "Evaluate the masks of 8 and 16-bit SDSs on\n" \
+indent "bitplanes, 64 pixels at a time. Fastest when\n" \
+indent "several masks test the same SDS.\n"
+
 int get_mask_string(char *m_str, char **arg_mask_str, int *val_opt, int *l2g_st);
 int check_fsds_bit_str_val(char *fname, char *sname, char *bit_str, int *opt, 
 			   int *l2g_st);
@@ -64,8 +71,10 @@ int open_qa_sds_nsds(char *fname, sds_t *sds_info, sds_t *sdsc_info,
 		     sds_t *qa_sds_nobs_info, int *qa_l2g, int n_op);
 int malloc_qa_sds(sds_t *qa_sds_info, int n_op, int *fqa_l2g, void **data_qa,
 		  int32 **data_qa_nadd);
+int open_qa_sds_blocks(sds_t *qa_sds_info, int n_op, sds_block_t *qa_blk, long mem_size);
+void close_qa_sds_blocks(sds_block_t *qa_blk, int n_op);
 void read_qa_sds(sds_t *qa_sds_info, sds_t *qa_sdsc_info, sds_t *qa_sds_nobs_info, 
-		 int n_op, void **data_qa, int32 **data_qa_nadd, int irow, int *res_l, 
+		 sds_block_t *qa_blk, int n_op, void **data_qa, int32 **data_qa_nadd, int irow, int *res_l, 
 		 int *fqa_l2g, int *obs_num);
 void read_sdsc_data(sds_t *sdsc_info, sds_t *sds_nobs_info, void *data, 
 		    int32 *data_nadd, int irow, int nobs);
@@ -77,6 +86,7 @@ void process_mask_data(void **data_qa, int ncols, sds_t *qa_sds_info, int n_op,
 		       int *sel_qa_op, unsigned long *bit_mask_arr, 
 		       unsigned long *mask_val_arr, int *rel_op, int *res_s, 
 		       uint8 *mask_row, int on_val, int off_val, int mask_fill);
+void set_qa_sliced(int sliced);
 int get_qa_sds_info(char **fnames, sds_t *sds_info, sds_t *sdsc_info, int *l2g_st, 
 		    int n_op);
 int get_in_sds_info(char *hdf_fname, sds_t *sds_info, sds_t *sdsc_info, 
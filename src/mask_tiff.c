@@ -0,0 +1,367 @@
+/***************************************************************************
+!C
+
+!File: mask_tiff.c
+
+!Description:
+  This file contains the library routines for reading a band of a GeoTIFF
+  file, such as a Landsat QA band, as a QA operand of a mask.
+
+!Input Parameters: (none)
+
+!Output Parameters: (none)
+
+!Revision History:
+
+    Version 1.0    October, 2026
+
+!Design Notes:
+
+  The band is read row by row. The strip, or the row of tiles, holding the
+  row is decoded once into a buffer of whole rows and the following rows are
+  copied from it, so each strip or tile is decoded once when the rows are
+  read in order.
+
+!END
+*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tiffio.h"
+#include "mask_tiff.h"
+
+#ifndef TIFFTAG_GDAL_NODATA
+#define TIFFTAG_GDAL_NODATA 42113
+#endif
+
+struct qa_tiff_s
+{
+  TIFF *tif;
+  char *fname;
+  int band;              /* band read, counted from 0 */
+  int nrows, ncols;      /* rows and columns of the band */
+  int nbits;             /* bits per sample: 8, 16 or 32 */
+  int is_signed;         /* the samples are signed integers */
+  int has_fill;          /* the fill value is known */
+  long fill;             /* fill value of the band */
+  int nsamp;             /* samples of each pixel held in buf */
+  int tiled;             /* the file is tiled, otherwise it is in strips */
+  uint32 block_nrows;    /* rows in one strip or one row of tiles */
+  uint32 tile_ncols;     /* columns in one tile */
+  int first_row;         /* first row held in buf, -1 if none */
+  int cur_nrows;         /* number of rows held in buf */
+  unsigned char *buf;    /* decoded rows of the strip or row of tiles */
+  unsigned char *tile;   /* one decoded tile */
+};
+
+int is_tiff_file(char *fname)
+/*
+ * Return 1 if the file starts with a TIFF or BigTIFF header and 0 otherwise.
+ */
+{
+  FILE *fp;
+  unsigned char hdr[4];
+  int st = 0;
+
+  if ((fp = fopen(fname, "rb")) == NULL)
+    return 0;
+  if (fread(hdr, 1, 4, fp) == 4)
+  {
+    if ((hdr[0] == 'I') && (hdr[1] == 'I') && (hdr[3] == 0) &&
+		((hdr[2] == 42) || (hdr[2] == 43)))
+      st = 1;
+    else if ((hdr[0] == 'M') && (hdr[1] == 'M') && (hdr[2] == 0) &&
+		((hdr[3] == 42) || (hdr[3] == 43)))
+      st = 1;
+  }
+  fclose(fp);
+  return st;
+}
+
+static int get_qa_tiff_band(char *band_name, int *has_fill, long *fill)
+/*
+ * Return the band, counted from 0, named band1, band2, ... or 1, 2, ...
+ * optionally followed by :<fill value>, and -1 if the name is not of this
+ * form. has_fill is set if the name gives the fill value.
+ */
+{
+  char *p, *start;
+  long band;
+
+  *has_fill = 0;
+  p = band_name;
+  if (strncmp(p, "band", 4) == 0)
+    p += 4;
+  if ((*p < '1') || (*p > '9'))
+    return -1;
+  band = strtol(p, &p, 10);
+  if (band > 65535)
+    return -1;
+  if (*p == ':')
+  {
+    start = p + 1;
+    *fill = strtol(start, &p, 0);
+    if (p == start)
+      return -1;
+    *has_fill = 1;
+  }
+  if (*p != '\0')
+    return -1;
+  return (int)band - 1;
+}
+
+static int get_gdal_nodata(TIFF *tif, double *fill)
+/*
+ * Get the fill value from the GDAL_NODATA tag of the file. Return 1 if the
+ * tag holds an integer and 0 if it is missing or holds another value.
+ */
+{
+  char *str, *end;
+  double val;
+
+  if ((TIFFGetField(tif, TIFFTAG_GDAL_NODATA, &str) != 1) || (str == NULL))
+    return 0;
+  val = strtod(str, &end);
+  while ((*end == ' ') || (*end == '\n')) end++;
+  if ((end == str) || (*end != '\0') || (val < -2147483648.0) ||
+	(val > 4294967295.0) || (val != (double)(long long)val))
+    return 0;
+  *fill = val;
+  return 1;
+}
+
+qa_tiff_t *open_qa_tiff(char *fname, char *band_name)
+/*
+ * Open a band of a GeoTIFF file for reading it row by row. Return NULL if
+ * the file can't be opened or the band is not an 8, 16 or 32-bit integer
+ * band of the file.
+ */
+{
+  qa_tiff_t *qt;
+  uint16 spp, bps, fmt, planar;
+  uint32 nrows, ncols, rps, tile_nrows, tile_ncols;
+  tsize_t buf_size;
+  int band_has_fill, has_fill;
+  long band_fill;
+  double fill, max;
+
+  if ((qt = (qa_tiff_t *)calloc(1, sizeof(qa_tiff_t))) == NULL)
+  {
+    fprintf(stderr, "Cannot allocate memory for the GeoTIFF band of %s in open_qa_tiff\n",
+	    fname);
+    return NULL;
+  }
+  qt->first_row = -1;
+  if ((qt->fname = strdup(fname)) == NULL)
+  {
+    fprintf(stderr, "Cannot allocate memory for the GeoTIFF band of %s in open_qa_tiff\n",
+	    fname);
+    close_qa_tiff(qt);
+    return NULL;
+  }
+  if ((qt->band = get_qa_tiff_band(band_name, &band_has_fill, &band_fill)) == -1)
+  {
+    fprintf(stderr, "Invalid band %s of GeoTIFF file %s in open_qa_tiff, expecting band1, band2, ... or band1:<fill value>, ...\n",
+	    band_name, fname);
+    close_qa_tiff(qt);
+    return NULL;
+  }
+  if ((qt->tif = TIFFOpen(fname, "r")) == NULL)
+  {
+    fprintf(stderr, "Cannot open GeoTIFF file %s in open_qa_tiff\n", fname);
+    close_qa_tiff(qt);
+    return NULL;
+  }
+
+  TIFFGetField(qt->tif, TIFFTAG_IMAGELENGTH, &nrows);
+  TIFFGetField(qt->tif, TIFFTAG_IMAGEWIDTH, &ncols);
+  TIFFGetFieldDefaulted(qt->tif, TIFFTAG_SAMPLESPERPIXEL, &spp);
+  TIFFGetFieldDefaulted(qt->tif, TIFFTAG_BITSPERSAMPLE, &bps);
+  TIFFGetFieldDefaulted(qt->tif, TIFFTAG_SAMPLEFORMAT, &fmt);
+  TIFFGetFieldDefaulted(qt->tif, TIFFTAG_PLANARCONFIG, &planar);
+  if (qt->band >= spp)
+  {
+    fprintf(stderr, "GeoTIFF file %s has no band %s in open_qa_tiff\n", fname, band_name);
+    close_qa_tiff(qt);
+    return NULL;
+  }
+  if (((bps != 8) && (bps != 16) && (bps != 32)) ||
+	((fmt != SAMPLEFORMAT_UINT) && (fmt != SAMPLEFORMAT_INT)))
+  {
+    fprintf(stderr, "GeoTIFF file %s is not of 8, 16 or 32-bit integers in open_qa_tiff\n",
+	    fname);
+    close_qa_tiff(qt);
+    return NULL;
+  }
+  qt->nrows = (int)nrows;
+  qt->ncols = (int)ncols;
+  qt->nbits = bps;
+  qt->is_signed = (fmt == SAMPLEFORMAT_INT) ? 1 : 0;
+  qt->nsamp = (planar == PLANARCONFIG_CONTIG) ? spp : 1;
+
+  /* A fill value given with the band overrides the GDAL_NODATA tag. A tag
+     value the band can't hold is ignored. */
+  if (band_has_fill)
+    fill = (double)band_fill;
+  has_fill = band_has_fill || get_gdal_nodata(qt->tif, &fill);
+  max = (bps == 8) ? 255.0 : (bps == 16) ? 65535.0 : 4294967295.0;
+  if (qt->is_signed) max = (max - 1.0)/2.0;
+  if (has_fill && (fill >= ((qt->is_signed) ? -max - 1.0 : 0.0)) && (fill <= max))
+  {
+    qt->has_fill = 1;
+    qt->fill = (fill > 2147483647.0) ? (long)(unsigned long)fill : (long)fill;
+  }
+  else if (band_has_fill)
+  {
+    fprintf(stderr, "Fill value %ld of GeoTIFF file %s is out of the range of band %s in open_qa_tiff\n",
+	    band_fill, fname, band_name);
+    close_qa_tiff(qt);
+    return NULL;
+  }
+
+  /* The buffer holds whole rows of the strip, or of the row of tiles */
+  qt->tiled = TIFFIsTiled(qt->tif);
+  if (qt->tiled)
+  {
+    TIFFGetField(qt->tif, TIFFTAG_TILELENGTH, &tile_nrows);
+    TIFFGetField(qt->tif, TIFFTAG_TILEWIDTH, &tile_ncols);
+    qt->block_nrows = tile_nrows;
+    qt->tile_ncols = tile_ncols;
+    buf_size = (tsize_t)tile_nrows*ncols*qt->nsamp*(bps/8);
+    qt->tile = (unsigned char *)_TIFFmalloc(TIFFTileSize(qt->tif));
+  }
+  else
+  {
+    TIFFGetFieldDefaulted(qt->tif, TIFFTAG_ROWSPERSTRIP, &rps);
+    qt->block_nrows = (rps < nrows) ? rps : nrows;
+    buf_size = TIFFStripSize(qt->tif);
+  }
+  qt->buf = (unsigned char *)_TIFFmalloc(buf_size);
+  if ((qt->buf == NULL) || (qt->tiled && (qt->tile == NULL)))
+  {
+    fprintf(stderr, "Cannot allocate memory for the rows of GeoTIFF file %s in open_qa_tiff\n",
+	    fname);
+    close_qa_tiff(qt);
+    return NULL;
+  }
+  return qt;
+}
+
+void get_qa_tiff_info(qa_tiff_t *qt, int *nrows, int *ncols, int *nbits, int *is_signed)
+{
+  *nrows = qt->nrows;
+  *ncols = qt->ncols;
+  *nbits = qt->nbits;
+  *is_signed = qt->is_signed;
+}
+
+int get_qa_tiff_fill(qa_tiff_t *qt, long *fill)
+/*
+ * Get the fill value of the band. Return 1 if it is known, from the band
+ * name or the GDAL_NODATA tag, and 0 otherwise.
+ */
+{
+  if (qt->has_fill)
+    *fill = qt->fill;
+  return qt->has_fill;
+}
+
+static int load_qa_tiff_rows(qa_tiff_t *qt, int row)
+/*
+ * Decode the strip, or the row of tiles, holding the row into the buffer.
+ * Return 1 on success and -1 on failure.
+ */
+{
+  uint32 col, ncols_copy;
+  int ir;
+  tsize_t row_size, tile_row_size;
+  tstrip_t strip;
+  ttile_t tile;
+  uint16 sample;
+
+  qt->first_row = -1;
+  qt->cur_nrows = 0;
+  row = row - row%qt->block_nrows;
+  sample = (qt->nsamp == 1) ? (uint16)qt->band : 0;
+  if (!qt->tiled)
+  {
+    strip = TIFFComputeStrip(qt->tif, row, sample);
+    if (TIFFReadEncodedStrip(qt->tif, strip, qt->buf, (tsize_t)-1) == -1)
+    {
+      fprintf(stderr, "Cannot read strip %lu of GeoTIFF file %s in load_qa_tiff_rows\n",
+	      (unsigned long)strip, qt->fname);
+      return -1;
+    }
+  }
+  else
+  {
+    row_size = (tsize_t)qt->ncols*qt->nsamp*(qt->nbits/8);
+    tile_row_size = (tsize_t)qt->tile_ncols*qt->nsamp*(qt->nbits/8);
+    for (col=0; col<(uint32)qt->ncols; col+=qt->tile_ncols)
+    {
+      tile = TIFFComputeTile(qt->tif, col, row, 0, sample);
+      if (TIFFReadEncodedTile(qt->tif, tile, qt->tile, (tsize_t)-1) == -1)
+      {
+        fprintf(stderr, "Cannot read tile %lu of GeoTIFF file %s in load_qa_tiff_rows\n",
+		(unsigned long)tile, qt->fname);
+        return -1;
+      }
+      ncols_copy = qt->ncols - col;
+      if (ncols_copy > qt->tile_ncols) ncols_copy = qt->tile_ncols;
+      for (ir=0; (ir<(int)qt->block_nrows) && (row+ir<qt->nrows); ir++)
+        memcpy(qt->buf + ir*row_size + (tsize_t)col*qt->nsamp*(qt->nbits/8),
+	       qt->tile + ir*tile_row_size, ncols_copy*qt->nsamp*(qt->nbits/8));
+    }
+  }
+  qt->first_row = row;
+  qt->cur_nrows = qt->nrows - row;
+  if (qt->cur_nrows > (int)qt->block_nrows) qt->cur_nrows = (int)qt->block_nrows;
+  return 1;
+}
+
+int read_qa_tiff_row(qa_tiff_t *qt, int row, void *data)
+/*
+ * Read one row of the band into data, as ncols samples of nbits each.
+ * Return 1 on success and -1 on failure.
+ */
+{
+  int ic, nbytes;
+  unsigned char *src, *dst;
+
+  if ((row < 0) || (row >= qt->nrows))
+  {
+    fprintf(stderr, "Row %d out of range for GeoTIFF file %s in read_qa_tiff_row\n",
+	    row, qt->fname);
+    return -1;
+  }
+  if ((qt->first_row == -1) || (row < qt->first_row) ||
+	(row >= qt->first_row + qt->cur_nrows))
+    if (load_qa_tiff_rows(qt, row) == -1)
+      return -1;
+
+  nbytes = qt->nbits/8;
+  src = qt->buf + (tsize_t)(row - qt->first_row)*qt->ncols*qt->nsamp*nbytes;
+  dst = (unsigned char *)data;
+  if (qt->nsamp == 1)
+    memcpy(dst, src, (size_t)qt->ncols*nbytes);
+  else
+  {
+    src += qt->band*nbytes;
+    for (ic=0; ic<qt->ncols; ic++, src+=qt->nsamp*nbytes, dst+=nbytes)
+      memcpy(dst, src, nbytes);
+  }
+  return 1;
+}
+
+void close_qa_tiff(qa_tiff_t *qt)
+{
+  if (qt == NULL)
+    return;
+  if (qt->tif != NULL) TIFFClose(qt->tif);
+  if (qt->buf != NULL) _TIFFfree(qt->buf);
+  if (qt->tile != NULL) _TIFFfree(qt->tile);
+  free(qt->fname);
+  free(qt);
+}
@@ -0,0 +1,45 @@
+/****************************************************************************
+!C
+
+!File: mask_tiff.h
+
+!Description:
+
+  This file contains header file of routines for reading a GeoTIFF band
+  used as a QA operand of a mask.
+
+!Input Parameters: (none)
+
+!Output Parameters: (none)
+
+!Revision History:
+
+    Version 1.0    October, 2026
+
+!Design Notes:
+
+  The band is kept opaque so the HDF tools need not include the libtiff
+  headers, whose integer types clash with those of HDF.
+
+!END
+*****************************************************************************/
+
+#ifndef _MASK_TIFF_H_
+#define _MASK_TIFF_H_
+
+/* Fill value of a band without a GDAL_NODATA tag or a fill value given with
+   the band: that of the Landsat Collection 1 QA bands, only the designated
+   fill bit being set */
+#define QA_TIFF_FILL 1
+
+typedef struct qa_tiff_s qa_tiff_t;
+
+int is_tiff_file(char *fname);
+qa_tiff_t *open_qa_tiff(char *fname, char *band_name);
+void get_qa_tiff_info(qa_tiff_t *qt, int *nrows, int *ncols, int *nbits,
+		      int *is_signed);
+int get_qa_tiff_fill(qa_tiff_t *qt, long *fill);
+int read_qa_tiff_row(qa_tiff_t *qt, int row, void *data);
+void close_qa_tiff(qa_tiff_t *qt);
+
+#endif
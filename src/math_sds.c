@@ -172,6 +172,7 @@
 "                       used in place of the actual value. \n" \
 " \n" \
 "    -of=<filename>     Output filename \n" \
+SDS_COMPRESS_HELP("   ", "                       ") \
 " \n" \
 "Examples: \n" \
 "    math_sds -of=diff_temp.hdf \n" \
@@ -281,6 +282,7 @@
 "                       used in place of the actual value. \n" \
 " \n" \
 "    -of=<filename>     Output filename \n" \
+SDS_COMPRESS_HELP("   ", "                       ") \
 " \n"
 
 #define MAX_NSDS 10
@@ -520,6 +522,7 @@ int parse_cmd_math_sds(int argc, char **argv, char **expr, int *n_op, char *f3)
  ********************************************************************************/
 {
   int i, i_op, st;
+  char comp_str[MAX_STR_LEN];
 
   st = 1;
   *n_op = 0;
@@ -533,6 +536,11 @@ int parse_cmd_math_sds(int argc, char **argv, char **expr, int *n_op, char *f3)
     }
     else if (is_arg_id(argv[i], "-of") == 0)
       get_arg_val(argv[i], f3);
+    else if (is_arg_id(argv[i], "-compress=") == 0)
+    {
+      get_arg_val(argv[i], comp_str);
+      if (set_sds_compress(comp_str) == -1) st = -1;
+    }
     else fprintf(stderr, "Ignoring unknown option %s\n", argv[i]);
   }
   if (strlen(f3) <= 0) {
@@ -685,12 +693,7 @@ void compute_math_sds(sds_t *sds1_info, sds_t *sds2_info, sds_t *sds3_info,
   int dim_sz1[4], dim_sz2[4];
   int ndata1, ndata2, ndata3;
   void *data1, *data2, *data3;
-  int32 edge1[4] = {0, 0, 0, 0};
-  int32 edge2[4] = {0, 0, 0, 0};
-  int32 edge3[4] = {0, 0, 0, 0};
-  int32 start1[4] = {0, 0, 0, 0};
-  int32 start2[4] = {0, 0, 0, 0};
-  int32 start3[4] = {0, 0, 0, 0};
+  sds_block_t blk1, blk2, blk3;
   int fval_st;
   float fval1 = 0.0, fval2 = 0.0;
   double of_ovf, of_nop;
@@ -752,36 +755,23 @@ void compute_math_sds(sds_t *sds1_info, sds_t *sds2_info, sds_t *sds3_info,
       fprintf(stderr, "Cannot allocate memory for data2 in math_sds: compute_math_sds()\n");
     if ((data3 = (void *)calloc(ndata3, sds3_info->data_size)) == NULL)
       fprintf(stderr, "Cannot allocate memory for data3 in math_sds: compute_math_sds()\n");
-    if ((data1 != NULL) && (data2 != NULL) && (data3 != NULL))
+    blk1.buf = blk2.buf = blk3.buf = NULL;
+    if ((data1 != NULL) && (data2 != NULL) && (data3 != NULL) &&
+	(open_sds_block(sds1_info, &blk1, 'R', 1, 0L) != -1) &&
+	(open_sds_block(sds2_info, &blk2, 'R', 1, 0L) != -1) &&
+	(open_sds_block(sds3_info, &blk3, 'W', 1, 0L) != -1))
     {
-      rank1 = sds1_info->rank;
-      rank2 = sds2_info->rank;
-      get_sds_edge(sds1_info, edge1);
-      get_sds_edge(sds2_info, edge2);
-      get_sds_edge(sds3_info, edge3);
       compute_sds_start_offset(sds1_info, n1, m1, &st_c1, &offset1);
       compute_sds_start_offset(sds2_info, n2, m2, &st_c2, &offset2);
       compute_sds_nrows_ncols(sds3_info, &nrows, &ncols);
       for (ir=0; ir<nrows; ir++)
       {
-        if ((rank1 == 2) || (sds1_info->dim_size[0] > sds1_info->dim_size[rank1-1]))
-          start1[0] = (bd == 1) ? ir : ir/sc_dim;
-        else 
-	  start1[rank1-2] = (bd == 1) ? ir : ir/sc_dim;
-        if ((rank2 == 2) || (sds2_info->dim_size[0] > sds2_info->dim_size[rank2-1]))
-          start2[0] = (bd == 2) ? ir : ir/sc_dim;
-        else 
-	  start2[rank2-2] = (bd == 2) ? ir : ir/sc_dim;
-        if ((rank3 == 2) || (sds3_info->dim_size[0] > sds3_info->dim_size[rank3-1]))
-          start3[0] = ir;
-        else 
-	  start3[rank3-2] = ir;
-	if (SDreaddata(sds1_info->sds_id, start1, NULL, edge1, data1) == FAIL)
+	if (read_sds_block_rows(&blk1, (bd == 1) ? ir : ir/sc_dim, 1, data1) == -1)
 	{
 	  fprintf(stderr, "Cannot read dataline from SDS %s in compute_math_sds()\n", sds1_info->name);
 	  break;
 	}
-	if (SDreaddata(sds2_info->sds_id, start2, NULL, edge2, data2) == FAIL)
+	if (read_sds_block_rows(&blk2, (bd == 2) ? ir : ir/sc_dim, 1, data2) == -1)
 	{
 	  fprintf(stderr, "Cannot read dataline from SDS %s in compute_math_sds()\n", sds2_info->name);
 	  break;
@@ -896,14 +886,19 @@ void compute_math_sds(sds_t *sds1_info, sds_t *sds2_info, sds_t *sds3_info,
 	    }
 	  }
         }
-	if (SDwritedata(sds3_info->sds_id, start3, NULL, edge3, data3) == FAIL)
+	if (write_sds_block_rows(&blk3, ir, 1, data3) == -1)
 	{
 	  fprintf(stderr, "Cannot write dataline for SDS %s in compute_math_sds()\n", sds3_info->name);
 	  break;
 	}
       } /* for (ir=0; . . .) */
-      SDendaccess(sds3_info->sds_id);
+      if (close_sds_block(&blk3) == -1)
+	fprintf(stderr, "Cannot write dataline for SDS %s in compute_math_sds()\n", sds3_info->name);
     }
+    if (blk1.buf != NULL) close_sds_block(&blk1);
+    if (blk2.buf != NULL) close_sds_block(&blk2);
+    if (blk3.buf != NULL) close_sds_block(&blk3);
+    SDendaccess(sds3_info->sds_id);
     if (data1 != NULL) free(data1);
     if (data2 != NULL) free(data2);
     if (data3 != NULL) free(data3);
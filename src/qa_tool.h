@@ -37,6 +37,10 @@
 #define MAX_ATTR_NAME_LEN 80 
 #define MAX_NUM_LUT_ENTRY 30000
 #define MAX_NUM_CLR 24
+#define SDS_BLOCK_MEM_SIZE 16777216L
+#define SDS_BLOCK_MEM_TOTAL 268435456L
+#define SDS_CHUNK_MEM_SIZE 1048576L
+#define SDS_DEFLATE_LEVEL 6
 
 #define FILL_VALUE_INT8 -1
 #define FILL_VALUE_UINT8 255
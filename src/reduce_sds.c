@@ -96,6 +96,7 @@
 "                             the names of all the SDS in the file are\n" \
 "                             displayed. \n" \
 "    -of=<filename>           Output filename \n" \
+SDS_COMPRESS_HELP("         ", "                             ") \
 "    -rf=<reduction factor>   Reduction factor (a non-zero positive integer)\n"\
 "    -sub                     Reduce by sub-sampling. Pixel value at (i, j)\n"\
 "                             in the output SDS is copied from the pixel at\n"\
@@ -211,6 +212,7 @@
 "                             the names of all the SDS in the file are\n" \
 "                             displayed. \n" \
 "    -of=<filename>           Output filename \n" \
+SDS_COMPRESS_HELP("         ", "                             ") \
 "    -rf=<reduction factor>   Reduction factor (a non-zero positive integer)\n"\
 "    -sub                     Reduce by sub-sampling. Pixel value at (i, j)\n"\
 "                             in the output SDS is copied from the pixel at\n"\
@@ -492,6 +494,7 @@ int parse_cmd_reduce_sds(int argc, char **argv, char **sds_names, int *sds_cnt,
   int i;
   int if_cnt;
   int status;
+  char comp_str[MAX_STR_LEN];
 
   status = 1;
   if_cnt = *sds_cnt = 0;
@@ -506,6 +509,11 @@ int parse_cmd_reduce_sds(int argc, char **argv, char **sds_names, int *sds_cnt,
     else if (is_arg_id(argv[i], "-sds") == 0) ;
     else if (is_arg_id(argv[i], "-of=") == 0)
       get_arg_val(argv[i], arg_list[0]);
+    else if (is_arg_id(argv[i], "-compress=") == 0)
+    {
+      get_arg_val(argv[i], comp_str);
+      if (set_sds_compress(comp_str) == -1) status = -1;
+    }
     else if (is_arg_id(argv[i], "-rf=") == 0)
       get_arg_val(argv[i], arg_list[1]);
     else if ((strcmp(argv[i], "-sub") == 0) || (strcmp(argv[i], "-avg") == 0) || 
@@ -737,11 +745,8 @@ void reduce_an_sds_by_sub(sds_t *in_sds_info, int32 out_sd_id, int res)
   int   ndata_sm_in = 0, ndata_sm_out;
   int	irow, nrow = 0, ncol = 0, out_ncol = 0;
   int32 attr_type, attr_cnt;
-  int32 in_edge[4] = {0, 0, 0, 0};
-  int32 out_edge[4] = {0, 0, 0, 0};
-  int32 in_start[4] = {0, 0, 0, 0};
-  int32 out_start[4] = {0, 0, 0, 0};
   sds_t out_sds_info;
+  sds_block_t in_blk, out_blk;
   char sds_name[MAX_SDS_NAME_LEN];
   void  *attr_val, *data_in, *data_out;
 
@@ -839,42 +844,11 @@ void reduce_an_sds_by_sub(sds_t *in_sds_info, int32 out_sd_id, int res)
     fprintf(stderr, "Cannot allocate memory for data_in in reduce_an_sds_by_sub\n");
   if ((data_out = (void *)calloc(ndata_out, out_sds_info.data_size)) == NULL)
     fprintf(stderr, "Cannot allocate memory for data_out in reduce_an_sds_by_sub\n");
-  if ((data_in != NULL) && (data_out != NULL))
+  in_blk.buf = out_blk.buf = NULL;
+  if ((data_in != NULL) && (data_out != NULL) &&
+      (open_sds_block(in_sds_info, &in_blk, 'R', res, 0L) != -1) &&
+      (open_sds_block(&out_sds_info, &out_blk, 'W', 1, 0L) != -1))
   {
-    if (rank == 2)
-    {
-      in_edge[0] = out_edge[0] = 1;
-      in_edge[1] = in_sds_info->dim_size[1];
-      out_edge[1] = out_sds_info.dim_size[1];
-    }                       
-    else if (rank > 2)
-    {
-      for (i=0; i<rank; i++)
-        in_edge[i] = out_edge[i] = in_sds_info->dim_size[i];
-      if ((n == -1) && (m == -1))
-      {
-        if (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1])
-        {
-          in_edge[0] = out_edge[0] = 1;
-          out_edge[1] = out_sds_info.dim_size[1];
-        }
-        else
-        {
-          in_edge[rank-2] = 1; out_edge[rank-2] = 1;
-          out_edge[rank-1] = out_sds_info.dim_size[rank-1];
-        }
-      }
-      else
-      {
-        out_edge[0] = 1;
-        out_edge[1] = out_sds_info.dim_size[1];
-        if (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1])
-          in_edge[0] = 1;
-        else
-          in_edge[rank-2] = 1;
-      }
-    }                                
-
     /* compute start of the requested SDS layer and offset of each
        observations */
 
@@ -902,10 +876,6 @@ void reduce_an_sds_by_sub(sds_t *in_sds_info, int32 out_sd_id, int res)
     /* process the requested layer of the input SDS */
  
     res_by_2 = res/2;
-    if ((rank>2) && (n == -1) && (m == -1) && (in_sds_info->dim_size[rank-1]>in_sds_info->dim_size[0]))
-      out_start[rank-2] = 0;
-    else
-      out_start[0] = 0;
 
     /* process one line per res lines of input */
     /* process only one sample per res samples of input samples */
@@ -913,11 +883,7 @@ void reduce_an_sds_by_sub(sds_t *in_sds_info, int32 out_sd_id, int res)
     for (irow=0; irow<nrow; irow += res) 
     {
       res2 = irow + res_by_2;
-      if ((rank == 2) || (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank- 1]))
-        in_start[0] = (res2 < nrow) ? res2 : irow+(nrow-irow)/2;
-      else in_start[rank-2] = (res2 < nrow) ? res2 : irow+(nrow-irow)/2;
-
-      if (SDreaddata(in_sds_info->sds_id, in_start, NULL, in_edge, data_in) == FAIL)
+      if (read_sds_block_rows(&in_blk, (res2 < nrow) ? res2 : irow+(nrow-irow)/2, 1, data_in) == -1)
       {
 	fprintf(stderr, "Error reading input HDF file in reduce_sds\n");
 	break;
@@ -968,16 +934,17 @@ void reduce_an_sds_by_sub(sds_t *in_sds_info, int32 out_sd_id, int res)
 	  } /* for (k=0; . . ) */
         } /* for (i=0; . . .) */
       }
-      if (SDwritedata(out_sds_info.sds_id, out_start, NULL, out_edge, data_out) == FAIL)
+      if (write_sds_block_rows(&out_blk, irow/res, 1, data_out) == -1)
       {
   	fprintf(stderr, "Error writing output to the HDF file in reduce_sds\n");
 	break;
       }
-      if ((rank>2) && (n == -1) && (m == -1) && (in_sds_info->dim_size[rank-1]>in_sds_info->dim_size[0]))
-        ++out_start[rank-2];
-      else ++out_start[0];
     } /* for (irow=0; . . )	*/
+    if (close_sds_block(&out_blk) == -1)
+      fprintf(stderr, "Error writing output to the HDF file in reduce_sds\n");
   }
+  if (in_blk.buf != NULL) close_sds_block(&in_blk);
+  if (out_blk.buf != NULL) close_sds_block(&out_blk);
   SDendaccess(out_sds_info.sds_id);
   if (data_in != NULL) free(data_in);
   if (data_out != NULL) free(data_out);
@@ -1034,11 +1001,8 @@ void reduce_an_sds_by_avg(sds_t *in_sds_info, int32 out_sd_id, int res, int *out
   int st_c, st_c1, sh_sm, offset;
   int irow, icol, jcol, ncol, out_nrow, out_ncol;
   int32 attr_type1 = 0;
-  int32 in_edge[4] = {0, 0, 0, 0};
-  int32 out_edge[4] = {0, 0, 0, 0};
-  int32 in_start[4] = {0, 0, 0, 0};
-  int32 out_start[4] = {0, 0, 0, 0};
   sds_t out_sds_info[5];
+  sds_block_t in_blk, out_blk[5];
   double sum2;
   float *sig_buf = NULL, avg, value = 0.0, sum, min, max;
   void *avg_buf = NULL, *num_buf = NULL, *min_buf = NULL, *max_buf = NULL;
@@ -1187,61 +1151,27 @@ void reduce_an_sds_by_avg(sds_t *in_sds_info, int32 out_sd_id, int res, int *out
     status = -1;
   }
 
-  if ((data_in != NULL) && (status != -1))
+  in_blk.buf = NULL;
+  if ((status != -1) && (open_sds_block(in_sds_info, &in_blk, 'R', res, 0L) == -1))
+    status = -1;
+  for (i=0; i<5; i++)
   {
-    if (rank == 2)
-    {
-      in_edge[0] = res; in_edge[1] = in_sds_info->dim_size[1];
-      out_edge[0] = 1; out_edge[1] = out_sds_info[0].dim_size[1];
-    }
-    else if (rank > 2)
-    {
-      for (i=0; i<rank; i++) in_edge[i] = in_sds_info->dim_size[i];
-      for (i=0; i<out_rank; i++) out_edge[i] = out_sds_info[0].dim_size[i];
-      if ((n == -1) && (m == -1))
-      {
-        if (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1])
-	{
-	  in_edge[0] = res; out_edge[0] = 1;
-	}
-	else 
-	{
-	  in_edge[rank-2] = res; out_edge[rank-2] = 1;
-	}
-      }
-      else
-      {
-        out_edge[0] = 1;
-        if (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1]) in_edge[0] = res;
-        else in_edge[rank-2] = res;
-      }
-    }
+    out_blk[i].buf = NULL;
+    if ((status != -1) && (out_flag[i] == 1))
+      if (open_sds_block(&out_sds_info[i], &out_blk[i], 'W', 1, 0L) == -1)
+        status = -1;
+  }
 
+  if ((data_in != NULL) && (status != -1))
+  {
     /* reads res input lines and average res x res samples */
     /* output one line per res input lines. */
     /* if required create min, max, std, and npix SDS */
 
     for (irow=0; irow<out_nrow; irow++)
     {
-      if ((rank == 2) || (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1]))
-      {
-        in_start[0] = irow*res;
-	if ((irow+1)*res <= in_sds_info->dim_size[0]) in_edge[0] = res;
-	else in_edge[0] = in_sds_info->dim_size[0] - in_start[0];
-	n_res = in_edge[0];
-      }
-      else
-      {
-        in_start[rank-2] = irow*res;
-        if ((irow+1)*res <= in_sds_info->dim_size[rank-2]) in_edge[rank-2] = res;
-	else in_edge[rank-2] = in_sds_info->dim_size[rank-2] - in_start[rank-2];
-	n_res = in_edge[rank-2];
-      }
-      if ((rank>2) && (n == -1) && (m == -1) && (in_sds_info->dim_size[rank-1]>in_sds_info->dim_size[0]))
-        out_start[rank-2] = irow;
-      else out_start[0] = irow;
-
-      if (SDreaddata(in_sds_info->sds_id, in_start, NULL, in_edge, data_in) == FAIL)
+      n_res = ((irow+1)*res <= in_blk.nrows) ? res : in_blk.nrows - irow*res;
+      if (read_sds_block_rows(&in_blk, irow*res, n_res, data_in) == -1)
       {
   	fprintf(stderr, "Error reading data line from SDS %s in reduce_an_sds_by_avg\n", in_sds_info->name);
         break;
@@ -1454,26 +1384,26 @@ void reduce_an_sds_by_avg(sds_t *in_sds_info, int32 out_sd_id, int res, int *out
 	    }  /* for (k=0; . . .) */
 	  }  /* for (ic1=0; . . .) */
 	} /* else  . . .  */
-        if (SDwritedata(out_sds_info[0].sds_id, out_start, NULL, out_edge, (VOIDP)avg_buf) == FAIL)
+        if (write_sds_block_rows(&out_blk[0], irow, 1, (VOIDP)avg_buf) == -1)
 	  fprintf(stderr, "Error writing line of SDS to HDF file in reduce_an_sds_by_avg\n");
         if (out_flag[1] == 1)
         {
-          if (SDwritedata(out_sds_info[1].sds_id, out_start, NULL, out_edge, (VOIDP)min_buf) == FAIL)
+          if (write_sds_block_rows(&out_blk[1], irow, 1, (VOIDP)min_buf) == -1)
 	    fprintf(stderr, "Error writing line of SDS to HDF file in reduce_an_sds_by_avg\n");
         }
         if (out_flag[2] == 1)
         {
-          if (SDwritedata(out_sds_info[2].sds_id, out_start, NULL, out_edge, (VOIDP)max_buf) == FAIL)
+          if (write_sds_block_rows(&out_blk[2], irow, 1, (VOIDP)max_buf) == -1)
 	    fprintf(stderr, "Error writing line of SDS to HDF file in reduce_an_sds_by_avg\n");
         }
         if (out_flag[3] == 1)
         {
-          if (SDwritedata(out_sds_info[3].sds_id, out_start, NULL, out_edge, (VOIDP)sig_buf) == FAIL)
+          if (write_sds_block_rows(&out_blk[3], irow, 1, (VOIDP)sig_buf) == -1)
 	    fprintf(stderr, "Error writing line of SDS to HDF file in reduce_an_sds_by_avg\n");
         }
         if (out_flag[4] == 1)
         {
-          if (SDwritedata(out_sds_info[4].sds_id, out_start, NULL, out_edge, (VOIDP)num_buf) == FAIL)
+          if (write_sds_block_rows(&out_blk[4], irow, 1, (VOIDP)num_buf) == -1)
 	    fprintf(stderr, "Error writing line of SDS to HDF file in reduce_an_sds_by_avg\n");
         }
       }  /* else		*/
@@ -1493,6 +1423,11 @@ void reduce_an_sds_by_avg(sds_t *in_sds_info, int32 out_sd_id, int res, int *out
 	write_attr_fval(out_sds_info[i].sds_id, attr_type1, c, fill_val, ATTR_FILL_NAME);
       }
   }  /* if ((data_in != NULL) . . . 	*/
+  if (in_blk.buf != NULL) close_sds_block(&in_blk);
+  for (i=0; i<5; i++)
+    if (out_blk[i].buf != NULL)
+      if (close_sds_block(&out_blk[i]) == -1)
+        fprintf(stderr, "Error writing line of SDS to HDF file in reduce_an_sds_by_avg\n");
   SDendaccess(in_sds_info->sds_id);
   SDendaccess(out_sds_info[0].sds_id);
   free(data_in);
@@ -1560,11 +1495,8 @@ void reduce_an_sds_by_cnt(sds_t *in_sds_info, int32 out_sd_id, int res, char *cm
   int value = 0, fill_val = 0, sds_val;
   int ndata_sm_in = 0, ndata_sm_out;
   int32 attr_type, attr_cnt;
-  int32 in_edge[4] = {0, 0, 0, 0};
-  int32 out_edge[4] = {0, 0, 0, 0};
-  int32 in_start[4] = {0, 0, 0, 0};
-  int32 out_start[4] = {0, 0, 0, 0};
   sds_t *out_sds_info = NULL;
+  sds_block_t in_blk, out_blk[MAX_NUM_SDS];
   char sds_name[MAX_SDS_NAME_LEN];
   void *attr_val, *data_in, *data_out[MAX_NUM_SDS];
   char *opr[] = {"<=", ">=", "==", "!=", "<", ">"};
@@ -1705,60 +1637,25 @@ void reduce_an_sds_by_cnt(sds_t *in_sds_info, int32 out_sd_id, int res, char *cm
 	status = -1;
       }
 
-    if ((data_in != NULL) && (status != -1))
+    in_blk.buf = NULL;
+    if ((status != -1) && (open_sds_block(in_sds_info, &in_blk, 'R', res, 0L) == -1))
+      status = -1;
+    for (isds=0; isds<nsds; isds++)
     {
-      if (rank == 2)
-      {
-        in_edge[0] = res; in_edge[1] = in_sds_info->dim_size[1];
-        out_edge[0] = 1; out_edge[1] = out_sds_info[0].dim_size[1];
-      }
-      else if (rank > 2)
-      {
-        for (i=0; i<rank; i++) in_edge[i] = in_sds_info->dim_size[i];
-        for (i=0; i<out_rank; i++) out_edge[i] = out_sds_info[0].dim_size[i];
-        if ((n == -1) && (m == -1))
-        {
-          if (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1])
-          {
-            in_edge[0] = res; out_edge[0] = 1;
-          }
-          else
-          {
-            in_edge[rank-2] = res; out_edge[rank-2] = 1;
-          }
-        }
-        else
-        {
-          out_edge[0] = 1;
-          if (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1]) in_edge[0] = res;
-          else in_edge[rank-2] = res;
-        }
-      }
+      out_blk[isds].buf = NULL;
+      if ((status != -1) && (open_sds_block(&out_sds_info[isds], &out_blk[isds], 'W', 1, 0L) == -1))
+        status = -1;
+    }
 
+    if ((data_in != NULL) && (status != -1))
+    {
       /* read res lines from input and output one sample per res x res input */
       /* output one line per res line of input data */
 
       for (irow=0; irow<out_nrow; irow++)
       {
-        if ((rank == 2) || (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1]))
-        {
-          in_start[0] = irow*res;
-          if ((irow+1)*res <= in_sds_info->dim_size[0]) in_edge[0] = res;
-          else in_edge[0] = in_sds_info->dim_size[0] - in_start[0];
-          n_res = in_edge[0];
-        }
-        else
-        {
-          in_start[rank-2] = irow*res;
-          if ((irow+1)*res <= in_sds_info->dim_size[rank-2]) in_edge[rank-2] = res;
-          else in_edge[rank-2] = in_sds_info->dim_size[rank-2] - in_start[rank-2];
-          n_res = in_edge[rank-2];
-        }
-        if ((rank>2) && (n == -1) && (m == -1) && (in_sds_info->dim_size[rank-1]>in_sds_info->dim_size[0]))
-          out_start[rank-2] = irow;
-        else out_start[0] = irow;
-  
-        if (SDreaddata(in_sds_info->sds_id, in_start, NULL, in_edge, data_in) == FAIL)
+        n_res = ((irow+1)*res <= in_blk.nrows) ? res : in_blk.nrows - irow*res;
+        if (read_sds_block_rows(&in_blk, irow*res, n_res, data_in) == -1)
         {
           fprintf(stderr, "Error reading data line from SDS %s in reduce_an_sds_by_avg\n", in_sds_info->name);
           break;
@@ -1885,7 +1782,7 @@ void reduce_an_sds_by_cnt(sds_t *in_sds_info, int32 out_sd_id, int res, char *cm
 	    }  /* for (ic1=0; . .  ) */
 	  } /* else . . . .  */
 	  for (isds=0; isds<nsds; isds++)
-            if (SDwritedata(out_sds_info[isds].sds_id, out_start, NULL, out_edge, data_out[isds]) == FAIL)
+            if (write_sds_block_rows(&out_blk[isds], irow, 1, data_out[isds]) == -1)
 	      fprintf(stderr, "Error writing line of SDS to file in reduce_an_sds_by_cnt\n");
         }  /* else		*/
       }  /* for (ir=0; . . . 	*/ 
@@ -1893,6 +1790,11 @@ void reduce_an_sds_by_cnt(sds_t *in_sds_info, int32 out_sd_id, int res, char *cm
       for (isds=0; isds<nsds; isds++)
         free(data_out[isds]);
     }  /* if ((data_in != NULL) . . . 	*/
+    if (in_blk.buf != NULL) close_sds_block(&in_blk);
+    for (isds=0; isds<nsds; isds++)
+      if (out_blk[isds].buf != NULL)
+        if (close_sds_block(&out_blk[isds]) == -1)
+	  fprintf(stderr, "Error writing line of SDS to file in reduce_an_sds_by_cnt\n");
     free(attr_val);
     SDendaccess(in_sds_info->sds_id);
     for (isds=0; isds<nsds; isds++)
@@ -2042,11 +1944,8 @@ void reduce_an_sds_by_class(sds_t *in_sds_info, int32 out_sd_id, int res)
   int ncol, irow, icol, jcol;
   int ndata_sm_in = 0, ndata_sm_out;
   int32 attr_type, attr_cnt;
-  int32 in_edge[4] = {0, 0, 0, 0};
-  int32 out_edge[4] = {0, 0, 0, 0};
-  int32 in_start[4] = {0, 0, 0, 0};
-  int32 out_start[4] = {0, 0, 0, 0};
   sds_t out_sds_info;
+  sds_block_t in_blk, out_blk;
   char sds_name[MAX_SDS_NAME_LEN];
   void *attr_val, *data_in, *data_out;
   int cl_num, class_cnt[MAX_NUM_CLASS], max_cl_id;
@@ -2152,60 +2051,18 @@ void reduce_an_sds_by_class(sds_t *in_sds_info, int32 out_sd_id, int res)
   if ((data_out = (void *)calloc(ndata_out, out_sds_info.data_size)) == NULL)
     fprintf(stderr, "Cannot allocate memory for data_out in reduce_an_sds_by_cnt\n");
 
-  if ((data_in != NULL) && (data_out != NULL))
+  in_blk.buf = out_blk.buf = NULL;
+  if ((data_in != NULL) && (data_out != NULL) &&
+      (open_sds_block(in_sds_info, &in_blk, 'R', res, 0L) != -1) &&
+      (open_sds_block(&out_sds_info, &out_blk, 'W', 1, 0L) != -1))
   {
-    if (rank == 2)
-    {
-      in_edge[0] = res; in_edge[1] = in_sds_info->dim_size[1];
-      out_edge[0] = 1; out_edge[1] = out_sds_info.dim_size[1];
-    }
-    else if (rank > 2)
-    {
-      for (i=0; i<rank; i++) in_edge[i] = in_sds_info->dim_size[i];
-      for (i=0; i<out_rank; i++) out_edge[i] = out_sds_info.dim_size[i];
-      if ((n == -1) && (m == -1))
-      {
-        if (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1])
-        {
-          in_edge[0] = res; out_edge[0] = 1;
-        }
-        else
-        {
-          in_edge[rank-2] = res; out_edge[rank-2] = 1;
-        }
-      }
-      else
-      {
-        out_edge[0] = 1;
-        if (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1]) in_edge[0] = res;
-        else in_edge[rank-2] = res;
-      }
-    }
-
     /* read res lines of input at a time. Process res x res */
     /* block and ouput one line per res line of input */
 
     for (irow=0; irow<out_nrow; irow++)
     {
-      if ((rank == 2) || (in_sds_info->dim_size[0] > in_sds_info->dim_size[rank-1]))
-      {
-        in_start[0] = irow*res;
-        if ((irow+1)*res <= in_sds_info->dim_size[0]) in_edge[0] = res;
-        else in_edge[0] = in_sds_info->dim_size[0] - in_start[0];
-        n_res = in_edge[0];
-      }
-      else
-      {
-        in_start[rank-2] = irow*res;
-        if ((irow+1)*res <= in_sds_info->dim_size[rank-2]) in_edge[rank-2] = res;
-        else in_edge[rank-2] = in_sds_info->dim_size[rank-2] - in_start[rank-2];
-        n_res = in_edge[rank-2];
-      }
-      if ((rank>2) && (n == -1) && (m == -1) && (in_sds_info->dim_size[rank-1]>in_sds_info->dim_size[0]))
-        out_start[rank-2] = irow;
-      else out_start[0] = irow;
-  
-      if (SDreaddata(in_sds_info->sds_id, in_start, NULL, in_edge, data_in) == FAIL)
+      n_res = ((irow+1)*res <= in_blk.nrows) ? res : in_blk.nrows - irow*res;
+      if (read_sds_block_rows(&in_blk, irow*res, n_res, data_in) == -1)
       {
         fprintf(stderr, "Error reading data line from SDS %s in reduce_an_sds_by_avg\n", in_sds_info->name);
         break;
@@ -2308,13 +2165,17 @@ void reduce_an_sds_by_class(sds_t *in_sds_info, int32 out_sd_id, int res)
 	    }  /* for (k=0; . . . ) */
 	  }  /* for (ic1=0; . .  ) */
 	} /* else . . . .  */
-        if (SDwritedata(out_sds_info.sds_id, out_start, NULL, out_edge, data_out) == FAIL)
+        if (write_sds_block_rows(&out_blk, irow, 1, data_out) == -1)
 	  fprintf(stderr, "Error writing line of SDS to file in reduce_an_sds_by_class\n");
       }  /* else		*/
     }  /* for (ir=0; . . . 	*/ 
-    free(data_in);
-    free(data_out);
+    if (close_sds_block(&out_blk) == -1)
+      fprintf(stderr, "Error writing line of SDS to file in reduce_an_sds_by_class\n");
   }  /* if ((data_in != NULL) . . . 	*/
+  if (in_blk.buf != NULL) close_sds_block(&in_blk);
+  if (out_blk.buf != NULL) close_sds_block(&out_blk);
+  if (data_in != NULL) free(data_in);
+  if (data_out != NULL) free(data_out);
   free(attr_val);
   SDendaccess(in_sds_info->sds_id);
   SDendaccess(out_sds_info.sds_id);
@@ -342,7 +342,6 @@ int sds2bin(char *in_fname, char **sds_names, int sds_cnt, char *out_fname )
 *****************************************************************************/
 
 {
-  int bsq;
   int n, m, isds;
   size_t i, ic;
   int rank,st_c, offset, k;
@@ -350,8 +349,7 @@ int sds2bin(char *in_fname, char **sds_names, int sds_cnt, char *out_fname )
   size_t ndata_in = 0;
   size_t ndata_out = 0;
   FILE *fp;  
-  int32 in_edge[4] = {0,0,0,0};  
-  int32 in_start[4] = {0,0,0,0};   
+  sds_block_t in_blk;
   void *data_in, *data_out; /*, *attr_val; */
   sds_t in_sds_info;
   
@@ -384,7 +382,6 @@ int sds2bin(char *in_fname, char **sds_names, int sds_cnt, char *out_fname )
     } 
 
     rank = in_sds_info.rank;
-    bsq = ((rank == 2) || (in_sds_info.dim_size[0] < in_sds_info.dim_size[rank-1])) ? 1 : 0;
 
     if (rank == 2)
       ndata_in = ndata_out = in_sds_info.dim_size[1];
@@ -412,42 +409,18 @@ int sds2bin(char *in_fname, char **sds_names, int sds_cnt, char *out_fname )
     if ((data_out = (void *)calloc(ndata_out, in_sds_info.data_size)) == NULL)
       fprintf(stderr, "Cannot allocate memory for data_out in sds2bin\n");
     
-    if ((data_in != NULL) && (data_out != NULL))
+    in_blk.buf = NULL;
+    if ((data_in != NULL) && (data_out != NULL) &&
+	(open_sds_block(&in_sds_info, &in_blk, 'R', 1, 0L) != -1))
       {
-	if (rank == 2)
-	  {
-	    in_edge[0] = 1;
-	    in_edge[1] = in_sds_info.dim_size[1];
-	    nrow = in_sds_info.dim_size[0];
-	  }
-	else if (rank > 2)
-	  {
-	    nrow = (bsq == 1) ? in_sds_info.dim_size[rank-2] : in_sds_info.dim_size[0];
-	    for (k=0; k<rank; k++)
-	      in_edge[k] = in_sds_info.dim_size[k];
-	    if ((n == -1) && (m == -1))
-	      {
-		if (bsq == 0) in_edge[0] = 1;
-		else in_edge[rank-2] = 1;
-	      }
-	    else
-	      {
-		if (bsq == 0) in_edge[0] = 1;
-		else in_edge[rank-2] = 1;
-	      }
-	  }
+	nrow = in_blk.nrows;
 	
 	compute_sds_start_offset(&in_sds_info, n, m, &st_c, &offset);
 	
 	
 	for (irow=0; irow<nrow; irow++)
 	  {
-	    if ((rank == 2) || (in_sds_info.dim_size[0] > in_sds_info.dim_size[rank-1]))
-	      in_start[0] = irow;
-	    else
-	      in_start[rank-2] = irow;
-	    
-	    if (SDreaddata(in_sds_info.sds_id, in_start, NULL, in_edge, data_in) == FAIL)
+	    if (read_sds_block_rows(&in_blk, irow, 1, data_in) == -1)
 	      {
 		fprintf(stderr, "Cannot read data line from SDS %s in sds2bin\n", in_sds_info.name);
 		break;
@@ -493,6 +466,7 @@ int sds2bin(char *in_fname, char **sds_names, int sds_cnt, char *out_fname )
 	      }
 	  }
       }
+    if (in_blk.buf != NULL) close_sds_block(&in_blk);
     if (data_in != NULL) free(data_in);
     if (data_out != NULL) free(data_out);
     SDendaccess(in_sds_info.sds_id);
@@ -417,6 +417,154 @@ void compute_sds_start_offset(sds_t *sds_info, int n, int m, int *st_c, int *off
 }
 
 
+/* Output compression set with set_sds_compress(). Entry 0 holds the default
+   for all SDS, the others apply to the named SDS only. */
+static sds_comp_t sds_comp[MAX_NUM_SDS+1];
+static int n_sds_comp = 0;
+
+int set_sds_compress(char *comp_str)
+/*
+ * Parse the value of the -compress option, a comma separated list of
+ * [sds_name=]method where method is none, szip, deflate or deflate:level.
+ * An entry without an SDS name sets the compression of all output SDS.
+ * Return 1 on success and -1 on failure.
+ */
+{
+  int i, p1, status;
+  char *str, *entry, method[MAX_SDS_NAME_LEN];
+  sds_comp_t comp;
+
+  status = 1;
+  if (n_sds_comp == 0)
+  {
+    sds_comp[0].name[0] = '\0';
+    sds_comp[0].comp_type = COMP_CODE_NONE;
+    sds_comp[0].level = SDS_DEFLATE_LEVEL;
+    n_sds_comp = 1;
+  }
+  if ((str = (char *)malloc(strlen(comp_str)+1)) == NULL)
+  {
+    fprintf(stderr, "Cannot allocate memory for str in set_sds_compress\n");
+    return -1;
+  }
+  strcpy(str, comp_str);
+  for (entry=strtok(str, ","); entry!=NULL; entry=strtok(NULL, ","))
+  {
+    comp.name[0] = '\0';
+    if ((p1 = sd_charpos(entry, '=', 0)) != -1)
+    {
+      if (p1 >= MAX_SDS_NAME_LEN)
+      {
+        fprintf(stderr, "SDS name too long in compression %s in set_sds_compress\n", entry);
+        status = -1;
+        continue;
+      }
+      sd_strmid(entry, 0, p1, comp.name);
+      entry += p1 + 1;
+    }
+    comp.level = SDS_DEFLATE_LEVEL;
+    p1 = sd_charpos(entry, ':', 0);
+    if (((p1 != -1) ? p1 : (int)strlen(entry)) >= MAX_SDS_NAME_LEN)
+    {
+      fprintf(stderr, "Invalid compression %s in set_sds_compress\n", entry);
+      status = -1;
+      continue;
+    }
+    if (p1 != -1)
+    {
+      sd_strmid(entry, 0, p1, method);
+      comp.level = atoi(entry + p1 + 1);
+    }
+    else strcpy(method, entry);
+    if (strcmp(method, "none") == 0) comp.comp_type = COMP_CODE_NONE;
+    else if (strcmp(method, "szip") == 0) comp.comp_type = COMP_CODE_SZIP;
+    else if ((strcmp(method, "deflate") == 0) && (comp.level >= 1) && (comp.level <= 9))
+      comp.comp_type = COMP_CODE_DEFLATE;
+    else
+    {
+      fprintf(stderr, "Invalid compression %s in set_sds_compress\n", entry);
+      status = -1;
+      continue;
+    }
+    if (comp.name[0] == '\0') i = 0;
+    else
+    {
+      for (i=1; i<n_sds_comp; i++)
+        if (strcmp(sds_comp[i].name, comp.name) == 0) break;
+      if (i > MAX_NUM_SDS)
+      {
+        fprintf(stderr, "Too many SDS in the compression option, %s is ignored\n", comp.name);
+        continue;
+      }
+      if (i == n_sds_comp) n_sds_comp++;
+    }
+    sds_comp[i] = comp;
+  }
+  free(str);
+  return status;
+}
+
+static void set_sds_chunk_comp(sds_t *sds_info)
+/*
+ * Make a newly created SDS chunked and compressed as selected with
+ * set_sds_compress(). A chunk spans whole rows (of a single layer when the
+ * layers lead the rows), and the number of rows is chosen so that a chunk
+ * holds about SDS_CHUNK_MEM_SIZE bytes. This is done when a write block is
+ * opened, after the tool has set the SDS attributes, because HDF takes the
+ * fill value of the chunks from the _FillValue attribute at this point.
+ */
+{
+  int i, rank, row_dim;
+  long row_size, nr;
+  int32 c_flags;
+  intn empty;
+  HDF_CHUNK_DEF c_def;
+  sds_comp_t *comp;
+
+  if (n_sds_comp == 0) return;
+  for (i=1; i<n_sds_comp; i++)
+    if (strcmp(sds_comp[i].name, sds_info->name) == 0) break;
+  comp = (i < n_sds_comp) ? &sds_comp[i] : &sds_comp[0];
+  rank = sds_info->rank;
+  if ((comp->comp_type == COMP_CODE_NONE) || (rank == 1)) return;
+
+  /* only a newly created SDS, not yet chunked nor written, is set up, so
+     further write blocks on the same SDS leave it as it is */
+  if ((SDgetchunkinfo(sds_info->sds_id, &c_def, &c_flags) == FAIL) || (c_flags != HDF_NONE) ||
+      (SDcheckempty(sds_info->sds_id, &empty) == FAIL) || !empty)
+    return;
+
+  row_dim = ((rank > 2) && (sds_info->dim_size[0] <= sds_info->dim_size[rank-1])) ? rank-2 : 0;
+  row_size = DFKNTsize(sds_info->data_type);
+  for (i=0; i<rank; i++)
+  {
+    if (i < row_dim) c_def.comp.chunk_lengths[i] = 1;
+    else if (i > row_dim)
+    {
+      c_def.comp.chunk_lengths[i] = sds_info->dim_size[i];
+      row_size *= sds_info->dim_size[i];
+    }
+  }
+  nr = SDS_CHUNK_MEM_SIZE/row_size;
+  if (nr > sds_info->dim_size[row_dim]) nr = sds_info->dim_size[row_dim];
+  if (nr < 1) nr = 1;
+  c_def.comp.chunk_lengths[row_dim] = (int32)nr;
+
+  c_def.comp.comp_type = comp->comp_type;
+  if (comp->comp_type == COMP_CODE_DEFLATE)
+    c_def.comp.cinfo.deflate.level = comp->level;
+  else
+  {
+    c_def.comp.cinfo.szip.options_mask = SZ_NN_OPTION_MASK;
+    c_def.comp.cinfo.szip.pixels_per_block = (sds_info->dim_size[rank-1] < 16) ? 
+		(sds_info->dim_size[rank-1]/2)*2 : 16;
+    if (c_def.comp.cinfo.szip.pixels_per_block < 2) c_def.comp.cinfo.szip.pixels_per_block = 2;
+  }
+  if (SDsetchunk(sds_info->sds_id, c_def, HDF_CHUNK | HDF_COMP) == FAIL)
+    fprintf(stderr, "Cannot set chunking and compression for SDS %s, writing it uncompressed\n",
+		sds_info->name);
+}
+
 int open_sds(char *fname, sds_t *sds_info, char open_t)
 /* open an SDS from a HDF file */
 {
@@ -1123,3 +1271,288 @@ int open_l2g_nobs_sds(sds_t *nobs_sds_info, sds_t *nadd_obs_sds_info, sds_t *sds
   return k;
 
 }
+
+int open_sds_block(sds_t *sds_info, sds_block_t *blk, char open_t, int row_mult, long mem_size)
+/*
+ * Set up a row block on an open SDS for reading (open_t 'R') or writing
+ * (open_t 'W'). The number of rows buffered is chosen so that one block
+ * fits in mem_size bytes (SDS_BLOCK_MEM_SIZE if mem_size <= 0) and is a
+ * multiple of row_mult, so callers reading row_mult rows at a time never
+ * straddle two blocks. On a chunked SDS the block is also a multiple of the
+ * chunk rows, even if that exceeds mem_size, so that no chunk is decoded
+ * twice. Blocks are aligned on multiples of the block size.
+ * Return 1 on success and -1 on failure.
+ */
+{
+  int i, rank, a, b, r;
+  intn fill_mode;
+  int32 c_flags, nchunks;
+  long row_size, nr;
+  HDF_CHUNK_DEF c_def;
+
+  rank = sds_info->rank;
+  blk->sds_info = sds_info;
+  blk->mode = open_t;
+  blk->first_row = blk->lo_row = blk->hi_row = -1;
+  blk->cur_nrows = 0;
+  blk->buf = NULL;
+  blk->fill_size = 0;
+  if ((rank < 1) || (rank > 4))
+  {
+    fprintf(stderr, "SDS %s of rank %d is not supported in open_sds_block, the rank must be 1 to 4\n",
+		sds_info->name, (int)rank);
+    return -1;
+  }
+  if (open_t == 'W')
+  {
+    set_sds_chunk_comp(sds_info);
+    /* Blocks holding only the _FillValue need not be written when the file
+       is in fill mode, HDF returns the fill value for unwritten data */
+    if ((DFKNTsize(sds_info->data_type) <= (int32)sizeof(blk->fill)) &&
+        (SDgetfillvalue(sds_info->sds_id, (VOIDP)blk->fill) != FAIL))
+    {
+      if ((fill_mode = SDsetfillmode(sds_info->sd_id, SD_FILL)) == SD_FILL)
+        blk->fill_size = DFKNTsize(sds_info->data_type);
+      else if (fill_mode != FAIL)
+        SDsetfillmode(sds_info->sd_id, fill_mode);
+    }
+  }
+  blk->nseg = 1;
+  blk->seg_size = sds_info->data_size;
+  if (rank == 1)
+  {
+    blk->row_dim = -1;
+    blk->nrows = 1;
+    blk->seg_size *= sds_info->dim_size[0];
+  }
+  else if ((rank > 2) && (sds_info->dim_size[0] <= sds_info->dim_size[rank-1]))
+  {
+    /* layers ahead of the rows, also when the first and last dimensions
+       are equal, as the tools read such SDSs */
+    blk->row_dim = rank - 2;
+    blk->seg_size *= sds_info->dim_size[rank-1];
+    for (i=0; i<rank-2; i++)
+      blk->nseg *= sds_info->dim_size[i];
+  }
+  else
+  {
+    blk->row_dim = 0;
+    for (i=1; i<rank; i++)
+      blk->seg_size *= sds_info->dim_size[i];
+  }
+  if (blk->row_dim != -1)
+    blk->nrows = sds_info->dim_size[blk->row_dim];
+
+  /* For a chunked (and usually compressed) SDS make the block a whole
+     number of chunk rows so that every chunk is read and decoded once, and
+     size the chunk cache to one chunk row for the partial block at the end */
+  blk->chunk_nrows = 1;
+  if ((blk->row_dim != -1) && (SDgetchunkinfo(sds_info->sds_id, &c_def, &c_flags) != FAIL) &&
+      (c_flags != HDF_NONE) && (c_def.chunk_lengths[blk->row_dim] > 0))
+  {
+    blk->chunk_nrows = c_def.chunk_lengths[blk->row_dim];
+    for (i=0, nchunks=1; i<rank; i++)
+      if ((i != blk->row_dim) && (c_def.chunk_lengths[i] > 0))
+        nchunks *= (sds_info->dim_size[i] + c_def.chunk_lengths[i] - 1)/c_def.chunk_lengths[i];
+    SDsetchunkcache(sds_info->sds_id, nchunks, 0);
+  }
+
+  if (mem_size <= 0) mem_size = SDS_BLOCK_MEM_SIZE;
+  if (row_mult < 1) row_mult = 1;
+  /* smallest multiple of both row_mult and the chunk row */
+  for (a=row_mult, b=blk->chunk_nrows; b!=0; ) { r = a%b; a = b; b = r; }
+  row_mult = (row_mult/a)*blk->chunk_nrows;
+  row_size = (long)blk->nseg*blk->seg_size;
+  nr = (row_size > 0) ? mem_size/row_size : 1;
+  nr = (nr/row_mult)*row_mult;
+  if (nr < row_mult) nr = row_mult;
+  if (nr > blk->nrows) nr = blk->nrows;
+  if (nr < 1) nr = 1;
+  blk->block_nrows = (int)nr;
+
+  if ((blk->buf = (void *)malloc((size_t)row_size*blk->block_nrows)) == NULL)
+  {
+    fprintf(stderr, "Cannot allocate memory for the row block of SDS %s in open_sds_block\n",
+		sds_info->name);
+    return -1;
+  }
+  return 1;
+}
+
+static void get_sds_block_start_edge(sds_block_t *blk, int row, int nrows, int32 *start, int32 *edge)
+/* set up start and edge to access nrows rows of the block SDS from row */
+{
+  int i;
+
+  for (i=0; i<blk->sds_info->rank; i++)
+  {
+    start[i] = 0;
+    edge[i] = blk->sds_info->dim_size[i];
+  }
+  if (blk->row_dim != -1)
+  {
+    start[blk->row_dim] = row;
+    edge[blk->row_dim] = nrows;
+  }
+}
+
+static int load_sds_block(sds_block_t *blk, int row)
+/* read the block holding the input row into the block buffer */
+{
+  int32 edge[4], start[4];
+
+  blk->first_row = (row/blk->block_nrows)*blk->block_nrows;
+  blk->cur_nrows = blk->nrows - blk->first_row;
+  if (blk->cur_nrows > blk->block_nrows) blk->cur_nrows = blk->block_nrows;
+  get_sds_block_start_edge(blk, blk->first_row, blk->cur_nrows, start, edge);
+  if (SDreaddata(blk->sds_info->sds_id, start, NULL, edge, blk->buf) == FAIL)
+  {
+    fprintf(stderr, "Cannot read rows %d-%d from SDS %s in load_sds_block\n",
+		blk->first_row, blk->first_row + blk->cur_nrows - 1, blk->sds_info->name);
+    blk->first_row = -1;
+    return -1;
+  }
+  return 1;
+}
+
+int read_sds_block_rows(sds_block_t *blk, int row, int nrows, void *data)
+/*
+ * Copy nrows rows starting at row into data, in the same layout SDreaddata
+ * returns for an edge of nrows along the row dimension. Blocks are read
+ * from the SDS as needed. Return 1 on success and -1 on failure.
+ */
+{
+  int is, ir, n, end_row;
+  char *src, *dst;
+
+  end_row = row + nrows;
+  if ((row < 0) || (end_row > blk->nrows))
+  {
+    fprintf(stderr, "Rows %d-%d out of range for SDS %s in read_sds_block_rows\n",
+		row, end_row-1, blk->sds_info->name);
+    return -1;
+  }
+  for (ir=row; ir<end_row; ir+=n)
+  {
+    if ((blk->first_row == -1) || (ir < blk->first_row) ||
+		(ir >= blk->first_row + blk->cur_nrows))
+      if (load_sds_block(blk, ir) == -1) return -1;
+    n = blk->first_row + blk->cur_nrows - ir;
+    if (n > end_row - ir) n = end_row - ir;
+    for (is=0; is<blk->nseg; is++)
+    {
+      src = (char *)blk->buf + ((long)is*blk->cur_nrows + ir - blk->first_row)*blk->seg_size;
+      dst = (char *)data + ((long)is*nrows + ir - row)*blk->seg_size;
+      memcpy(dst, src, (size_t)n*blk->seg_size);
+    }
+  }
+  return 1;
+}
+
+static int is_fill_block(sds_block_t *blk, long nbytes)
+/* check if the first nbytes of the block buffer are all the SDS fill value */
+{
+  char *buf;
+
+  buf = (char *)blk->buf;
+  if ((blk->fill_size == 0) || (memcmp(buf, blk->fill, blk->fill_size) != 0))
+    return 0;
+  /* every value equals the first if the buffer equals itself shifted by one value */
+  return (memcmp(buf, buf + blk->fill_size, (size_t)(nbytes - blk->fill_size)) == 0);
+}
+
+int flush_sds_block(sds_block_t *blk)
+/*
+ * Write the rows held in the block buffer to the SDS. The rows written
+ * since the last flush must be contiguous. Rows that are all the SDS fill
+ * value are not written. Return 1 on success and -1 on failure.
+ */
+{
+  int is, n, status;
+  int32 edge[4], start[4];
+  char *src, *dst;
+
+  status = 1;
+  if ((blk->mode != 'W') || (blk->lo_row == -1)) return status;
+  n = blk->hi_row - blk->lo_row + 1;
+  if (n != blk->cur_nrows)
+  {
+    /* compact the written rows of each layer into the layout of an edge of n rows */
+    for (is=0; is<blk->nseg; is++)
+    {
+      src = (char *)blk->buf + ((long)is*blk->cur_nrows + blk->lo_row - blk->first_row)*blk->seg_size;
+      dst = (char *)blk->buf + (long)is*n*blk->seg_size;
+      memmove(dst, src, (size_t)n*blk->seg_size);
+    }
+  }
+  get_sds_block_start_edge(blk, blk->lo_row, n, start, edge);
+  if (is_fill_block(blk, (long)n*blk->nseg*blk->seg_size)) ;
+  else if (SDwritedata(blk->sds_info->sds_id, start, NULL, edge, blk->buf) == FAIL)
+  {
+    fprintf(stderr, "Cannot write rows %d-%d to SDS %s in flush_sds_block\n",
+		blk->lo_row, blk->hi_row, blk->sds_info->name);
+    status = -1;
+  }
+  blk->first_row = blk->lo_row = blk->hi_row = -1;
+  blk->cur_nrows = 0;
+  return status;
+}
+
+int write_sds_block_rows(sds_block_t *blk, int row, int nrows, void *data)
+/*
+ * Copy nrows rows in data, laid out as SDwritedata expects for an edge of
+ * nrows along the row dimension, into the block buffer starting at row.
+ * A block is written to the SDS when a row outside it is written or the
+ * block is flushed or closed. Return 1 on success and -1 on failure.
+ */
+{
+  int is, ir, n, end_row;
+  int status;
+  char *src, *dst;
+
+  status = 1;
+  end_row = row + nrows;
+  if ((row < 0) || (end_row > blk->nrows))
+  {
+    fprintf(stderr, "Rows %d-%d out of range for SDS %s in write_sds_block_rows\n",
+		row, end_row-1, blk->sds_info->name);
+    return -1;
+  }
+  for (ir=row; ir<end_row; ir+=n)
+  {
+    if ((blk->first_row == -1) || (ir < blk->first_row) ||
+		(ir >= blk->first_row + blk->cur_nrows))
+    {
+      if (flush_sds_block(blk) == -1) status = -1;
+      blk->first_row = (ir/blk->block_nrows)*blk->block_nrows;
+      blk->cur_nrows = blk->nrows - blk->first_row;
+      if (blk->cur_nrows > blk->block_nrows) blk->cur_nrows = blk->block_nrows;
+    }
+    n = blk->first_row + blk->cur_nrows - ir;
+    if (n > end_row - ir) n = end_row - ir;
+    for (is=0; is<blk->nseg; is++)
+    {
+      src = (char *)data + ((long)is*nrows + ir - row)*blk->seg_size;
+      dst = (char *)blk->buf + ((long)is*blk->cur_nrows + ir - blk->first_row)*blk->seg_size;
+      memcpy(dst, src, (size_t)n*blk->seg_size);
+    }
+    if ((blk->lo_row == -1) || (ir < blk->lo_row)) blk->lo_row = ir;
+    if (ir + n - 1 > blk->hi_row) blk->hi_row = ir + n - 1;
+  }
+  return status;
+}
+
+int close_sds_block(sds_block_t *blk)
+/*
+ * Flush a write block and release the block buffer. The SDS itself is
+ * left open. Return 1 on success and -1 on failure.
+ */
+{
+  int status;
+
+  status = flush_sds_block(blk);
+  if (blk->buf != NULL) free(blk->buf);
+  blk->buf = NULL;
+  blk->first_row = -1;
+  return status;
+}
@@ -3,11 +3,22 @@
 #ifndef _SDS_RW_H_
 #define _SDS_RW_H_
 
+/* Help of the -compress option of the tools writing SDS, pad following the
+   option name up to the column of the descriptions, indented by indent */
+#define SDS_COMPRESS_HELP(pad, indent) \
+"    -compress=<list>" pad "Write the output SDS chunked and compressed.\n" \
+indent "The list is a comma separated list of\n" \
+indent "[SDS_name=]method where method is\n" \
+indent "deflate[:level], szip or none. An entry\n" \
+indent "without an SDS name applies to all output\n" \
+indent "SDS. The default deflate level is 6.\n"
+
 char *get_attr_metadata(char *in_fname, char *meta_str);
 int get_sds_info(char *hdf_fname, sds_t *sds_info);
 int get_sds_data(sds_t *sds, void *data);
 void *get_sel_sds_data(sds_t *sds, int32 *start, int32 *edge);
 int open_sds(char *fname, sds_t *sds_info, char open_t);
+int set_sds_compress(char *comp_str);
 void close_hdf(sds_t *sds_info);
 int get_l2g_sds_names(char *fname, char **sds_names);
 int get_sds_names(char *fname, char **sds_names);
@@ -31,6 +42,12 @@ void print_sds_dim_size(sds_t *sds_info);
 void get_sds_dim_name(sds_t *sds_info, char **dim_names, char **short_dim_names);
 void display_sds_info_of_file(char* filename);
 
+int open_sds_block(sds_t *sds_info, sds_block_t *blk, char open_t, int row_mult, long mem_size);
+int read_sds_block_rows(sds_block_t *blk, int row, int nrows, void *data);
+int write_sds_block_rows(sds_block_t *blk, int row, int nrows, void *data);
+int flush_sds_block(sds_block_t *blk);
+int close_sds_block(sds_block_t *blk);
+
 int open_l2g_nobs_sds(sds_t *nobs_sds_info, sds_t *nadd_obs_sds_info, sds_t *sds_info);
 
 #endif
@@ -28,4 +28,32 @@ typedef struct
   void *buf;
 } sds_attr_t;
 
+/* Compression of output SDS selected with the -compress option */
+typedef struct
+{
+  char name[MAX_SDS_NAME_LEN];  /* SDS name, empty for the default of all SDS */
+  comp_coder_t comp_type;       /* COMP_CODE_NONE, COMP_CODE_DEFLATE or COMP_CODE_SZIP */
+  int level;                    /* deflate level 1-9 */
+} sds_comp_t;
+
+/* A window of consecutive SDS rows buffered in the layout SDreaddata and
+   SDwritedata use for an edge of cur_nrows along the row dimension. */
+typedef struct
+{
+  sds_t *sds_info;
+  char mode;             /* 'R' read or 'W' write */
+  int row_dim;           /* index of the row dimension, -1 for a 1D SDS */
+  int nrows;             /* number of rows in the SDS */
+  int nseg;              /* number of layers stored ahead of the row dimension */
+  int seg_size;          /* bytes in one row of one layer */
+  int block_nrows;       /* maximum number of rows held in buf */
+  int chunk_nrows;       /* rows in one chunk row of a chunked SDS, 1 if not chunked */
+  int first_row;         /* first row held in buf, -1 if none */
+  int cur_nrows;         /* number of rows held in buf */
+  int lo_row, hi_row;    /* range of rows written into buf since the last flush */
+  int fill_size;         /* bytes in fill, 0 if blocks of fill are written */
+  char fill[8];          /* _FillValue of the SDS, written blocks of it are skipped */
+  void *buf;
+} sds_block_t;
+
 #endif
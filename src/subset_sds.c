@@ -433,11 +433,8 @@ void subset_an_sds(sds_t *in_sds_info, sds_t *out_sds_info, int *row_range, int
 {
   int i, k, irow, ncols; 
   int rank, bsq, st_c, offset;
-  int32 in_start[4] = {0, 0, 0, 0};
-  int32 in_edge[4] = {0, 0, 0, 0};
-  int32 out_start[4] = {0, 0, 0, 0};
-  int32 out_edge[4] = {0, 0, 0, 0};
   int32 attr_type, attr_cnt;
+  sds_block_t in_blk, out_blk;
   void *data_in, *data_out, *attr_val;
   int n, m, j, nrows, icol, ic;
   int start_row, start_col, end_row, end_col;
@@ -471,9 +468,6 @@ void subset_an_sds(sds_t *in_sds_info, sds_t *out_sds_info, int *row_range, int
 
   if (rank == 2)
     {
-      in_edge[0] = out_edge[0] = 1;
-      in_edge[1] = in_sds_info->dim_size[1];
-      out_edge[1] = ncols;
       out_sds_info->dim_size[0] = nrows;
       out_sds_info->dim_size[1] = ncols;
       ndata_sm_out = ncols;
@@ -491,16 +485,10 @@ void subset_an_sds(sds_t *in_sds_info, sds_t *out_sds_info, int *row_range, int
     }
   else if (rank > 2)
     {
-      for (i=0; i<rank; i++)
-	{
-	  in_edge[i] = out_edge[i] = in_sds_info->dim_size[i];
-	}
-      
       if ((n == -1) && (m == -1))
 	{
 	  if (bsq == 0)
 	    {
-	      in_edge[0] = out_edge[0] = 1;
 	      if ((row_range[0] > in_sds_info->dim_size[0]) ||
 		  (row_range[1] > in_sds_info->dim_size[0]) ||
 		  (col_range[0] > in_sds_info->dim_size[1]) ||
@@ -509,7 +497,6 @@ void subset_an_sds(sds_t *in_sds_info, sds_t *out_sds_info, int *row_range, int
 		  fprintf(stderr, "Input subsetting range is incorrect\n");
 		  exit(EXIT_FAILURE);
 		} 
-	      out_edge[1] = ncols;
 	      out_sds_info->dim_size[0] = nrows;
 	      out_sds_info->dim_size[1] = ncols; 
 	      if (rank == 3) 
@@ -527,7 +514,6 @@ void subset_an_sds(sds_t *in_sds_info, sds_t *out_sds_info, int *row_range, int
 	    }
 	  else
 	    {
-	      in_edge[rank-2] = out_edge[rank-2] = 1;
 	      if ((row_range[0] > in_sds_info->dim_size[rank-2]) ||
 		  (row_range[1] > in_sds_info->dim_size[rank-2]) ||
 		  (col_range[0] > in_sds_info->dim_size[rank-1]) ||
@@ -536,7 +522,6 @@ void subset_an_sds(sds_t *in_sds_info, sds_t *out_sds_info, int *row_range, int
 		  fprintf(stderr, "Input subsetting range is incorrect\n");
 		  exit(EXIT_FAILURE);
 		}      
-	      out_edge[rank-1] = ncols;
 	      out_sds_info->dim_size[rank-2] = nrows;
 	      out_sds_info->dim_size[rank-1] = ncols;
 	      if (rank == 3) 
@@ -581,20 +566,14 @@ void subset_an_sds(sds_t *in_sds_info, sds_t *out_sds_info, int *row_range, int
 	  free(attr_val);
 	}
 
-      if ((data_in != NULL) && (data_out != NULL))
+      in_blk.buf = out_blk.buf = NULL;
+      if ((data_in != NULL) && (data_out != NULL) &&
+	  (open_sds_block(in_sds_info, &in_blk, 'R', 1, 0L) != -1) &&
+	  (open_sds_block(out_sds_info, &out_blk, 'W', 1, 0L) != -1))
 	{
 	  for (irow = start_row; irow <end_row +1; irow++)
 	    {
-	      if ((rank == 2) || (bsq == 0))
-		{
-		  in_start[0] = irow;
-		}
-	      else
-		{
-		  in_start[rank - 2] = irow;
-		}
-	      
-	      if (SDreaddata( in_sds_info->sds_id, in_start, NULL, in_edge, data_in) == FAIL)
+	      if (read_sds_block_rows(&in_blk, irow, 1, data_in) == -1)
 		{
 		  fprintf(stderr, "Error reading SDS data line in subset_sds: %s", 
 			  in_sds_info->name);
@@ -678,18 +657,18 @@ void subset_an_sds(sds_t *in_sds_info, sds_t *out_sds_info, int *row_range, int
 		}
 
 	      	      
-	      if (SDwritedata(out_sds_info->sds_id, out_start, NULL, out_edge, data_out) == FAIL)
+	      if (write_sds_block_rows(&out_blk, irow - start_row, 1, data_out) == -1)
 		{
-		  fprintf(stderr,
-                     "Error writing data line " LONG_INT_FMT " to SDS %s in subset_sds",
-                     out_start[0],out_sds_info->name);
+		  fprintf(stderr, "Error writing data line %d to SDS %s in subset_sds",
+                     irow - start_row, out_sds_info->name);
 		  break;
 		}
-	      if ((rank > 2) && (bsq == 1))
-		++out_start[rank-2];
-	      else ++out_start[0];
 	    } /* for (irow */
+	  if (close_sds_block(&out_blk) == -1)
+	    fprintf(stderr, "Error writing data lines to SDS %s in subset_sds", out_sds_info->name);
 	}
+      if (in_blk.buf != NULL) close_sds_block(&in_blk);
+      if (out_blk.buf != NULL) close_sds_block(&out_blk);
       if (data_in != NULL) free(data_in);
       if (data_out != NULL) free(data_out);
     }
@@ -369,8 +369,7 @@ void transpose_an_sds(sds_t *in_sds_info, sds_t *out_sds_info)
   int irow, icol, iobs;
   int nrows, ncols, nobs;
   int i, bsq, rank, ndata;
-  int32 in_edge[4], out_edge[4]; 
-  int32 in_start[4], out_start[4]; 
+  sds_block_t in_blk, out_blk;
   void *data_in, *data_out;
 
   fprintf(stdout, "\tProcessing SDS %s\n", in_sds_info->name);
@@ -401,27 +400,14 @@ void transpose_an_sds(sds_t *in_sds_info, sds_t *out_sds_info)
     fprintf(stderr, "Cannot allocate memory for data_in in transpose_an_sds\n");
   if ((data_out = (void *)calloc(ndata, out_sds_info->data_size)) == NULL)
     fprintf(stderr, "Cannot allocate memory for data_out in transpose_an_sds\n");
-  if ((data_in != NULL) && (data_out != NULL))
+  in_blk.buf = out_blk.buf = NULL;
+  if ((data_in != NULL) && (data_out != NULL) &&
+      (open_sds_block(in_sds_info, &in_blk, 'R', 1, 0L) != -1) &&
+      (open_sds_block(out_sds_info, &out_blk, 'W', 1, 0L) != -1))
   {
-    for (i=0; i<rank; i++)
-    {
-      in_edge[i] = out_edge[i] = in_sds_info->dim_size[i];
-      in_start[i] = out_start[i] = 0;
-    }
-    if (bsq == 0) in_edge[0] = out_edge[0] = 1;
-    else in_edge[rank-2] = out_edge[rank-2] = 1;
-
     for (irow=0; irow<nrows; irow++)
     {
-      if (bsq == 1) { 
-	in_start[rank-2] = irow;
-	out_start[rank-2] = nrows - 1 - irow;
-      }
-      else {
-	in_start[0] = irow;
-	out_start[0] = nrows - 1- irow;
-      }
-      if (SDreaddata(in_sds_info->sds_id, in_start, NULL, in_edge, data_in) == FAIL)
+      if (read_sds_block_rows(&in_blk, irow, 1, data_in) == -1)
       {
         fprintf(stderr, "Cannot read data line %d from SDS %s in transpose_an_sds\n", irow, in_sds_info->name);
         break;
@@ -484,14 +470,18 @@ void transpose_an_sds(sds_t *in_sds_info, sds_t *out_sds_info)
 	    }
 	  } /* for (icol=0; . .  ) */
 	}
-        if (SDwritedata(out_sds_info->sds_id, out_start, NULL, out_edge, data_out) == FAIL)
+        if (write_sds_block_rows(&out_blk, nrows - 1 - irow, 1, data_out) == -1)
         {
           fprintf(stderr, "Cannot write data line %d to SDS %s in transpose_an_sds\n", irow, out_sds_info->name);
           break;
         }
       }
     } /* for (irow=0; . . .) */
+    if (close_sds_block(&out_blk) == -1)
+      fprintf(stderr, "Cannot write data lines to SDS %s in transpose_an_sds\n", out_sds_info->name);
   }
+  if (in_blk.buf != NULL) close_sds_block(&in_blk);
+  if (out_blk.buf != NULL) close_sds_block(&out_blk);
   if (data_in != NULL) free(data_in);
   if (data_out != NULL) free(data_out);
 }
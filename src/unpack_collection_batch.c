@@ -0,0 +1,373 @@
+#include <pthread.h>
+#include "unpack_collection_qa.h"
+#include "unpack_in.h"
+
+/* Scenes of a batch.  The jobs take the next scene from the list as soon as
+   they finish one, so long scenes don't hold up the others. */
+typedef struct
+{
+    char **infile;        /* input QA filename of each scene */
+    int nscenes;          /* number of scenes */
+    int next;             /* next scene to be taken by a job */
+    int nfailed;          /* number of scenes that failed */
+    pthread_mutex_t lock; /* protects next, nfailed and the status report */
+    char *out_pattern;    /* output name pattern, %s being the scene */
+    bool combine_bits;    /* should the QA bits be combined? */
+    Confidence_t *qa_conf;  /* confidence level of each quality field */
+    int nthreads;         /* number of unpack threads for each scene */
+    Out_opts_t *out_opts; /* compression and layout of the outputs */
+} Batch_t;
+
+/******************************************************************************
+MODULE:  make_out_name
+
+PURPOSE:  Build the output filename or base filename of a scene by replacing
+the %s of the output pattern with the scene name, the input filename (or tar
+bundle member) without its directory and extension.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The output name is too long
+SUCCESS         Processing was successful
+
+NOTES:
+1. get_args has already checked the pattern holds exactly one %s.
+******************************************************************************/
+static short make_out_name
+(
+    char *out_pattern,    /* I: output name pattern, %s being the scene */
+    char *infile,         /* I: input QA filename */
+    char out_name[STR_SIZE]   /* O: output name of the scene */
+)
+{
+    char FUNC_NAME[] = "make_out_name"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char *scene_name;        /* input filename without its directory */
+    char *ext;               /* extension of the input filename */
+    char *pct;               /* %s in the pattern */
+    int scene_len;           /* length of the scene name */
+
+    scene_name = get_qa_basename (infile);
+    ext = strrchr (scene_name, '.');
+    if (ext != NULL && ext != scene_name)
+        scene_len = ext - scene_name;
+    else
+        scene_len = strlen (scene_name);
+
+    pct = strstr (out_pattern, "%s");
+    if (strlen (out_pattern) - 2 + scene_len >= STR_SIZE)
+    {
+        sprintf (errmsg, "Output name for %s is too long", scene_name);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    sprintf (out_name, "%.*s%.*s%s", (int) (pct - out_pattern), out_pattern,
+        scene_len, scene_name, pct + 2);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  unpack_scene
+
+PURPOSE:  Unpack the QA band of one scene of the batch.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+static short unpack_scene
+(
+    Batch_t *batch,       /* I: batch */
+    char *infile          /* I: input QA filename of the scene */
+)
+{
+    bool qa_specd[NQUALITY_TYPES];  /* array to specify which of the QA bands
+                                       was specified for processing */
+    char out_name[STR_SIZE]; /* output filename or basename */
+    int satellite_number;    /* number of the satellite, e.g.: 8 */
+    const Qa_layout_t *layout;  /* bit layout of the QA band */
+
+    /* The satellite, and so the quality bands, depend on the scene */
+    if (get_scene_fields (infile, &satellite_number, qa_specd) != SUCCESS)
+        return (ERROR);
+    if (make_out_name (batch->out_pattern, infile, out_name) != SUCCESS)
+        return (ERROR);
+
+    layout = get_collection_layout (satellite_number);
+    if (batch->out_opts->points != OUT_PTS_NONE)
+        return (extract_qa_points (infile, out_name, layout, qa_specd,
+            batch->qa_conf, batch->out_opts));
+    else if (batch->out_opts->estimate)
+        return (estimate_qa_cover (infile, out_name, layout, qa_specd,
+            batch->qa_conf, batch->out_opts));
+    else if (batch->out_opts->stats_only)
+        return (unpack_qa_stats (infile, out_name, layout, batch->qa_conf,
+            batch->nthreads, batch->out_opts));
+    else if (batch->out_opts->multiband)
+        return (unpack_multiband_bits (infile, out_name, layout, qa_specd,
+            batch->qa_conf, batch->nthreads, batch->out_opts));
+    else if (!batch->combine_bits)
+        return (unpack_bits (infile, out_name, layout, qa_specd,
+            batch->qa_conf, batch->nthreads, batch->out_opts));
+    else
+        return (unpack_combine_bits (infile, out_name, layout, qa_specd,
+            batch->qa_conf, batch->nthreads, batch->out_opts));
+}
+
+
+/******************************************************************************
+MODULE:  batch_job
+
+PURPOSE:  Unpack scenes of the batch until none are left, reporting the
+status of each one.
+
+RETURN VALUE:
+Type = void *
+Value           Description
+-----           -----------
+NULL            Always
+
+NOTES:
+1. The pipeline buffers of the job are reused from one scene to the next.
+******************************************************************************/
+static void *batch_job
+(
+    void *arg             /* I: batch */
+)
+{
+    Batch_t *batch = (Batch_t *) arg;
+    short status;            /* status of the scene */
+    int scene;               /* scene taken by this job */
+
+    keep_pipeline_buffers (true);
+    while (1)
+    {
+        pthread_mutex_lock (&batch->lock);
+        scene = batch->next++;
+        pthread_mutex_unlock (&batch->lock);
+        if (scene >= batch->nscenes)
+            break;
+
+        status = unpack_scene (batch, batch->infile[scene]);
+
+        pthread_mutex_lock (&batch->lock);
+        if (status != SUCCESS)
+            batch->nfailed++;
+        printf ("Scene %d of %d %s: %s\n", scene + 1, batch->nscenes,
+            batch->infile[scene], status == SUCCESS ? "SUCCESS" : "ERROR");
+        fflush (stdout);
+        pthread_mutex_unlock (&batch->lock);
+    }
+    free_pipeline_buffers ();
+
+    return (NULL);
+}
+
+
+/******************************************************************************
+MODULE:  run_batch
+
+PURPOSE:  Unpack the QA band of each scene in the batch list, running njobs
+scenes at once.  A scene that fails doesn't stop the others.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The list couldn't be read or a scene failed
+SUCCESS         All the scenes were unpacked
+
+NOTES:
+1. Each scene uses nthreads unpack threads of its own.
+******************************************************************************/
+short run_batch
+(
+    char *batch_file,     /* I: file listing the input QA filenames */
+    char *out_pattern,    /* I: output name pattern, %s being the scene */
+    int njobs,            /* I: number of scenes processed at once */
+    bool combine_bits,    /* I: should the QA bits be combined? */
+    Confidence_t qa_conf[NQUALITY_TYPES],
+                          /* I: array to specify the confidence level for
+                                each of the quality fields */
+    int nthreads,         /* I: number of unpack threads for each scene */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    char FUNC_NAME[] = "run_batch"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    short status = SUCCESS;  /* return status */
+    int i;                   /* looping variable */
+    int nstarted = 0;        /* number of job threads started */
+    Batch_t batch;           /* batch of scenes */
+    pthread_t *thread = NULL;  /* job threads */
+
+    memset (&batch, 0, sizeof (batch));
+    batch.out_pattern = out_pattern;
+    batch.combine_bits = combine_bits;
+    batch.qa_conf = qa_conf;
+    batch.nthreads = nthreads;
+    batch.out_opts = out_opts;
+
+    status = read_qa_list (batch_file, &batch.infile, &batch.nscenes);
+    if (status == SUCCESS)
+    {
+        printf ("Batch of %d scenes, %d at a time\n", batch.nscenes,
+            njobs < batch.nscenes ? njobs : batch.nscenes);
+        fflush (stdout);
+
+        /* Register the GeoTIFF tags before the jobs open any files */
+        XTIFFInitialize ();
+        pthread_mutex_init (&batch.lock, NULL);
+
+        if (njobs > batch.nscenes)
+            njobs = batch.nscenes;
+        if (njobs > 1)
+        {
+            thread = (pthread_t *) calloc (njobs - 1, sizeof (pthread_t));
+            if (thread == NULL)
+            {
+                sprintf (errmsg, "Error allocating memory for the batch "
+                    "jobs");
+                error_handler (true, FUNC_NAME, errmsg);
+                status = ERROR;
+            }
+            for (i = 0; i < njobs - 1 && status == SUCCESS; i++)
+            {
+                if (pthread_create (&thread[i], NULL, batch_job, &batch) != 0)
+                {
+                    sprintf (errmsg, "Error starting the batch jobs");
+                    error_handler (true, FUNC_NAME, errmsg);
+                    status = ERROR;
+                    break;
+                }
+                nstarted++;
+            }
+        }
+
+        /* The calling thread is one of the jobs.  If a job couldn't be
+           started, the started ones still finish the batch. */
+        batch_job (&batch);
+        for (i = 0; i < nstarted; i++)
+            pthread_join (thread[i], NULL);
+        pthread_mutex_destroy (&batch.lock);
+
+        printf ("Batch complete: %d of %d scenes unpacked\n",
+            batch.nscenes - batch.nfailed, batch.nscenes);
+        if (batch.nfailed > 0)
+            status = ERROR;
+    }
+
+    for (i = 0; i < batch.nscenes; i++)
+        free (batch.infile[i]);
+    free (batch.infile);
+    free (thread);
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  run_freq
+
+PURPOSE:  Count the quality fields of the stack of scenes in the frequency
+list into the frequency and valid observation count outputs.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. Each scene sets up its quality bands from its own satellite, and every
+   scene must have each field requested on the command line: --cirrus and
+   --terrain_occl need all the scenes to be Landsat 8, and --drop_pixel all
+   of them to be Landsat 4-7, or the run fails.  A field is counted when it
+   is set up in every scene at the same bits, so with the default of all
+   the fields a stack of mixed satellites counts the fields they share.
+2. The fill field tells the valid observations and isn't counted.
+******************************************************************************/
+short run_freq
+(
+    char *freq_file,      /* I: file listing the input QA filenames */
+    char *qa_outfile,     /* I: output base filename */
+    Confidence_t qa_conf[NQUALITY_TYPES],
+                          /* I: array to specify the confidence level for
+                                each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    short status = SUCCESS;  /* return status */
+    int i;                   /* looping variable for the fields */
+    int scene;               /* looping variable for the scenes */
+    int nscenes = 0;         /* number of scenes */
+    int satellite_number;    /* number of the satellite of a scene */
+    char **infile = NULL;    /* input QA filename of each scene */
+    bool qa_specd[NQUALITY_TYPES];  /* fields counted in the stack */
+    bool scene_specd[NQUALITY_TYPES];  /* fields set up in a scene */
+    const Qa_layout_t *layout = NULL;  /* bit layout of the first scene */
+    const Qa_layout_t *scene_layout;   /* bit layout of a scene */
+
+    status = read_qa_list (freq_file, &infile, &nscenes);
+
+    /* Keep the fields every scene has at the bits of the first scene */
+    for (scene = 0; status == SUCCESS && scene < nscenes; scene++)
+    {
+        if (get_scene_fields (infile[scene], &satellite_number, scene_specd)
+            != SUCCESS)
+        {
+            status = ERROR;
+            break;
+        }
+        scene_layout = get_collection_layout (satellite_number);
+        if (scene == 0)
+        {
+            layout = scene_layout;
+            for (i = 0; i < NQUALITY_TYPES; i++)
+                qa_specd[i] = scene_specd[i] && i != FILL;
+        }
+        for (i = 0; i < NQUALITY_TYPES; i++)
+        {
+            if (qa_specd[i] && (!scene_specd[i] ||
+                scene_layout->field[i].name == NULL ||
+                strcmp (scene_layout->field[i].name, layout->field[i].name) ||
+                scene_layout->field[i].shift != layout->field[i].shift ||
+                scene_layout->field[i].mask != layout->field[i].mask))
+            {
+                printf ("Quality field %s isn't in %s, so it isn't "
+                    "counted\n", layout->field[i].name, infile[scene]);
+                qa_specd[i] = false;
+            }
+        }
+    }
+
+    if (status == SUCCESS)
+    {
+        printf ("Stack of %d scenes\n", nscenes);
+        for (i = 0; i < NQUALITY_TYPES; i++)
+        {
+            if (qa_specd[i])
+                printf ("    %s\n", layout->field[i].name);
+        }
+        fflush (stdout);
+        status = unpack_qa_freq (infile, nscenes, qa_outfile, layout,
+            qa_specd, qa_conf, nthreads, out_opts);
+    }
+
+    for (scene = 0; scene < nscenes; scene++)
+        free (infile[scene]);
+    free (infile);
+
+    return (status);
+}
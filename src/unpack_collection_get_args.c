@@ -1,6 +1,19 @@
 #include <getopt.h>
 #include "unpack_collection_qa.h"
 
+/* Quality band flags, kept at file scope so each scene of a batch can set up
+   its quality bands from them (see get_scene_fields) */
+static int all_flag=false;           /* all quality bands flag */
+static int fill_flag=false;          /* fill band flag */
+static int drop_pixel_flag=false;    /* L4-7 dropped pixel band flag */
+static int terrain_occl_flag=false;  /* L8 terrain occlusion band flag */
+static int radiometric_sat_flag=false; /* radiometric saturation band flag */
+static int cloud_flag=false;         /* cloud band flag */
+static int cloud_confidence_flag=false; /* cloud confidence band flag */
+static int cloud_shadow_flag=false;  /* cloud shadow band flag */
+static int snow_ice_flag=false;      /* snow/ice confidence band flag */
+static int cirrus_flag=false;        /* cirrus confidence band flag */
+
 /******************************************************************************
 MODULE:  get_args
 
@@ -24,9 +37,12 @@ Date        Programmer       Reason
 8/31/2016   Ray Dittmeier    Original Development based on unpack_oli_get_args.c
 
 NOTES:
-  1. Memory is allocated for the input and output files.  All of these should
-     be character pointers set to NULL on input.  The caller is responsible
-     for freeing the allocated memory upon successful return.
+  1. Memory is allocated for the input and output files, the batch list file,
+     the output pattern and the frequency list file.  All of these should be
+     character pointers set to NULL on input.  The caller is responsible for
+     freeing the allocated memory upon successful return.
+  2. In batch and frequency modes the satellite number and the quality bands
+     depend on each scene, so they are left for get_scene_fields.
 ******************************************************************************/
 short get_args
 (
@@ -36,30 +52,28 @@ short get_args
     int *satellite_number, /* O: number of the satellite, e.g.: 8 */
     char **infile,        /* O: address of input filename */
     char **outfile,       /* O: address of output filename or base filename */
+    char **batch_file,    /* O: address of the batch list filename */
+    char **out_pattern,   /* O: address of the batch output name pattern */
+    int *njobs,           /* O: number of scenes processed at once in batch
+                                mode */
+    char **freq_file,     /* O: address of the frequency list filename */
     bool qa_specd[NQUALITY_TYPES],  /* O: array to specify which of the QA
                                           bands was specified for processing */
-    Confidence_t qa_conf[NQUALITY_TYPES]
+    Confidence_t qa_conf[NQUALITY_TYPES],
                           /* O: array to specify the confidence level for
                                 each of the quality fields */
+    int *nthreads,        /* O: number of unpack threads */
+    Out_opts_t *out_opts  /* O: compression and layout of the outputs */
 )
 {
     int c;                               /* current argument index */
     int option_index;                    /* index for command-line option */
-    int i;                               /* looping variable */
     static int combine_flag=false;       /* all quality bands flag */
-    static int all_flag=false;           /* all quality bands flag */
-    static int fill_flag=false;          /* fill band flag */
-    static int drop_pixel_flag=false;    /* L4-7 dropped pixel band flag */
-    static int terrain_occl_flag=false;  /* L8 terrain occlusion band flag */
-    static int radiometric_sat_flag=false; /* radiometric saturation band 
-                                            flag */
-    static int cloud_flag=false;         /* cloud band flag */
-    static int cloud_confidence_flag=false; /* cloud confidence band flag */
-    static int cloud_shadow_flag=false;  /* cloud shadow band flag */
-    static int snow_ice_flag=false;      /* snow/ice confidence band flag */
-    static int cirrus_flag=false;        /* cirrus confidence band flag */
+    static int tiled_flag=false;         /* tiled output flag */
+    static int packed_flag=false;        /* packed output flag */
+    static int stats_only_flag=false;    /* statistics only flag */
     char errmsg[STR_SIZE];               /* error message */
-    char satellite_number_str[3];        /* String for the satellite number */
+    char *pct;                           /* conversion in the output pattern */
 
     char FUNC_NAME[] = "get_args";       /* function name */
 
@@ -78,10 +92,36 @@ short get_args
         {"cirrus", optional_argument, 0, 'r'},
         {"ifile", required_argument, 0, 'i'},
         {"ofile", required_argument, 0, 'o'},
+        {"threads", required_argument, 0, 't'},
+        {"compress", required_argument, 0, 'z'},
+        {"tiled", no_argument, &tiled_flag, true},
+        {"packed", no_argument, &packed_flag, true},
+        {"tile_size", required_argument, 0, 'x'},
+        {"strip_lines", required_argument, 0, 'l'},
+        {"multiband", required_argument, 0, 'm'},
+        {"overviews", optional_argument, 0, 'O'},
+        {"window", required_argument, 0, 'W'},
+        {"map_window", required_argument, 0, 'M'},
+        {"points", required_argument, 0, 'P'},
+        {"pixel_points", required_argument, 0, 'X'},
+        {"stats", required_argument, 0, 'S'},
+        {"stats_only", no_argument, &stats_only_flag, true},
+        {"estimate", optional_argument, 0, 'e'},
+        {"expr", required_argument, 0, 'q'},
+        {"batch", required_argument, 0, 'b'},
+        {"opattern", required_argument, 0, 'p'},
+        {"jobs", required_argument, 0, 'j'},
+        {"freq", required_argument, 0, 'f'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
+    /* Default to unpacking on the calling thread and to uncompressed,
+       stripped output */
+    *nthreads = 1;
+    *njobs = 1;
+    init_out_opts (out_opts);
+
     /* Initialize the confidence levels for the QA fields.  Single bit QA
        fields will be undefined.  The two-bit fields will be medium. */
     qa_conf[FILL] = UNDEFINED;
@@ -125,6 +165,147 @@ short get_args
                 *outfile = strdup (optarg);
                 break;
      
+            case 't':  /* threads */
+                *nthreads = atoi (optarg);
+                if (*nthreads < 1)
+                {
+                    sprintf (errmsg, "Number of threads must be at least 1 "
+                        "but %s was specified", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'z':  /* compress */
+                if (parse_out_compress (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'x':  /* tile_size */
+                tiled_flag = true;
+                out_opts->tile_size = atoi (optarg);
+                if (atoi (optarg) < 16 || out_opts->tile_size % 16 != 0)
+                {
+                    sprintf (errmsg, "Tile size must be a positive multiple "
+                        "of 16 but %s was specified", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'l':  /* strip_lines */
+                out_opts->strip_lines = atoi (optarg);
+                if (atoi (optarg) < 1)
+                {
+                    sprintf (errmsg, "Lines per strip must be at least 1 "
+                        "but %s was specified", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'm':  /* multiband */
+                if (parse_out_multiband (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'O':  /* overviews */
+                if (parse_out_overviews (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'W':  /* window */
+                if (parse_out_window (optarg, OUT_WIN_PIXEL, out_opts)
+                    != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'M':  /* map_window */
+                if (parse_out_window (optarg, OUT_WIN_MAP, out_opts)
+                    != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'P':  /* points */
+                if (parse_out_points (optarg, OUT_PTS_MAP, out_opts)
+                    != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'X':  /* pixel_points */
+                if (parse_out_points (optarg, OUT_PTS_PIXEL, out_opts)
+                    != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'S':  /* stats */
+                if (parse_out_stats (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'e':  /* estimate */
+                if (parse_out_estimate (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'q':  /* expr */
+                out_opts->qa_expr = strdup (optarg);
+                break;
+     
+            case 'b':  /* batch */
+                *batch_file = strdup (optarg);
+                break;
+     
+            case 'p':  /* opattern */
+                *out_pattern = strdup (optarg);
+                break;
+     
+            case 'j':  /* jobs */
+                *njobs = atoi (optarg);
+                if (*njobs < 1)
+                {
+                    sprintf (errmsg, "Number of jobs must be at least 1 "
+                        "but %s was specified", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'f':  /* freq */
+                *freq_file = strdup (optarg);
+                break;
+     
             case 'a':  /* all */
                 all_flag = true;
                 /* Validate the confidence argument.  Default of medium is
@@ -250,33 +431,211 @@ short get_args
         }
     }
 
-    /* Make sure the infiles and outfiles were specified */
-    if (*infile == NULL)
+    /* In batch mode the input and output names come from the list and the
+       output pattern, otherwise make sure the infiles and outfiles were
+       specified.  In frequency mode the input names come from the list. */
+    if (*batch_file != NULL && *freq_file != NULL)
+    {
+        sprintf (errmsg, "Batch and frequency lists can't both be specified");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+    else if (*batch_file != NULL)
+    {
+        if (*infile != NULL || *outfile != NULL)
+        {
+            sprintf (errmsg, "Input and output QA files can't be specified "
+                "in batch mode");
+            error_handler (true, FUNC_NAME, errmsg);
+            usage ();
+            return (ERROR);
+        }
+
+        if (*out_pattern == NULL)
+        {
+            sprintf (errmsg, "Output pattern is a required argument in "
+                "batch mode");
+            error_handler (true, FUNC_NAME, errmsg);
+            usage ();
+            return (ERROR);
+        }
+
+        /* The pattern holds one %s for the scene name and no other
+           conversions */
+        pct = strchr (*out_pattern, '%');
+        if (pct == NULL || pct[1] != 's' || strchr (pct + 1, '%') != NULL)
+        {
+            sprintf (errmsg, "Output pattern %s must hold exactly one %%s "
+                "for the scene name", *out_pattern);
+            error_handler (true, FUNC_NAME, errmsg);
+            usage ();
+            return (ERROR);
+        }
+    }
+    else
+    {
+        if (*out_pattern != NULL || *njobs != 1)
+        {
+            sprintf (errmsg, "Output pattern and jobs are only used in batch "
+                "mode");
+            error_handler (true, FUNC_NAME, errmsg);
+            usage ();
+            return (ERROR);
+        }
+
+        if (*freq_file != NULL && *infile != NULL)
+        {
+            sprintf (errmsg, "Input QA file can't be specified in frequency "
+                "mode");
+            error_handler (true, FUNC_NAME, errmsg);
+            usage ();
+            return (ERROR);
+        }
+
+        if (*freq_file == NULL && *infile == NULL)
+        {
+            sprintf (errmsg, "Input QA file is a required argument");
+            error_handler (true, FUNC_NAME, errmsg);
+            usage ();
+            return (ERROR);
+        }
+
+        if (*outfile == NULL)
+        {
+            sprintf (errmsg, "Unpacked bits output base QA file is a "
+                "required argument");
+            error_handler (true, FUNC_NAME, errmsg);
+            usage ();
+            return (ERROR);
+        }
+    }
+
+    /* Check if the bits are to be combined, as they always are into the
+       result of a QA expression */
+    *combine_bits = false;
+    if (combine_flag || out_opts->qa_expr != NULL)
+        *combine_bits = true;
+
+    /* Check if the output is to be tiled */
+    out_opts->tiled = false;
+    if (tiled_flag)
+        out_opts->tiled = true;
+
+    /* Check if the output samples are to be packed */
+    out_opts->packed = false;
+    if (packed_flag)
+        out_opts->packed = true;
+
+    /* Multiband output holds each quality field in its own 8-bit band */
+    if (out_opts->multiband && (*combine_bits || out_opts->packed))
+    {
+        sprintf (errmsg, "Multiband output can't be combined or packed");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    /* Check if only the statistics are to be written, by default as JSON */
+    out_opts->stats_only = false;
+    if (stats_only_flag)
     {
-        sprintf (errmsg, "Input QA file is a required argument");
+        out_opts->stats_only = true;
+        if (out_opts->stats_format == OUT_STATS_NONE)
+            out_opts->stats_format = OUT_STATS_JSON;
+    }
+
+    /* The cover estimate is written in the statistics format, by default as
+       JSON */
+    if (out_opts->estimate && out_opts->stats_format == OUT_STATS_NONE)
+        out_opts->stats_format = OUT_STATS_JSON;
+
+    /* Points are extracted from the whole QA band into a sidecar written in
+       the statistics format, by default as JSON */
+    if (out_opts->points != OUT_PTS_NONE && (*freq_file != NULL ||
+        out_opts->window != OUT_WIN_NONE || out_opts->estimate ||
+        out_opts->stats_only || out_opts->multiband || *combine_bits ||
+        out_opts->packed))
+    {
+        sprintf (errmsg, "Points can't be extracted in frequency mode, from "
+            "a window, or with estimates, statistics or unpacked outputs "
+            "options");
         error_handler (true, FUNC_NAME, errmsg);
         usage ();
         return (ERROR);
     }
+    if (out_opts->points != OUT_PTS_NONE &&
+        out_opts->stats_format == OUT_STATS_NONE)
+        out_opts->stats_format = OUT_STATS_JSON;
 
-    if (*outfile == NULL)
+    /* The frequency outputs are one 8-bit file per quality field */
+    if (*freq_file != NULL && (*combine_bits || out_opts->packed ||
+        out_opts->multiband || out_opts->stats_format != OUT_STATS_NONE ||
+        out_opts->estimate))
     {
-        sprintf (errmsg, "Unpacked bits output base QA file is a required "
-            "argument");
+        sprintf (errmsg, "Frequency mode can't be combined, packed, "
+            "multiband, or write statistics or estimates");
         error_handler (true, FUNC_NAME, errmsg);
         usage ();
         return (ERROR);
     }
 
+    /* Each scene of a batch or frequency list sets up its own quality
+       bands */
+    if (*batch_file != NULL || *freq_file != NULL)
+        return (SUCCESS);
+
+    return (get_scene_fields (*infile, satellite_number, qa_specd));
+}
+
+
+/******************************************************************************
+MODULE:  get_scene_fields
+
+PURPOSE:  Gets the satellite number of a scene from its QA filename and sets
+up which of its quality bands are processed, from the quality band flags of
+the command line.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The filename doesn't follow the Landsat collection format or
+                a quality band isn't supported for the satellite
+SUCCESS         No errors encountered
+
+NOTES:
+  1. Called after get_args, from one thread per scene in batch mode, so it
+     must not modify the quality band flags.
+******************************************************************************/
+short get_scene_fields
+(
+    char *infile,         /* I: input QA filename */
+    int *satellite_number, /* O: number of the satellite, e.g.: 8 */
+    bool qa_specd[NQUALITY_TYPES]   /* O: array to specify which of the QA
+                                          bands was specified for processing */
+)
+{
+    int i;                               /* looping variable */
+    bool all_bands;                      /* all quality bands are processed */
+    char *scene_name;                    /* input filename (or tar bundle
+                                            member) without its directory */
+    char errmsg[STR_SIZE];               /* error message */
+    char satellite_number_str[3];        /* String for the satellite number */
+
+    char FUNC_NAME[] = "get_scene_fields";  /* function name */
+
     /* Assume the input file follows the Landsat product identifier format.
        In the collection era, that starts with LXSS, where SS is the satellite
        number.  Extract the satellite number */
-    strncpy(satellite_number_str, *infile + 2,
+    scene_name = get_qa_basename (infile);
+    strncpy(satellite_number_str, scene_name + 2,
         sizeof(satellite_number_str) - 1);
     satellite_number_str[2] = '\0';
     *satellite_number = atoi(satellite_number_str);
-    if (*satellite_number != 4 && *satellite_number != 5 &&
-        *satellite_number != 7 && *satellite_number != 8)
+    if (strlen (scene_name) < 4 || (*satellite_number != 4 &&
+        *satellite_number != 5 && *satellite_number != 7 &&
+        *satellite_number != 8))
     {
         sprintf (errmsg, "Error with filename format: the filename should "
             "adhere to the Landsat collection filename format with satellite "
@@ -313,26 +672,22 @@ short get_args
         }
     }
 
-    /* Check if the bits are to be combined */
-    *combine_bits = false;
-    if (combine_flag)
-        *combine_bits = true;
-
-    /* If none of the quality band flags were specified, then set the all_flag
-       to true as the default */
+    /* If none of the quality band flags were specified, then process all
+       the quality bands as the default */
+    all_bands = all_flag;
     if (*satellite_number == 8)
     {
         if (!all_flag && !fill_flag && !terrain_occl_flag &&
             !radiometric_sat_flag && !cloud_flag && !cloud_confidence_flag &&
             !cloud_shadow_flag && !snow_ice_flag && !cirrus_flag)
-            all_flag = true;
+            all_bands = true;
     }
     else
     {
         if (!all_flag && !fill_flag && !drop_pixel_flag &&
             !radiometric_sat_flag && !cloud_flag && !cloud_confidence_flag &&
             !cloud_shadow_flag && !snow_ice_flag)
-            all_flag = true;
+            all_bands = true;
     }
 
     /* Initialize the QA array to false */
@@ -341,7 +696,7 @@ short get_args
 
     /* If the all flag was specified, then turn all the quality bands on for
        processing */
-    if (all_flag)
+    if (all_bands)
     {
         qa_specd[FILL] = true;
         qa_specd[OCCLUSION_OR_DROPPED] = true;
@@ -34,27 +34,93 @@ int main (int argc, char *argv[])
                                        level for each of the quality fields */
     char *qa_infile=NULL;    /* input QA filename */
     char *qa_outfile=NULL;   /* output QA filename or basename */
+    char *batch_file=NULL;   /* batch list filename */
+    char *out_pattern=NULL;  /* batch output name pattern */
+    char *freq_file=NULL;    /* frequency list filename */
     char tmp_char;           /* temporary character for each QA band */
     int retval;              /* return status */
     int satellite_number = 0; /* number of the satellite, e.g.: 8 */
+    int nthreads;            /* number of unpack threads */
+    int njobs;               /* number of scenes processed at once */
+    Out_opts_t out_opts;     /* compression and layout of the outputs */
+    const Qa_layout_t *layout;  /* bit layout of the QA band */
 
     printf ("Unpack of QA band started ...\n");
 
     /* Read the command-line arguments to determine which file needs to be
        processed and which quality bands will be dumped */
     retval = get_args (argc, argv, &combine_bits, &satellite_number, 
-        &qa_infile, &qa_outfile, qa_specd, qa_conf);
+        &qa_infile, &qa_outfile, &batch_file, &out_pattern, &njobs,
+        &freq_file, qa_specd, qa_conf, &nthreads, &out_opts);
     if (retval != SUCCESS)
     {   /* get_args already printed the error message */
         exit (ERROR);
     }
 
+    /* Unpack each scene of the batch list, reporting the status of each */
+    if (batch_file != NULL)
+    {
+        printf ("QA batch list: %s\n", batch_file);
+        printf ("Unpacked QA output pattern: %s\n", out_pattern);
+        if (out_opts.points != OUT_PTS_NONE)
+            printf ("QA points file: %s\n", out_opts.points_file);
+        if (out_opts.qa_expr != NULL)
+            printf ("QA expression of the combined output: %s\n",
+                out_opts.qa_expr);
+        retval = run_batch (batch_file, out_pattern, njobs, combine_bits,
+            qa_conf, nthreads, &out_opts);
+        free (batch_file);
+        free (out_pattern);
+        if (out_opts.qa_expr != NULL)
+            free (out_opts.qa_expr);
+        if (out_opts.points_file != NULL)
+            free (out_opts.points_file);
+        if (retval != SUCCESS)
+        {   /* run_batch already reported the failed scenes */
+            exit (ERROR);
+        }
+        printf ("Unpack of QA band complete!\n");
+        exit (SUCCESS);
+    }
+
+    /* Count the quality fields of each pixel over the scenes of the
+       frequency list */
+    if (freq_file != NULL)
+    {
+        printf ("QA frequency list: %s\n", freq_file);
+        printf ("QA frequency output basename: %s\n", qa_outfile);
+        retval = run_freq (freq_file, qa_outfile, qa_conf, nthreads,
+            &out_opts);
+        free (freq_file);
+        free (qa_outfile);
+        if (retval != SUCCESS)
+        {   /* run_freq already printed the error message */
+            exit (ERROR);
+        }
+        printf ("Unpack of QA band complete!\n");
+        exit (SUCCESS);
+    }
+
     /* Tell the user which bands will be unpacked */
     printf ("QA input file: %s\n", qa_infile);
-    if (!combine_bits)
+    if (out_opts.points != OUT_PTS_NONE)
+    {
+        printf ("QA points file: %s\n", out_opts.points_file);
+        printf ("QA points output basename: %s\n", qa_outfile);
+    }
+    else if (out_opts.estimate)
+        printf ("QA cover estimate output basename: %s\n", qa_outfile);
+    else if (out_opts.stats_only)
+        printf ("QA statistics output basename: %s\n", qa_outfile);
+    else if (out_opts.multiband)
+        printf ("Unpacked multiband QA output filename: %s\n", qa_outfile);
+    else if (!combine_bits)
         printf ("Unpacked QA output file basename: %s\n", qa_outfile);
     else
         printf ("Unpacked and combined QA output filename: %s\n", qa_outfile);
+    if (out_opts.qa_expr != NULL)
+        printf ("QA expression of the combined output: %s\n",
+            out_opts.qa_expr);
     printf ("Process    Description\n"
             "-------    -----------\n");
     if (qa_specd[FILL])
@@ -118,11 +184,52 @@ int main (int argc, char *argv[])
 
     /* Read the input QA band, unpack the bits, combine if specified, and
        write out the desired band(s) */
-    if (!combine_bits)
+    layout = get_collection_layout (satellite_number);
+    if (out_opts.points != OUT_PTS_NONE)
+    {
+        /* Only extract the quality fields at the points */
+        retval = extract_qa_points (qa_infile, qa_outfile, layout, qa_specd,
+            qa_conf, &out_opts);
+        if (retval != SUCCESS)
+        {   /* extract_qa_points already printed the error message */
+            exit (ERROR);
+        }
+    }
+    else if (out_opts.estimate)
+    {
+        /* Only estimate the cover of the quality fields from a sample */
+        retval = estimate_qa_cover (qa_infile, qa_outfile, layout, qa_specd,
+            qa_conf, &out_opts);
+        if (retval != SUCCESS)
+        {   /* estimate_qa_cover already printed the error message */
+            exit (ERROR);
+        }
+    }
+    else if (out_opts.stats_only)
+    {
+        /* Only gather the statistics of the QA band */
+        retval = unpack_qa_stats (qa_infile, qa_outfile, layout, qa_conf,
+            nthreads, &out_opts);
+        if (retval != SUCCESS)
+        {   /* unpack_qa_stats already printed the error message */
+            exit (ERROR);
+        }
+    }
+    else if (out_opts.multiband)
+    {
+        /* Unpack the bits into the bands of one file */
+        retval = unpack_multiband_bits (qa_infile, qa_outfile, layout,
+            qa_specd, qa_conf, nthreads, &out_opts);
+        if (retval != SUCCESS)
+        {   /* unpack_multiband_bits already printed the error message */
+            exit (ERROR);
+        }
+    }
+    else if (!combine_bits)
     {
         /* Unpack the bits into individual bands */
-        retval = unpack_bits (qa_infile, qa_outfile, qa_specd, qa_conf,
-            satellite_number);
+        retval = unpack_bits (qa_infile, qa_outfile, layout, qa_specd,
+            qa_conf, nthreads, &out_opts);
         if (retval != SUCCESS)
         {   /* unpack_bits already printed the error message */
             exit (ERROR);
@@ -131,19 +238,23 @@ int main (int argc, char *argv[])
     else
     {
         /* Unpack the bits and combine into one band */
-        retval = unpack_combine_bits (qa_infile, qa_outfile, qa_specd, qa_conf,
-            satellite_number);
+        retval = unpack_combine_bits (qa_infile, qa_outfile, layout,
+            qa_specd, qa_conf, nthreads, &out_opts);
         if (retval != SUCCESS)
         {   /* unpack_bits already printed the error message */
             exit (ERROR);
         }
     }
 
-    /* Free the filename pointers */
+    /* Free the filename pointers and the QA expression */
     if (qa_infile != NULL)
         free (qa_infile);
     if (qa_outfile != NULL)
         free (qa_outfile);
+    if (out_opts.qa_expr != NULL)
+        free (out_opts.qa_expr);
+    if (out_opts.points_file != NULL)
+        free (out_opts.points_file);
 
     /* Indicate successful completion of processing */
     printf ("Unpack of QA band complete!\n");
@@ -250,21 +361,130 @@ void usage ()
             "[--all=conf_level][--fill][--drop_pixel][--terrain_occl] "
             "[--radiometric_sat][--cloud][--cloud_confidence=conf_level] "
             "[--cloud_shadow=conf_level][--snow_ice=conf_level] "
-            "[--cirrus=conf_level] [--combine]\n");
+            "[--cirrus=conf_level] [--combine] [--threads=nthreads] "
+            "[--compress=type] [--tiled] [--tile_size=n] [--strip_lines=n] "
+            "[--packed] [--multiband=interleave] [--overviews=reduction] "
+            "[--window=line,samp,nlines,nsamps] "
+            "[--map_window=ulx,uly,lrx,lry] "
+            "[--points=file] [--pixel_points=file] "
+            "[--stats=format] [--stats_only] [--estimate=margin] "
+            "[--expr=expression]\n");
+    printf ("usage: unpack_collection_qa "
+            "--batch=QA_list_filename "
+            "--opattern=output_name_pattern [--jobs=njobs] "
+            "[QA bit and output parameters as above]\n");
+    printf ("usage: unpack_collection_qa "
+            "--freq=QA_list_filename "
+            "--ofile=output_frequency_basename "
+            "[QA bit, threads, layout and overview parameters as above]\n");
     printf ("\nwhere --drop_pixel is only available for Landsat 4-7 files\n"
             "and --terrain_occl and --cirrus are only available for Landsat 8\n"
             "files\n");
     printf ("\nwhere the following parameters are required:\n");
     printf ("    -ifile: name of the input QA file (GeoTIFF product with "
             "uint16 bands).  The name should follow the Landsat collection "
-            "filename format\n");
+            "filename format.  A QA file in a tar bundle is read without "
+            "extracting the bundle when named as bundle.tar:member, "
+            "bundle.tar.gz:member or bundle.tgz:member, the member name "
+            "following the collection format.\n");
     printf ("    -ofile: basename of the output unpacked QA file if not "
             "combining the QA bits, otherwise the full filename of the output "
             "file if combining the QA bits (GeoTIFF products with uint8 bands "
             "to match the user-specified quality bits)\n");
+    printf ("\nor, to unpack many scenes, the following parameters are "
+            "required in place of -ifile and -ofile:\n");
+    printf ("    -batch: name of a text file listing the input QA files, one "
+            "per line.  Blank lines and lines starting with # are "
+            "skipped.\n");
+    printf ("    -opattern: output name of each scene, its one %%s being "
+            "replaced by the input QA filename without its directory and "
+            "extension.  It is the basename or the full filename of the "
+            "outputs, as -ofile is.\n");
+    printf ("\nor, to count how often each quality field is flagged over a "
+            "stack of scenes, the following parameters are required in place "
+            "of -ifile:\n");
+    printf ("    -freq: name of a text file listing the input QA files of "
+            "the stack, one per line, as -batch.  The scenes must be the same "
+            "size and line up.  They are streamed a band of lines at a time, "
+            "each band counted on one unpack thread, without any "
+            "intermediate files.\n");
+    printf ("    -ofile: basename of the outputs.  Each counted quality "
+            "field is written to a _<field>_freq file holding, for each "
+            "pixel, the percent of its valid observations (those not fill) "
+            "flagged at or above the confidence level, 0 to 100, or 255 "
+            "without any valid observation.  The number of valid "
+            "observations is written to a _nobs file, 8-bit for up to 255 "
+            "scenes and 16-bit beyond.  The fill field isn't counted.\n");
     printf ("\nwhere the following is optional:\n");
+    printf ("    -jobs: number of scenes unpacked at once in batch mode "
+            "(default is 1), each with -threads unpack threads.  The status "
+            "of each scene is reported as it completes and a failed scene "
+            "doesn't stop the others.\n");
     printf ("    -combine: indicates the specified QA bits will be combined "
             "into one single output band (default is false)\n");
+    printf ("    -expr: write the boolean QA expression as the one combined "
+            "output band, 1 where it is true and 0 elsewhere, in place of "
+            "the specified QA bits.  Fields are compared with numbers or "
+            "low, med and high using >=, >, <=, <, == and !=, and joined "
+            "with NOT, AND, OR and parentheses.  A confidence field on its "
+            "own is true at or above its confidence level (med unless set "
+            "by its own option) and any other field when nonzero, e.g. \"cloud_conf>=med AND NOT snow OR "
+            "shadow>=high\".  A field may be named by the start of its "
+            "name or of one of its words.  Implies -combine.\n");
+    printf ("    -threads: number of threads used to unpack the QA band "
+            "(default is 1).  The input is read and each output is written "
+            "on its own thread alongside the unpack threads.  Compressed "
+            "input is decoded in parallel on the unpack threads.\n");
+    printf ("    -compress: compression of the output files, one of 'none', "
+            "'deflate', 'lzw' or 'zstd' (default is none).  Compressed "
+            "8-bit output uses the horizontal predictor.\n");
+    printf ("    -tiled: write tiled output files (default is stripped)\n");
+    printf ("    -tile_size: width and length of the output tiles, a "
+            "multiple of 16 (default is 256).  Implies -tiled.\n");
+    printf ("    -strip_lines: number of lines in each strip of stripped "
+            "output files (default is 64)\n");
+    printf ("    -packed: write 0/1 outputs as 1-bit samples and raw 2-bit "
+            "QA fields as 2-bit samples (default is 8-bit samples)\n");
+    printf ("    -multiband: write the QA bits as the bands of one output "
+            "file, -ofile being its full filename.  The bands are "
+            "interleaved by 'pixel' or by 'band'.  Can't be used with "
+            "-combine or -packed.\n");
+    printf ("    -overviews: also write reduced resolution overviews of "
+            "each output file, halving the size at each level until it is at "
+            "most 256 lines and samples, as SubIFDs of the file.  They are "
+            "built while the lines are written, reducing each block of pixels "
+            "to 'any' (1 where any of them is nonzero) or 'max' (their "
+            "largest value, the default).\n");
+    printf ("    -window: only unpack the window of nlines lines and nsamps "
+            "samples starting at line and samp (counted from 0) of the QA "
+            "band.  Only the strips or tiles of the QA band the window "
+            "touches are read, and the outputs cover the window, their tie "
+            "point moved to its upper left corner.\n");
+    printf ("    -map_window: as -window, for the window of pixels touched by "
+            "the upper left and lower right corners given in the map "
+            "coordinates of the QA band, clipped to the QA band\n");
+    printf ("    -points: only extract the QA value and the value of each "
+            "specified quality field at the points listed in the file, one "
+            "per line as map x and y and an optional label, to a 'json' or "
+            "'csv' sidecar named after -ofile with a _points suffix (default "
+            "format is json).  Only the strips or tiles of the QA band "
+            "holding points are read.\n");
+    printf ("    -pixel_points: as -points, for points given as line and "
+            "sample (counted from 0) of the QA band\n");
+    printf ("    -stats: also write the pixel counts and percentages of each "
+            "value of each quality field, gathered while unpacking, to a "
+            "'json' or 'csv' sidecar named after -ofile with a _stats "
+            "suffix\n");
+    printf ("    -stats_only: only write the statistics sidecar, without "
+            "unpacking the QA bits to any output file (default format is "
+            "json)\n");
+    printf ("    -estimate: only estimate the percent of pixels flagged in "
+            "each specified quality field, with 95%% confidence bounds, by "
+            "reading an evenly spread sample of the strips or rows of tiles "
+            "until the bounds are within +/- margin percent (default is 1).  "
+            "The estimates are printed and written in the -stats format "
+            "(default is json) to a sidecar named after -ofile with an "
+            "_estimate suffix.\n");
     printf ("\nwhere the following QA bit parameters are optional:\n");
     printf ("    -all: specifies all the quality bits should be output "
             "(default is true), using the specified confidence level for "
@@ -322,4 +542,15 @@ void usage ()
             "--ifile=LC08_L1GT_029030_20151209_2015013_01_T1_BQA.tif "
             "--ofile=LC08_L1GT_029030_20151209_2015013_01_T1_BQA "
             "--fill --cloud_shadow=high --cirrus=low --combine\n");
+    printf ("\nThe following example will unpack all the QA bits of each "
+            "scene listed in scenes.txt, four scenes at a time, into the "
+            "out directory.\n");
+    printf ("unpack_collection_qa "
+            "--batch=scenes.txt --opattern=out/%%s --jobs=4 --all\n");
+    printf ("\nThe following example will count how often the cloud bit "
+            "and high cloud shadow confidence are flagged over the scenes "
+            "listed in stack.txt, on eight threads.\n");
+    printf ("unpack_collection_qa "
+            "--freq=stack.txt --ofile=out/stack --cloud "
+            "--cloud_shadow=high --threads=8\n");
 }
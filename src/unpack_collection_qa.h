@@ -9,6 +9,10 @@
 #include "geotiffio.h"
 #include "bool.h"
 #include "error_handler.h"
+#include "unpack_pipeline.h"
+#include "unpack_out.h"
+#include "unpack_layout.h"
+#include "unpack_tar.h"
 
 #define STR_SIZE 1024
 
@@ -27,21 +31,6 @@ typedef enum
     NQUALITY_TYPES
 } Quality_t;
 
-/* Set up the enumerated types for low, medium, or high confidence */
-typedef enum
-{
-    UNDEFINED = 0,
-    LOW,
-    MED,
-    HIGH,
-    NCONF_TYPES
-} Confidence_t;
-
-/* Set up local defines for the UTM and PS projections */
-#define UNDEFINED_PROJ -99
-#define UTM_PROJ 1
-#define PS_PROJ 2
-
 /* Prototypes */
 void usage ();
 
@@ -53,83 +42,55 @@ short get_args
     int *satellite_number, /* O: number of the satellite, e.g.: 8 */
     char **infile,        /* O: address of input filename */
     char **outfile,       /* O: address of output filename */
+    char **batch_file,    /* O: address of the batch list filename */
+    char **out_pattern,   /* O: address of the batch output name pattern */
+    int *njobs,           /* O: number of scenes processed at once in batch
+                                mode */
+    char **freq_file,     /* O: address of the frequency list filename */
     bool qa_specd[NQUALITY_TYPES],  /* O: array to specify which of the QA
                                           bands was specified for processing */
-    Confidence_t qa_conf[NQUALITY_TYPES]
+    Confidence_t qa_conf[NQUALITY_TYPES],
                           /* O: array to specify the confidence level for
                                 each of the quality fields */
+    int *nthreads,        /* O: number of unpack threads */
+    Out_opts_t *out_opts  /* O: compression and layout of the outputs */
 );
 
-TIFF *create_tiff
+short get_scene_fields
 (
-    char *tiffile,         /* I: geotiff filename */
-    int proj,              /* I: projection type */
-    uint32 nlines,         /* I: number of lines in tiff image */
-    uint32 nsamps,         /* I: number of samples in tiff image */
-    double *tie_point,     /* I: corner tie points for projection [3] is ULx
-                                 and [4] is ULy (pass address of this array, as
-                                 memory is allocated) */
-    double *pixel_size,    /* I: pixel size array (x, y) (pass address of this
-                                 array, as memory is allocated) */
-    uint16 coord_sys,      /* I: coordinate system used (PixelIsArea or
-                                 PixelIsPoint) */
-    uint16 model_type,     /* I: geokey for the model type */
-    uint16 linear_units,   /* I: geokey for the linear units */
-    uint16 angular_units,  /* I: geokey for the angular units */
-    uint16 projected_type, /* I: geokey for the angular units */
-    uint16 proj_linear_units, /* O: geokey for proj linear units (PS proj) */
-    double proj_parms[15],  /* O: projection parameters (PS proj) */
-    char *citation         /* I: citation string */
+    char *infile,         /* I: input QA filename */
+    int *satellite_number, /* O: number of the satellite, e.g.: 8 */
+    bool qa_specd[NQUALITY_TYPES]   /* O: array to specify which of the QA
+                                          bands was specified for processing */
 );
 
-short read_attributes
+const Qa_layout_t *get_collection_layout
 (
-    char *infile,      /* I: input geotiff filename */
-    int *proj,         /* O: projection type */
-    uint32 *nlines,    /* O: number of lines in tiff image */
-    uint32 *nsamps,    /* O: number of samples in tiff image */
-    uint32 *tile_width,     /* O: width of each tile (if tiled) */
-    uint32 *tile_length,    /* O: length of each tile (if tiled) */
-    bool *tiled,            /* O: Image is in GeoTiff tiled format */
-    uint16 *bitspersample,  /* O: bits per sample in tiff image */
-    uint16 *sampleformat,   /* O: data type of tiff image */
-    double tie_point[6],    /* O: corner tie points for projection [3] is ULx
-                                  and [4] is ULy */
-    double pixel_size[3],   /* O: pixel size array (x, y, -) */
-    uint16 *coord_sys,      /* O: coordinate system used (PixelIsArea or
-                                  PixelIsPoint) */
-    uint16 *model_type,     /* O: geokey for the model type */
-    uint16 *linear_units,   /* O: geokey for the linear units */
-    uint16 *angular_units,  /* O: geokey for the angular units */
-    uint16 *projected_type, /* O: geokey for the angular units */
-    uint16 *proj_linear_units, /* O: geokey for proj linear units (PS proj) */
-    double proj_parms[15],  /* O: projection parameters (PS proj) */
-    char *citation          /* O: citation string */
+    int satellite_number  /* I: number of the satellite, e.g.: 8 */
 );
 
-short unpack_bits
+short run_batch
 (
-    char *qa_infile,      /* I: input QA filename */
-    char *qa_outfile,     /* I: output QA base filename */
-    bool qa_specd[NQUALITY_TYPES],  /* I: array to specify which QA bands
-                                          was specified for processing */
+    char *batch_file,     /* I: file listing the input QA filenames */
+    char *out_pattern,    /* I: output name pattern, %s being the scene */
+    int njobs,            /* I: number of scenes processed at once */
+    bool combine_bits,    /* I: should the QA bits be combined? */
     Confidence_t qa_conf[NQUALITY_TYPES],
                           /* I: array to specify the confidence level for
                                 each of the quality fields */
-    int satellite_number  /* I: number of the satellite, e.g.: 8 */
-
+    int nthreads,         /* I: number of unpack threads for each scene */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
 );
 
-short unpack_combine_bits
+short run_freq
 (
-    char *qa_infile,      /* I: input QA filename */
-    char *qa_outfile,     /* I: output QA filename */
-    bool qa_specd[NQUALITY_TYPES],  /* I: array to specify which QA bands
-                                          was specified for processing */
+    char *freq_file,      /* I: file listing the input QA filenames */
+    char *qa_outfile,     /* I: output base filename */
     Confidence_t qa_conf[NQUALITY_TYPES],
                           /* I: array to specify the confidence level for
                                 each of the quality fields */
-    int satellite_number  /* I: number of the satellite, e.g.: 8 */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
 );
 
 #endif
@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "unpack_stats.h"
+#include "unpack_estimate.h"
+
+/* Bit of the flag lookup table marking fill pixels */
+#define EST_FILL_BIT (1u << UNPACK_MAX_FIELDS)
+
+/******************************************************************************
+MODULE:  init_qa_estimate
+
+PURPOSE:  Set up the estimate of the specified quality fields, building the
+lookup table of the fields each QA value flags.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Error allocating the lookup table
+SUCCESS         Processing was successful
+
+NOTES:
+1. A pixel is flagged in a field at or above its confidence level, as in the
+   combined mask.  Fields without a confidence level are flagged for any
+   nonzero value.
+2. The fill field is estimated as a percent of all the pixels, the other
+   fields as a percent of the valid (non-fill) pixels.
+******************************************************************************/
+short init_qa_estimate
+(
+    Qa_estimate_t *est,   /* O: estimate */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: which quality fields are estimated */
+    Confidence_t *qa_conf,  /* I: confidence level of each quality field */
+    uint32 nblocks        /* I: number of blocks in the QA band */
+)
+{
+    char FUNC_NAME[] = "init_qa_estimate"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    const Qa_field_desc_t *desc;  /* description of the current field */
+    long qa_val;             /* current QA value */
+    uint32 flags;            /* flags of the current QA value */
+    int i;                   /* looping variable */
+
+    memset (est, 0, sizeof (Qa_estimate_t));
+    est->nblocks = nblocks;
+    while (((uint32) 1 << est->order_bits) < nblocks)
+        est->order_bits++;
+
+    for (i = 0; i < layout->nfields; i++)
+    {
+        if (!qa_specd[i] || layout->field[i].name == NULL)
+            continue;
+        est->qa_type[est->nfields] = i;
+        est->flagged_at[est->nfields] = (qa_conf[i] == UNDEFINED) ? 1 :
+            qa_conf[i];
+        if (i == layout->fill_field)
+            est->total_mask |= 1u << est->nfields;
+        est->nfields++;
+    }
+
+    est->flag_lut = (uint32 *) malloc (UNPACK_LUT_SIZE * sizeof (uint32));
+    if (est->flag_lut == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the estimate lookup "
+            "table");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    for (qa_val = 0; qa_val < UNPACK_LUT_SIZE; qa_val++)
+    {
+        flags = 0;
+        for (i = 0; i < est->nfields; i++)
+        {
+            desc = &layout->field[est->qa_type[i]];
+            if (((qa_val >> desc->shift) & desc->mask) >= est->flagged_at[i])
+                flags |= 1u << i;
+        }
+        if (layout->fill_field >= 0)
+        {
+            desc = &layout->field[layout->fill_field];
+            if ((qa_val >> desc->shift) & desc->mask)
+                flags |= EST_FILL_BIT;
+        }
+        est->flag_lut[qa_val] = flags;
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  next_estimate_block
+
+PURPOSE:  Get the next block of lines to sample, in bit-reversed order.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              All the blocks have been sampled
+n               Index of the next block to sample
+
+NOTES:
+******************************************************************************/
+int next_estimate_block
+(
+    Qa_estimate_t *est    /* I/O: estimate */
+)
+{
+    uint32 pos;              /* position in the order */
+    uint32 block;            /* bit-reversed position */
+    int bit;                 /* looping variable */
+
+    while (est->next < ((uint32) 1 << est->order_bits))
+    {
+        pos = est->next++;
+        block = 0;
+        for (bit = 0; bit < est->order_bits; bit++)
+            block |= ((pos >> bit) & 1) << (est->order_bits - 1 - bit);
+        if (block < est->nblocks)
+            return ((int) block);
+    }
+
+    return (-1);
+}
+
+
+/******************************************************************************
+MODULE:  add_qa_estimate
+
+PURPOSE:  Count the flagged pixels of a sampled block, update the estimates
+and their confidence bounds and tell whether sampling can stop.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The bounds of all the fields are within the margin, or all
+                the blocks have been sampled
+false           More blocks need to be sampled
+
+NOTES:
+1. The percent p of a field is the ratio of the flagged pixels y to the
+   pixels x it is a percent of, summed over the sampled blocks.  Its
+   variance is estimated as (1 - n/N) s^2 / (n xbar^2), where s^2 is the
+   variance of the residuals y - p x over the n sampled blocks of N.
+2. At least EST_MIN_BLOCKS blocks are sampled before stopping, so the bounds
+   aren't trusted from only a few blocks.
+******************************************************************************/
+bool add_qa_estimate
+(
+    Qa_estimate_t *est,   /* I/O: estimate */
+    uint16 *qa_buf,       /* I: QA values of the block */
+    long npix,            /* I: number of QA values */
+    double margin         /* I: half-width, in percent, to stop at */
+)
+{
+    long count[UNPACK_MAX_FIELDS];  /* flagged pixels of each field */
+    long nvalid = 0;         /* valid pixels of the block */
+    long pix;                /* looping variable */
+    uint32 flags;            /* flags of the current pixel */
+    int i;                   /* looping variable */
+    double x;                /* pixels the field is a percent of */
+    double sum_x, sum_x2;    /* sums of x and of its square */
+    double p;                /* estimated fraction flagged */
+    double s2;               /* variance of the residuals */
+    double xbar;             /* mean of x over the sampled blocks */
+    double n;                /* number of blocks sampled */
+    bool done;               /* all the bounds are within the margin */
+
+    memset (count, 0, sizeof (count));
+    for (pix = 0; pix < npix; pix++)
+    {
+        flags = est->flag_lut[qa_buf[pix]];
+        if (flags & EST_FILL_BIT)
+            flags &= est->total_mask;
+        else
+            nvalid++;
+        for (i = 0; i < est->nfields; i++)
+            count[i] += (flags >> i) & 1;
+    }
+
+    est->nsampled++;
+    est->npix += npix;
+    est->sum_total += npix;
+    est->sum_total2 += (double) npix * npix;
+    est->sum_valid += nvalid;
+    est->sum_valid2 += (double) nvalid * nvalid;
+    for (i = 0; i < est->nfields; i++)
+    {
+        x = (est->total_mask & (1u << i)) ? npix : nvalid;
+        est->sum_y[i] += count[i];
+        est->sum_y2[i] += (double) count[i] * count[i];
+        est->sum_xy[i] += x * count[i];
+    }
+
+    /* Update the estimates and their bounds */
+    n = est->nsampled;
+    done = (est->nsampled >= EST_MIN_BLOCKS);
+    for (i = 0; i < est->nfields; i++)
+    {
+        if (est->total_mask & (1u << i))
+        {
+            sum_x = est->sum_total;
+            sum_x2 = est->sum_total2;
+        }
+        else
+        {
+            sum_x = est->sum_valid;
+            sum_x2 = est->sum_valid2;
+        }
+
+        p = (sum_x > 0.0) ? est->sum_y[i] / sum_x : 0.0;
+        est->percent[i] = 100.0 * p;
+        if (est->nsampled == est->nblocks)
+            est->half_width[i] = 0.0;
+        else if (est->nsampled < 2 || sum_x <= 0.0)
+            est->half_width[i] = 100.0;
+        else
+        {
+            s2 = (est->sum_y2[i] - 2.0 * p * est->sum_xy[i] + p * p *
+                sum_x2) / (n - 1.0);
+            if (s2 < 0.0)
+                s2 = 0.0;
+            xbar = sum_x / n;
+            est->half_width[i] = 100.0 * EST_Z_95 * sqrt ((1.0 - n /
+                est->nblocks) * s2 / (n * xbar * xbar));
+        }
+
+        if (est->half_width[i] > margin)
+            done = false;
+    }
+
+    return (done || est->nsampled == est->nblocks);
+}
+
+
+/******************************************************************************
+MODULE:  write_qa_estimate
+
+PURPOSE:  Write the estimated percent of pixels flagged in each field, with
+its 95% confidence bounds, to the estimate sidecar.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Error writing the estimate
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+short write_qa_estimate
+(
+    Qa_estimate_t *est,   /* I: estimate */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    char *qa_infile,      /* I: input QA filename */
+    char *estfile,        /* I: estimate sidecar filename */
+    int format,           /* I: OUT_STATS_* format of the estimate */
+    double margin         /* I: half-width, in percent, sampled to */
+)
+{
+    char FUNC_NAME[] = "write_qa_estimate"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    const char *name;        /* name of the current field */
+    double lower, upper;     /* confidence bounds of the current field */
+    int i;                   /* looping variable */
+    FILE *fp = NULL;         /* estimate file pointer */
+
+    fp = fopen (estfile, "w");
+    if (fp == NULL)
+    {
+        sprintf (errmsg, "Error opening the QA estimate file %s", estfile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (format == OUT_STATS_JSON)
+    {
+        fprintf (fp, "{\n  \"qa_file\": ");
+        write_json_string (fp, qa_infile);
+        fprintf (fp, ",\n  \"product\": ");
+        write_json_string (fp, layout->product);
+        fprintf (fp, ",\n  \"sampled_blocks\": %u,\n  \"total_blocks\": %u,"
+            "\n  \"sampled_pixels\": %.0f,\n  \"confidence\": 0.95,\n"
+            "  \"margin\": %.3f,\n  \"fields\": [", est->nsampled,
+            est->nblocks, est->npix, margin);
+    }
+    else
+        fprintf (fp, "field,flagged_at,percent,lower,upper\n");
+
+    for (i = 0; i < est->nfields; i++)
+    {
+        name = layout->field[est->qa_type[i]].name;
+        lower = est->percent[i] - est->half_width[i];
+        if (lower < 0.0)
+            lower = 0.0;
+        upper = est->percent[i] + est->half_width[i];
+        if (upper > 100.0)
+            upper = 100.0;
+
+        if (format == OUT_STATS_JSON)
+        {
+            fprintf (fp, "%s\n    {\"name\": ", (i > 0) ? "," : "");
+            write_json_string (fp, name);
+            fprintf (fp, ", \"flagged_at\": %d, \"percent\": %.3f, "
+                "\"lower\": %.3f, \"upper\": %.3f}", est->flagged_at[i],
+                est->percent[i], lower, upper);
+        }
+        else
+            fprintf (fp, "%s,%d,%.3f,%.3f,%.3f\n", name, est->flagged_at[i],
+                est->percent[i], lower, upper);
+    }
+
+    if (format == OUT_STATS_JSON)
+        fprintf (fp, "\n  ]\n}\n");
+
+    if (fclose (fp) != 0)
+    {
+        sprintf (errmsg, "Error writing the QA estimate file %s", estfile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  free_qa_estimate
+
+PURPOSE:  Free the lookup table of the estimate.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void free_qa_estimate
+(
+    Qa_estimate_t *est    /* I/O: estimate */
+)
+{
+    free (est->flag_lut);
+    est->flag_lut = NULL;
+}
@@ -0,0 +1,84 @@
+#ifndef _UNPACK_ESTIMATE_H_
+#define _UNPACK_ESTIMATE_H_
+
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+#include "unpack_layout.h"
+
+/* Blocks sampled before the confidence bounds are trusted to stop */
+#define EST_MIN_BLOCKS 16
+
+/* Normal quantile of the two-sided 95% confidence bounds */
+#define EST_Z_95 1.96
+
+/* Cover estimate of the quality fields of a QA band, from a sample of its
+   blocks of lines.  The blocks are visited in bit-reversed order, so each
+   prefix of the order is an evenly spaced sample of the band, every k-th
+   block with k halving as the sample grows.  Each block is a cluster of
+   pixels, so the bounds are those of a ratio estimate over the sampled
+   blocks. */
+typedef struct
+{
+    int nfields;          /* number of fields estimated */
+    int qa_type[UNPACK_MAX_FIELDS];  /* layout index of each field */
+    int flagged_at[UNPACK_MAX_FIELDS];  /* value from which a pixel is
+                                           flagged in each field */
+    uint32 *flag_lut;     /* for each QA value, bit i set if field i is
+                             flagged and bit UNPACK_MAX_FIELDS set for fill */
+    uint32 total_mask;    /* bits of the fields that are a percent of all the
+                             pixels, rather than of the valid pixels */
+    uint32 nblocks;       /* number of blocks in the QA band */
+    uint32 nsampled;      /* number of blocks sampled */
+    int order_bits;       /* bits of the bit-reversed block order */
+    uint32 next;          /* next position in the bit-reversed order */
+    double npix;          /* number of pixels sampled */
+    double sum_total, sum_total2;  /* sums of the pixels of each block and
+                                      of their squares */
+    double sum_valid, sum_valid2;  /* same for the valid (non-fill) pixels */
+    double sum_y[UNPACK_MAX_FIELDS];   /* sums of the flagged pixels */
+    double sum_y2[UNPACK_MAX_FIELDS];  /* sums of their squares */
+    double sum_xy[UNPACK_MAX_FIELDS];  /* sums of their products with the
+                                          pixels they are a percent of */
+    double percent[UNPACK_MAX_FIELDS];     /* estimated percent flagged */
+    double half_width[UNPACK_MAX_FIELDS];  /* half-width of the bounds */
+} Qa_estimate_t;
+
+short init_qa_estimate
+(
+    Qa_estimate_t *est,   /* O: estimate */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: which quality fields are estimated */
+    Confidence_t *qa_conf,  /* I: confidence level of each quality field */
+    uint32 nblocks        /* I: number of blocks in the QA band */
+);
+
+int next_estimate_block
+(
+    Qa_estimate_t *est    /* I/O: estimate */
+);
+
+bool add_qa_estimate
+(
+    Qa_estimate_t *est,   /* I/O: estimate */
+    uint16 *qa_buf,       /* I: QA values of the block */
+    long npix,            /* I: number of QA values */
+    double margin         /* I: half-width, in percent, to stop at */
+);
+
+short write_qa_estimate
+(
+    Qa_estimate_t *est,   /* I: estimate */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    char *qa_infile,      /* I: input QA filename */
+    char *estfile,        /* I: estimate sidecar filename */
+    int format,           /* I: OUT_STATS_* format of the estimate */
+    double margin         /* I: half-width, in percent, sampled to */
+);
+
+void free_qa_estimate
+(
+    Qa_estimate_t *est    /* I/O: estimate */
+);
+
+#endif
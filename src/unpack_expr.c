@@ -0,0 +1,589 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "unpack_expr.h"
+
+/* Types of the nodes of a parsed QA expression */
+#define EXPR_CMP 0        /* comparison of a field value with a constant */
+#define EXPR_NOT 1
+#define EXPR_AND 2
+#define EXPR_OR 3
+
+/* Comparison operators */
+#define EXPR_EQ 0
+#define EXPR_NE 1
+#define EXPR_LT 2
+#define EXPR_LE 3
+#define EXPR_GT 4
+#define EXPR_GE 5
+
+/* One node of a parsed QA expression */
+typedef struct
+{
+    int type;             /* EXPR_* node type */
+    int field;            /* layout index of the field (comparison) */
+    int op;               /* EXPR_* comparison operator (comparison) */
+    int value;            /* constant compared with (comparison) */
+    int left, right;      /* operand nodes, right is unused by NOT */
+} Expr_node_t;
+
+/* State of the expression parser */
+typedef struct
+{
+    char *expr;           /* expression being parsed */
+    char *pos;            /* current position in the expression */
+    const Qa_layout_t *layout;  /* bit layout the field names are from */
+    Confidence_t *qa_conf;  /* confidence level of each field, UNDEFINED for
+                               the fields that aren't confidences */
+    int nnodes;           /* number of nodes parsed */
+    int depth;            /* nesting depth of the parentheses being parsed */
+    Expr_node_t node[EXPR_MAX_NODES];  /* parsed nodes */
+    char errmsg[STR_SIZE];  /* first parse error, empty if none */
+} Expr_parser_t;
+
+static int parse_or (Expr_parser_t *parser);
+
+/******************************************************************************
+MODULE:  expr_error
+
+PURPOSE:  Record the first parse error of the expression, with the position
+it was found at.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              Always, to be returned by the parse functions
+
+NOTES:
+******************************************************************************/
+static int expr_error
+(
+    Expr_parser_t *parser,  /* I/O: parser */
+    const char *msg       /* I: description of the error */
+)
+{
+    if (parser->errmsg[0] == '\0')
+        snprintf (parser->errmsg, STR_SIZE, "%s at position %d of the QA "
+            "expression '%s'", msg, (int) (parser->pos - parser->expr) + 1,
+            parser->expr);
+    return (-1);
+}
+
+
+/******************************************************************************
+MODULE:  add_node
+
+PURPOSE:  Add a node to the parsed expression.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              The expression has too many nodes
+n               Index of the new node
+
+NOTES:
+******************************************************************************/
+static int add_node
+(
+    Expr_parser_t *parser,  /* I/O: parser */
+    int type,             /* I: EXPR_* node type */
+    int left,             /* I: first operand node */
+    int right             /* I: second operand node */
+)
+{
+    Expr_node_t *node;       /* new node */
+
+    if (parser->nnodes >= EXPR_MAX_NODES)
+        return (expr_error (parser, "Too many terms"));
+
+    node = &parser->node[parser->nnodes];
+    memset (node, 0, sizeof (Expr_node_t));
+    node->type = type;
+    node->left = left;
+    node->right = right;
+    return (parser->nnodes++);
+}
+
+
+/******************************************************************************
+MODULE:  match_word
+
+PURPOSE:  Skip white space and match a case-insensitive keyword or operator
+symbol at the current position, moving past it if it matches.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The keyword or symbol was matched
+false           It doesn't start at the current position
+
+NOTES:
+1. Keywords made of letters only match whole words.
+******************************************************************************/
+static bool match_word
+(
+    Expr_parser_t *parser,  /* I/O: parser */
+    const char *word      /* I: keyword or operator symbol */
+)
+{
+    int len = strlen (word);  /* length of the word */
+
+    while (isspace ((unsigned char) *parser->pos))
+        parser->pos++;
+    if (strncasecmp (parser->pos, word, len) != 0)
+        return (false);
+    if (isalpha ((unsigned char) word[0]) && (parser->pos[len] == '_' ||
+        isalnum ((unsigned char) parser->pos[len])))
+        return (false);
+
+    parser->pos += len;
+    return (true);
+}
+
+
+/******************************************************************************
+MODULE:  find_field
+
+PURPOSE:  Find the quality field of the layout with the name, or else the one
+field with a word of its name, split at underscores, starting with it.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              No field, or more than one, matches
+n               Layout index of the field
+
+NOTES:
+******************************************************************************/
+static int find_field
+(
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    const char *name,     /* I: field name or start of it */
+    int len               /* I: length of the name */
+)
+{
+    const char *word;        /* current word of the field name */
+    int i;                   /* looping variable */
+    int found = -1;          /* field matched by the start of a word */
+    int nfound = 0;          /* number of fields matched */
+
+    for (i = 0; i < layout->nfields; i++)
+    {
+        if (layout->field[i].name == NULL)
+            continue;
+        if (!strncmp (layout->field[i].name, name, len) &&
+            layout->field[i].name[len] == '\0')
+            return (i);
+        for (word = layout->field[i].name; word != NULL;
+            word = strchr (word, '_'))
+        {
+            if (*word == '_')
+                word++;
+            if (!strncmp (word, name, len))
+            {
+                found = i;
+                nfound++;
+                break;
+            }
+        }
+    }
+
+    return ((nfound == 1) ? found : -1);
+}
+
+
+/******************************************************************************
+MODULE:  parse_value
+
+PURPOSE:  Parse the constant a field is compared with, a number or one of the
+confidence levels low, med(ium) or high.  Numbers are decimal, or hex with a
+0x prefix.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              Error parsing the constant
+n               Value of the constant
+
+NOTES:
+******************************************************************************/
+static int parse_value
+(
+    Expr_parser_t *parser   /* I/O: parser */
+)
+{
+    char *end;               /* end of the number */
+    long value;              /* value of the number */
+
+    while (isspace ((unsigned char) *parser->pos))
+        parser->pos++;
+    if (isdigit ((unsigned char) *parser->pos))
+    {
+        if (parser->pos[0] == '0' && (parser->pos[1] == 'x' ||
+            parser->pos[1] == 'X') && isxdigit ((unsigned char) parser->pos[2]))
+            value = strtol (parser->pos + 2, &end, 16);
+        else
+            value = strtol (parser->pos, &end, 10);
+        if (value > 0xffff)
+            return (expr_error (parser, "Value out of range"));
+        parser->pos = end;
+        return ((int) value);
+    }
+
+    if (match_word (parser, "low"))
+        return (LOW);
+    if (match_word (parser, "medium") || match_word (parser, "med"))
+        return (MED);
+    if (match_word (parser, "high"))
+        return (HIGH);
+    return (expr_error (parser, "Expected a number or low, med or high"));
+}
+
+
+/******************************************************************************
+MODULE:  parse_operand
+
+PURPOSE:  Parse a parenthesized expression or a comparison of a field with a
+constant.  A confidence field on its own is true at or above its confidence
+level and any other field on its own for any nonzero value.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              Error parsing the expression
+n               Index of the parsed node
+
+NOTES:
+1. Parentheses can't be nested deeper than EXPR_MAX_NODES, so a long run of
+   them is an error rather than a stack overflow.
+2. A confidence field is often low rather than 0 where the condition is
+   absent, so testing it for nonzero would be true almost everywhere.
+******************************************************************************/
+static int parse_operand
+(
+    Expr_parser_t *parser   /* I/O: parser */
+)
+{
+    static const struct
+    {
+        const char *symbol;   /* operator symbol */
+        int op;               /* EXPR_* comparison operator */
+    } cmp_ops[] =
+    {   /* longer symbols first, so <= isn't matched as < */
+        {">=", EXPR_GE}, {"<=", EXPR_LE}, {"==", EXPR_EQ}, {"!=", EXPR_NE},
+        {">", EXPR_GT}, {"<", EXPR_LT}, {"=", EXPR_EQ}
+    };
+    char *name;              /* field name */
+    int len;                 /* length of the field name */
+    int field;               /* layout index of the field */
+    int node;                /* parsed node */
+    int i;                   /* looping variable */
+
+    if (match_word (parser, "("))
+    {
+        if (++parser->depth > EXPR_MAX_NODES)
+            return (expr_error (parser, "Too deeply nested"));
+        node = parse_or (parser);
+        parser->depth--;
+        if (node < 0)
+            return (-1);
+        if (!match_word (parser, ")"))
+            return (expr_error (parser, "Expected )"));
+        return (node);
+    }
+
+    /* Field name */
+    name = parser->pos;
+    while (isalnum ((unsigned char) *parser->pos) || *parser->pos == '_')
+        parser->pos++;
+    len = parser->pos - name;
+    if (len == 0)
+        return (expr_error (parser, "Expected a quality field"));
+    field = find_field (parser->layout, name, len);
+    if (field < 0)
+    {
+        parser->pos = name;
+        return (expr_error (parser, "Unknown or ambiguous quality field"));
+    }
+
+    node = add_node (parser, EXPR_CMP, -1, -1);
+    if (node < 0)
+        return (-1);
+    parser->node[node].field = field;
+    if (parser->qa_conf[field] != UNDEFINED)
+    {
+        parser->node[node].op = EXPR_GE;
+        parser->node[node].value = parser->qa_conf[field];
+    }
+    else
+    {
+        parser->node[node].op = EXPR_NE;
+        parser->node[node].value = 0;
+    }
+    for (i = 0; i < (int) (sizeof (cmp_ops) / sizeof (cmp_ops[0])); i++)
+    {
+        if (!match_word (parser, cmp_ops[i].symbol))
+            continue;
+        parser->node[node].op = cmp_ops[i].op;
+        parser->node[node].value = parse_value (parser);
+        if (parser->node[node].value < 0)
+            return (-1);
+        break;
+    }
+
+    return (node);
+}
+
+
+/******************************************************************************
+MODULE:  parse_primary
+
+PURPOSE:  Parse an operand preceded by any number of negations.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              Error parsing the expression
+n               Index of the parsed node
+
+NOTES:
+1. The negations are counted rather than parsed recursively, each one
+   taking a node, so a long run of them ends at the node limit.
+******************************************************************************/
+static int parse_primary
+(
+    Expr_parser_t *parser   /* I/O: parser */
+)
+{
+    int nnot = 0;            /* number of negations */
+    int node;                /* parsed node */
+
+    while (match_word (parser, "not") || match_word (parser, "!"))
+    {
+        if (++nnot > EXPR_MAX_NODES)
+            return (expr_error (parser, "Too many terms"));
+    }
+
+    node = parse_operand (parser);
+    while (node >= 0 && nnot-- > 0)
+        node = add_node (parser, EXPR_NOT, node, -1);
+    return (node);
+}
+
+
+/******************************************************************************
+MODULE:  parse_and
+
+PURPOSE:  Parse terms joined by AND (or &&).
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              Error parsing the expression
+n               Index of the parsed node
+
+NOTES:
+******************************************************************************/
+static int parse_and
+(
+    Expr_parser_t *parser   /* I/O: parser */
+)
+{
+    int node;                /* parsed node */
+    int right;               /* right operand */
+
+    node = parse_primary (parser);
+    while (node >= 0 && (match_word (parser, "and") ||
+        match_word (parser, "&&")))
+    {
+        right = parse_primary (parser);
+        if (right < 0)
+            return (-1);
+        node = add_node (parser, EXPR_AND, node, right);
+    }
+
+    return (node);
+}
+
+
+/******************************************************************************
+MODULE:  parse_or
+
+PURPOSE:  Parse terms joined by OR (or ||).  AND binds tighter than OR.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              Error parsing the expression
+n               Index of the parsed node
+
+NOTES:
+******************************************************************************/
+static int parse_or
+(
+    Expr_parser_t *parser   /* I/O: parser */
+)
+{
+    int node;                /* parsed node */
+    int right;               /* right operand */
+
+    node = parse_and (parser);
+    while (node >= 0 && (match_word (parser, "or") ||
+        match_word (parser, "||")))
+    {
+        right = parse_and (parser);
+        if (right < 0)
+            return (-1);
+        node = add_node (parser, EXPR_OR, node, right);
+    }
+
+    return (node);
+}
+
+
+/******************************************************************************
+MODULE:  eval_expr
+
+PURPOSE:  Evaluate a node of the parsed expression for one QA value.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true/false      Value of the node
+
+NOTES:
+******************************************************************************/
+static bool eval_expr
+(
+    Expr_parser_t *parser,  /* I: parsed expression */
+    int n,                /* I: node to evaluate */
+    long qa_val           /* I: QA value */
+)
+{
+    Expr_node_t *node = &parser->node[n];  /* node evaluated */
+    const Qa_field_desc_t *desc;  /* field compared */
+    int val;                 /* value of the field */
+
+    switch (node->type)
+    {
+        case EXPR_NOT:
+            return (!eval_expr (parser, node->left, qa_val));
+        case EXPR_AND:
+            return (eval_expr (parser, node->left, qa_val) &&
+                eval_expr (parser, node->right, qa_val));
+        case EXPR_OR:
+            return (eval_expr (parser, node->left, qa_val) ||
+                eval_expr (parser, node->right, qa_val));
+    }
+
+    desc = &parser->layout->field[node->field];
+    val = (qa_val >> desc->shift) & desc->mask;
+    switch (node->op)
+    {
+        case EXPR_EQ:
+            return (val == node->value);
+        case EXPR_NE:
+            return (val != node->value);
+        case EXPR_LT:
+            return (val < node->value);
+        case EXPR_LE:
+            return (val <= node->value);
+        case EXPR_GT:
+            return (val > node->value);
+        default:
+            return (val >= node->value);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  build_expr_lut
+
+PURPOSE:  Parse a boolean expression of the quality fields of the layout and
+compile it into a lookup table holding 1 for the QA values where it is true
+and 0 elsewhere.
+
+RETURN VALUE:
+Type = uint8 *
+Value           Description
+-----           -----------
+NULL            Error parsing the expression or allocating the table
+uint8 *         Table of UNPACK_LUT_SIZE entries, to be freed by the caller
+
+NOTES:
+1. The expression compares fields with numbers or the confidence levels low,
+   med and high using >=, >, <=, <, == (or =) and !=.  A confidence field on
+   its own is true at or above its confidence level, medium unless set by the
+   field's own option, and any other field on its own when nonzero.  The comparisons are joined with NOT, AND and OR (or !,
+   && and ||), in that order of precedence, and parentheses.
+2. A field is named by its output suffix, e.g. cloud_confidence, or by the
+   start of it or of one of its words when only one field matches, e.g.
+   cloud_conf, snow or shadow.
+3. Whatever its complexity, the expression costs one table lookup per pixel
+   once compiled.
+******************************************************************************/
+uint8 *build_expr_lut
+(
+    char *expr,           /* I: boolean QA expression */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Confidence_t *qa_conf   /* I: confidence level of each quality field */
+)
+{
+    char FUNC_NAME[] = "build_expr_lut"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    int root;                /* top node of the expression */
+    long qa_val;             /* current QA value */
+    uint8 *lut = NULL;       /* lookup table */
+    Expr_parser_t *parser;   /* parser of the expression */
+
+    parser = (Expr_parser_t *) calloc (1, sizeof (Expr_parser_t));
+    if (parser == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the QA expression");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+    parser->expr = expr;
+    parser->pos = expr;
+    parser->layout = layout;
+    parser->qa_conf = qa_conf;
+
+    root = parse_or (parser);
+    while (isspace ((unsigned char) *parser->pos))
+        parser->pos++;
+    if (root >= 0 && *parser->pos != '\0')
+        root = expr_error (parser, "Unexpected text");
+    if (root < 0)
+    {
+        error_handler (true, FUNC_NAME, parser->errmsg);
+        free (parser);
+        return (NULL);
+    }
+
+    lut = (uint8 *) malloc (UNPACK_LUT_SIZE * sizeof (uint8));
+    if (lut == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the QA expression "
+            "lookup table");
+        error_handler (true, FUNC_NAME, errmsg);
+        free (parser);
+        return (NULL);
+    }
+    for (qa_val = 0; qa_val < UNPACK_LUT_SIZE; qa_val++)
+        lut[qa_val] = eval_expr (parser, root, qa_val);
+
+    free (parser);
+    return (lut);
+}
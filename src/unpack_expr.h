@@ -0,0 +1,20 @@
+#ifndef _UNPACK_EXPR_H_
+#define _UNPACK_EXPR_H_
+
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+#include "unpack_layout.h"
+
+/* Maximum number of nodes (fields, comparisons and operators) in a QA
+   expression */
+#define EXPR_MAX_NODES 64
+
+uint8 *build_expr_lut
+(
+    char *expr,           /* I: boolean QA expression */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Confidence_t *qa_conf   /* I: confidence level of each quality field */
+);
+
+#endif
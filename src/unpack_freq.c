@@ -0,0 +1,235 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unpack_freq.h"
+
+/******************************************************************************
+MODULE:  init_qa_freq
+
+PURPOSE:  Set up the per-pixel counters of one band of lines of a stack of QA
+bands, with the planes the fields are unpacked into.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Error allocating the counters
+SUCCESS         Processing was successful
+
+NOTES:
+1. The counters are 8-bit for stacks of up to FREQ_MAX_COUNT8 scenes and
+   16-bit for larger stacks.
+******************************************************************************/
+short init_qa_freq
+(
+    Qa_freq_t *freq,      /* O: counters */
+    int nfields,          /* I: number of counted fields */
+    bool has_fill,        /* I: a fill field is unpacked after the fields */
+    long npix,            /* I: number of pixels in one band of lines */
+    int nscenes           /* I: number of scenes in the stack */
+)
+{
+    char FUNC_NAME[] = "init_qa_freq"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    size_t count_size;       /* bytes in one counter */
+    int nplanes;             /* number of unpacked planes */
+    int i;                   /* looping variable */
+    bool ok = true;          /* all the buffers were allocated */
+
+    memset (freq, 0, sizeof (Qa_freq_t));
+    freq->nfields = nfields;
+    freq->has_fill = has_fill;
+    freq->wide = (nscenes > FREQ_MAX_COUNT8);
+    freq->npix = npix;
+    count_size = freq->wide ? sizeof (uint16) : sizeof (uint8);
+
+    nplanes = nfields + (has_fill ? 1 : 0);
+    for (i = 0; i < nplanes; i++)
+    {
+        freq->plane[i] = (uint8 *) malloc (npix * sizeof (uint8));
+        ok = ok && freq->plane[i] != NULL;
+    }
+    for (i = 0; i < nfields; i++)
+    {
+        freq->count[i] = calloc (npix, count_size);
+        ok = ok && freq->count[i] != NULL;
+    }
+    freq->nobs = calloc (npix, count_size);
+    if (!ok || freq->nobs == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the frequency "
+            "counters");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_qa_freq (freq);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  add_qa_freq
+
+PURPOSE:  Count the unpacked planes of one scene into the counters of the
+band of lines, for the valid (non-fill) pixels.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The fill plane is turned into the valid plane in place, so each counter is
+   a plain add of a 0/1 plane that the compiler can vectorize.
+******************************************************************************/
+void add_qa_freq
+(
+    Qa_freq_t *freq,      /* I/O: counters */
+    long first,           /* I: first pixel of the band to count */
+    long npix             /* I: number of pixels to count */
+)
+{
+    uint8 *valid = NULL;     /* 1 for the valid pixels */
+    uint8 *flag;             /* unpacked plane of the current field */
+    uint8 *count8;           /* 8-bit counter of the current field */
+    uint16 *count16;         /* 16-bit counter of the current field */
+    long pix;                /* looping variable for the pixels */
+    int i;                   /* looping variable for the fields */
+
+    if (freq->has_fill)
+    {
+        valid = &freq->plane[freq->nfields][first];
+        for (pix = 0; pix < npix; pix++)
+            valid[pix] ^= 1;
+    }
+
+    if (!freq->wide)
+    {
+        count8 = &((uint8 *) freq->nobs)[first];
+        if (valid == NULL)
+            for (pix = 0; pix < npix; pix++)
+                count8[pix]++;
+        else
+            for (pix = 0; pix < npix; pix++)
+                count8[pix] += valid[pix];
+    }
+    else
+    {
+        count16 = &((uint16 *) freq->nobs)[first];
+        if (valid == NULL)
+            for (pix = 0; pix < npix; pix++)
+                count16[pix]++;
+        else
+            for (pix = 0; pix < npix; pix++)
+                count16[pix] += valid[pix];
+    }
+
+    for (i = 0; i < freq->nfields; i++)
+    {
+        flag = &freq->plane[i][first];
+        if (valid != NULL)
+            for (pix = 0; pix < npix; pix++)
+                flag[pix] &= valid[pix];
+
+        if (!freq->wide)
+        {
+            count8 = &((uint8 *) freq->count[i])[first];
+            for (pix = 0; pix < npix; pix++)
+                count8[pix] += flag[pix];
+        }
+        else
+        {
+            count16 = &((uint16 *) freq->count[i])[first];
+            for (pix = 0; pix < npix; pix++)
+                count16[pix] += flag[pix];
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  get_qa_freq
+
+PURPOSE:  Turn the counters of a band of lines into the frequency outputs and
+the valid observation count output, then clear the counters for the next
+band.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The frequency of a field is the rounded percent of the valid observations
+   of the pixel that flag the field, 0 to 100, or FREQ_NO_OBS where the pixel
+   has no valid observation.
+2. The valid observation count is written with the width of the counters.
+******************************************************************************/
+void get_qa_freq
+(
+    Qa_freq_t *freq,      /* I/O: counters, cleared for the next band */
+    long npix,            /* I: number of pixels in the band */
+    uint8 **out_buf       /* O: frequency of each field, then the valid
+                                observation count */
+)
+{
+    size_t count_size;       /* bytes in one counter */
+    long pix;                /* looping variable for the pixels */
+    int i;                   /* looping variable for the fields */
+    unsigned int nobs;       /* valid observations of the current pixel */
+    unsigned int count;      /* flagged observations of the current pixel */
+
+    for (i = 0; i < freq->nfields; i++)
+    {
+        for (pix = 0; pix < npix; pix++)
+        {
+            if (freq->wide)
+            {
+                nobs = ((uint16 *) freq->nobs)[pix];
+                count = ((uint16 *) freq->count[i])[pix];
+            }
+            else
+            {
+                nobs = ((uint8 *) freq->nobs)[pix];
+                count = ((uint8 *) freq->count[i])[pix];
+            }
+            if (nobs == 0)
+                out_buf[i][pix] = FREQ_NO_OBS;
+            else
+                out_buf[i][pix] = (uint8) ((200 * count + nobs) /
+                    (2 * nobs));
+        }
+    }
+
+    count_size = freq->wide ? sizeof (uint16) : sizeof (uint8);
+    memcpy (out_buf[freq->nfields], freq->nobs, npix * count_size);
+
+    for (i = 0; i < freq->nfields; i++)
+        memset (freq->count[i], 0, npix * count_size);
+    memset (freq->nobs, 0, npix * count_size);
+}
+
+
+/******************************************************************************
+MODULE:  free_qa_freq
+
+PURPOSE:  Free the counters and the unpacked planes.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void free_qa_freq
+(
+    Qa_freq_t *freq       /* I/O: counters */
+)
+{
+    int i;                   /* looping variable */
+
+    for (i = 0; i < UNPACK_MAX_FIELDS; i++)
+    {
+        free (freq->plane[i]);
+        free (freq->count[i]);
+        freq->plane[i] = NULL;
+        freq->count[i] = NULL;
+    }
+    free (freq->nobs);
+    freq->nobs = NULL;
+}
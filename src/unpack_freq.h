@@ -0,0 +1,71 @@
+#ifndef _UNPACK_FREQ_H_
+#define _UNPACK_FREQ_H_
+
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+#include "unpack_lut.h"
+
+#ifndef STR_SIZE
+#define STR_SIZE 1024
+#endif
+
+/* Most scenes counted with 8-bit counters, more use 16-bit counters */
+#define FREQ_MAX_COUNT8 255
+
+/* Most scenes in one stack */
+#define FREQ_MAX_SCENES 65535
+
+/* Frequency output value of a pixel without any valid observation */
+#define FREQ_NO_OBS 255
+
+/* Most lines in one band of lines, so the strips and tiles of all the scenes
+   line up with the bands */
+#define FREQ_MAX_BAND_LINES 4096
+
+/* Per-pixel counters of one band of lines of a stack of QA bands.  Each
+   unpack thread counts its own bands with its own counters. */
+typedef struct
+{
+    int nfields;          /* number of counted fields */
+    bool has_fill;        /* the last plane is the fill field, otherwise
+                             every pixel is valid */
+    bool wide;            /* the counters are 16-bit */
+    long npix;            /* number of pixels in one band of lines */
+    uint8 *plane[UNPACK_MAX_FIELDS];  /* unpacked 0/1 value of each field,
+                                         then of the fill field */
+    void *count[UNPACK_MAX_FIELDS];   /* flagged count of each field, uint8 or
+                                         uint16 */
+    void *nobs;           /* valid observation count, uint8 or uint16 */
+} Qa_freq_t;
+
+short init_qa_freq
+(
+    Qa_freq_t *freq,      /* O: counters */
+    int nfields,          /* I: number of counted fields */
+    bool has_fill,        /* I: a fill field is unpacked after the fields */
+    long npix,            /* I: number of pixels in one band of lines */
+    int nscenes           /* I: number of scenes in the stack */
+);
+
+void add_qa_freq
+(
+    Qa_freq_t *freq,      /* I/O: counters */
+    long first,           /* I: first pixel of the band to count */
+    long npix             /* I: number of pixels to count */
+);
+
+void get_qa_freq
+(
+    Qa_freq_t *freq,      /* I/O: counters, cleared for the next band */
+    long npix,            /* I: number of pixels in the band */
+    uint8 **out_buf       /* O: frequency of each field, then the valid
+                                observation count */
+);
+
+void free_qa_freq
+(
+    Qa_freq_t *freq       /* I/O: counters */
+);
+
+#endif
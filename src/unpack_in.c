@@ -0,0 +1,671 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined (WIN32) && !defined (_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "unpack_in.h"
+#include "unpack_pipeline.h"
+#include "unpack_tar.h"
+
+/******************************************************************************
+MODULE:  map_in_file
+
+PURPOSE:  Map the input file into memory so the lines of an uncompressed,
+stripped QA band can be used in place.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The file is mapped and the strips can be used in place
+false           The strips have to be read through libtiff
+
+NOTES:
+1. Only single band, uncompressed, stripped files in the byte order of the
+   host qualify.  Every strip must lie within the file and start on an even
+   offset so the lines can be used as uint16 arrays.
+2. Members of tar bundles are never mapped, their tiff file pointer isn't
+   open on a file of their own.
+******************************************************************************/
+static bool map_in_file
+(
+    In_reader_t *reader   /* I/O: reader */
+)
+{
+#if defined (WIN32) || defined (_WIN32)
+    (void) reader;
+    return (false);
+#else
+    TIFF *fp_tiff = reader->fp_tiff;
+    uint16 compress;         /* compression of the input file */
+    uint16 nbands = 1;       /* samples per pixel of the input file */
+    uint64 *strip_bytes;     /* bytes in each strip */
+    uint32 nstrips;          /* number of strips */
+    uint32 strip;            /* looping variable for the strips */
+    uint32 strip_lines;      /* lines in the current strip */
+    size_t line_bytes;       /* bytes in one line */
+    struct stat file_stat;   /* status of the input file */
+    void *map;               /* mapped input file */
+
+    if (is_tar_member (reader->infile))
+        return (false);
+    TIFFGetField (fp_tiff, TIFFTAG_COMPRESSION, &compress);
+    TIFFGetField (fp_tiff, TIFFTAG_SAMPLESPERPIXEL, &nbands);
+    if (compress != COMPRESSION_NONE || nbands != 1 ||
+        TIFFIsByteSwapped (fp_tiff))
+        return (false);
+    if (TIFFGetField (fp_tiff, TIFFTAG_STRIPOFFSETS, &reader->strip_offset)
+        == 0 || TIFFGetField (fp_tiff, TIFFTAG_STRIPBYTECOUNTS, &strip_bytes)
+        == 0)
+        return (false);
+    if (fstat (TIFFFileno (fp_tiff), &file_stat) != 0)
+        return (false);
+
+    /* Make sure every strip holds its lines within the file */
+    line_bytes = (size_t) reader->nsamps * sizeof (uint16);
+    nstrips = TIFFNumberOfStrips (fp_tiff);
+    for (strip = 0; strip < nstrips; strip++)
+    {
+        strip_lines = reader->rows_per_strip;
+        if ((uint64) strip * strip_lines + strip_lines > reader->nlines)
+            strip_lines = reader->nlines - strip * reader->rows_per_strip;
+        if (strip_bytes[strip] < strip_lines * line_bytes ||
+            reader->strip_offset[strip] % 2 != 0 ||
+            reader->strip_offset[strip] + strip_lines * line_bytes >
+            (uint64) file_stat.st_size)
+            return (false);
+    }
+
+    map = mmap (NULL, file_stat.st_size, PROT_READ, MAP_SHARED,
+        TIFFFileno (fp_tiff), 0);
+    if (map == MAP_FAILED)
+        return (false);
+    madvise (map, file_stat.st_size, MADV_SEQUENTIAL);
+
+    reader->map = (uint8 *) map;
+    reader->map_size = file_stat.st_size;
+    return (true);
+#endif
+}
+
+
+/******************************************************************************
+MODULE:  init_in_reader
+
+PURPOSE:  Set up the reader of the QA band of an open input file, choosing
+the cheapest way to read it.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. Uncompressed stripped files are mapped and their lines used in place.
+   Other stripped files are read a whole number of strips per block, each
+   strip decoded straight into the block.  Tiled files are read one row of
+   tiles per block.
+2. Files that are decoded, rather than mapped, are read in parallel when
+   there is more than one worker.  Each extra worker opens the input file
+   again, since a tiff file pointer can only decode on one thread at a time.
+   Members of tar bundles are never mapped.
+3. A lazy reader leaves the extra workers' files to be opened by
+   read_in_lines, so callers reading many inputs in turn only keep one file
+   per worker open at a time (see release_in_worker).
+******************************************************************************/
+short init_in_reader
+(
+    In_reader_t *reader,  /* O: reader */
+    TIFF *fp_tiff,        /* I: tiff file pointer of the input file */
+    char *infile,         /* I: input filename */
+    int nworkers,         /* I: number of workers that will read blocks */
+    bool lazy             /* I: open the input file for the extra workers on
+                                their first read rather than now */
+)
+{
+    char FUNC_NAME[] = "init_in_reader"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    uint32 tile_length;      /* length of each tile (if tiled) */
+    int worker;              /* looping variable for the workers */
+
+    if (nworkers < 1)
+        nworkers = 1;
+    reader->fp_tiff = fp_tiff;
+    reader->infile = infile;
+    reader->nworkers = 0;
+    reader->parallel = false;
+    reader->lazy = lazy;
+    reader->strip_offset = NULL;
+    reader->map = NULL;
+    reader->map_size = 0;
+    reader->tile_buf = NULL;
+    reader->strip_buf = NULL;
+    TIFFGetField (fp_tiff, TIFFTAG_IMAGELENGTH, &reader->nlines);
+    TIFFGetField (fp_tiff, TIFFTAG_IMAGEWIDTH, &reader->nsamps);
+    reader->win_line = 0;
+    reader->win_samp = 0;
+    reader->win_nlines = reader->nlines;
+    reader->win_nsamps = reader->nsamps;
+    reader->lead_lines = 0;
+
+    reader->worker_fp = (TIFF **) calloc (nworkers, sizeof (TIFF *));
+    if (reader->worker_fp == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the readers of %s",
+            infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    reader->worker_fp[0] = fp_tiff;
+    reader->nworkers = 1;
+
+    if (TIFFIsTiled (fp_tiff))
+    {
+        reader->method = IN_READ_TILE;
+        TIFFGetField (fp_tiff, TIFFTAG_TILEWIDTH, &reader->tile_width);
+        TIFFGetField (fp_tiff, TIFFTAG_TILELENGTH, &tile_length);
+        reader->block_lines = tile_length;
+    }
+    else
+    {
+        reader->rows_per_strip = reader->nlines;
+        TIFFGetField (fp_tiff, TIFFTAG_ROWSPERSTRIP, &reader->rows_per_strip);
+        if (reader->rows_per_strip > reader->nlines)
+            reader->rows_per_strip = reader->nlines;
+        if (map_in_file (reader))
+        {
+            reader->method = IN_READ_MAP;
+            reader->block_lines = PIPE_BLOCK_LINES;
+            return (SUCCESS);
+        }
+
+        /* Read as many whole strips per block as fit in the default block */
+        reader->method = IN_READ_STRIP;
+        reader->block_lines = (PIPE_BLOCK_LINES / reader->rows_per_strip) *
+            reader->rows_per_strip;
+        if (reader->block_lines == 0)
+            reader->block_lines = reader->rows_per_strip;
+    }
+
+    /* Open the input file once more for each extra worker */
+    for (worker = 1; worker < nworkers; worker++)
+    {
+        if (lazy)
+        {
+            reader->nworkers++;
+            continue;
+        }
+        reader->worker_fp[worker] = open_qa_tiff (infile);
+        if (reader->worker_fp[worker] == NULL)
+        {
+            sprintf (errmsg, "Error opening %s for reader %d", infile,
+                worker);
+            error_handler (true, FUNC_NAME, errmsg);
+            free_in_reader (reader);
+            return (ERROR);
+        }
+        reader->nworkers++;
+    }
+    reader->parallel = (reader->nworkers > 1);
+
+    if (reader->method == IN_READ_TILE)
+    {
+        reader->tile_buf = (uint16 **) calloc (reader->nworkers,
+            sizeof (uint16 *));
+        for (worker = 0; reader->tile_buf != NULL &&
+            worker < reader->nworkers; worker++)
+        {
+            reader->tile_buf[worker] = (uint16 *) _TIFFmalloc (TIFFTileSize (
+                fp_tiff));
+            if (reader->tile_buf[worker] == NULL)
+                break;
+        }
+        if (reader->tile_buf == NULL || worker < reader->nworkers)
+        {
+            sprintf (errmsg, "Error allocating memory (1 tile) for the "
+                "input QA band of %s", infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            free_in_reader (reader);
+            return (ERROR);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  set_in_window
+
+PURPOSE:  Restrict the reader to a window of the QA band, so only the strips
+or tiles the window touches are read.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           The window isn't within the QA band or memory couldn't be
+                allocated
+SUCCESS         Processing was successful
+
+NOTES:
+1. The lines read are then numbered from the first line of the window and
+   hold only its samples.
+2. The first block of the window is lead_lines short of block_lines, so the
+   following blocks start on the strips or tiles.
+******************************************************************************/
+short set_in_window
+(
+    In_reader_t *reader,  /* I/O: reader */
+    uint32 line,          /* I: first input line of the window */
+    uint32 samp,          /* I: first input sample of the window */
+    uint32 nlines,        /* I: number of lines in the window */
+    uint32 nsamps         /* I: number of samples in the window */
+)
+{
+    char FUNC_NAME[] = "set_in_window"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    int worker;              /* looping variable for the workers */
+
+    if (nlines == 0 || nsamps == 0 || line >= reader->nlines ||
+        samp >= reader->nsamps || nlines > reader->nlines - line ||
+        nsamps > reader->nsamps - samp)
+    {
+        sprintf (errmsg, "Window of %u lines and %u samples at line %u, "
+            "sample %u isn't within the %u lines and %u samples of %s",
+            nlines, nsamps, line, samp, reader->nlines, reader->nsamps,
+            reader->infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    reader->win_line = line;
+    reader->win_samp = samp;
+    reader->win_nlines = nlines;
+    reader->win_nsamps = nsamps;
+    reader->lead_lines = (reader->method == IN_READ_MAP) ? 0 :
+        line % reader->block_lines;
+
+    /* Strips cut by the window are decoded aside and copied in part */
+    if (reader->method != IN_READ_STRIP || reader->strip_buf != NULL ||
+        (nlines == reader->nlines && nsamps == reader->nsamps))
+        return (SUCCESS);
+    reader->strip_buf = (uint16 **) calloc (reader->nworkers,
+        sizeof (uint16 *));
+    for (worker = 0; reader->strip_buf != NULL &&
+        worker < reader->nworkers; worker++)
+    {
+        reader->strip_buf[worker] = (uint16 *) _TIFFmalloc (
+            TIFFStripSize (reader->fp_tiff));
+        if (reader->strip_buf[worker] == NULL)
+            break;
+    }
+    if (reader->strip_buf == NULL || worker < reader->nworkers)
+    {
+        sprintf (errmsg, "Error allocating memory (1 strip) for the "
+            "window of %s", reader->infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  read_in_lines
+
+PURPOSE:  Read a block of lines of the window of the QA band.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. Mapped lines are handed back in place when the block spans the whole
+   width and lies in contiguous strips, which is the usual layout.
+   Otherwise they are copied into qa_buf.
+2. line should be the first line of a block (see set_in_window).  Strips
+   within the block and the width are decoded straight into qa_buf.  Strips
+   cut by the block or window are decoded aside and copied in part.  Tiles
+   are only read in the columns of the window.
+3. Each worker must only read one block at a time.
+4. A worker of a lazy reader opens the input file if it hasn't yet.
+******************************************************************************/
+short read_in_lines
+(
+    In_reader_t *reader,  /* I/O: reader */
+    int worker,           /* I: worker reading the block */
+    uint32 line,          /* I: first line of the window to read */
+    uint32 nlines,        /* I: number of lines to read */
+    uint16 *qa_buf,       /* O: buffer for nlines lines of QA values */
+    uint16 **qa_lines     /* O: the nlines lines, either qa_buf or the lines
+                                in the mapped file */
+)
+{
+    char FUNC_NAME[] = "read_in_lines"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    uint32 i;                /* looping variable */
+    uint32 rps = reader->rows_per_strip;  /* lines in each strip */
+    uint32 nsamps = reader->win_nsamps;   /* samples in each line read */
+    uint32 in_line;          /* first input line to read */
+    uint32 end_line;         /* input line after the last one to read */
+    uint32 strip;            /* current strip */
+    uint32 first_line;       /* first input line of the strip or tile */
+    uint32 last_line;        /* input line after the strip or tile */
+    uint32 from, to;         /* input lines of the strip or tile to copy */
+    uint32 samp;             /* first sample of the current tile */
+    uint32 first_samp;       /* first input sample of the tile to copy */
+    uint32 samples_to_copy;  /* number of samples of the tile to copy */
+    size_t line_bytes;       /* bytes in one input line */
+    size_t skip_bytes;       /* bytes of each input line before the window */
+    uint8 *first, *last;     /* first and last lines in the mapped file */
+    TIFF *fp_tiff = reader->worker_fp[worker];  /* file of the worker */
+    uint16 *tile_buf;        /* tile of the worker */
+    uint16 *strip_buf;       /* strip of the worker, for cut strips */
+
+    if (fp_tiff == NULL && reader->method != IN_READ_MAP)
+    {
+        fp_tiff = open_qa_tiff (reader->infile);
+        if (fp_tiff == NULL)
+        {
+            sprintf (errmsg, "Error opening %s for reader %d",
+                reader->infile, worker);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        reader->worker_fp[worker] = fp_tiff;
+    }
+
+    *qa_lines = qa_buf;
+    line_bytes = (size_t) reader->nsamps * sizeof (uint16);
+    skip_bytes = (size_t) reader->win_samp * sizeof (uint16);
+    in_line = reader->win_line + line;
+    end_line = in_line + nlines;
+
+    if (reader->method == IN_READ_MAP)
+    {
+        first = &reader->map[reader->strip_offset[in_line / rps] +
+            (size_t) (in_line % rps) * line_bytes];
+        last = &reader->map[reader->strip_offset[(end_line - 1) / rps] +
+            (size_t) ((end_line - 1) % rps) * line_bytes];
+        if (nsamps == reader->nsamps &&
+            last == first + (size_t) (nlines - 1) * line_bytes)
+        {
+            *qa_lines = (uint16 *) first;
+            return (SUCCESS);
+        }
+
+        for (i = 0; i < nlines; i++)
+            memcpy (&qa_buf[(size_t) i * nsamps],
+                &reader->map[reader->strip_offset[(in_line + i) / rps] +
+                (size_t) ((in_line + i) % rps) * line_bytes + skip_bytes],
+                (size_t) nsamps * sizeof (uint16));
+        return (SUCCESS);
+    }
+
+    if (reader->method == IN_READ_STRIP)
+    {
+        for (strip = in_line / rps; strip * rps < end_line; strip++)
+        {
+            first_line = strip * rps;
+            last_line = first_line + rps;
+            if (last_line > reader->nlines)
+                last_line = reader->nlines;
+            from = (first_line > in_line) ? first_line : in_line;
+            to = (last_line < end_line) ? last_line : end_line;
+
+            /* Whole strips of the whole width go straight into the block */
+            if (from == first_line && to == last_line &&
+                nsamps == reader->nsamps)
+            {
+                if (TIFFReadEncodedStrip (fp_tiff, strip, &qa_buf[(size_t)
+                    (first_line - in_line) * nsamps], -1) == -1)
+                    break;
+                continue;
+            }
+
+            if (reader->strip_buf == NULL)
+            {
+                sprintf (errmsg, "Line %u of %s isn't the start of a block",
+                    line, reader->infile);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            strip_buf = reader->strip_buf[worker];
+            if (TIFFReadEncodedStrip (fp_tiff, strip, strip_buf, -1) == -1)
+                break;
+            for (i = from; i < to; i++)
+                memcpy (&qa_buf[(size_t) (i - in_line) * nsamps],
+                    &strip_buf[(size_t) (i - first_line) * reader->nsamps +
+                    reader->win_samp], (size_t) nsamps * sizeof (uint16));
+        }
+        if (strip * rps < end_line)
+        {
+            sprintf (errmsg, "Error reading the strip at line %u from %s",
+                strip * rps, reader->infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        return (SUCCESS);
+    }
+
+    tile_buf = reader->tile_buf[worker];
+    for (first_line = in_line - in_line % reader->block_lines;
+        first_line < end_line; first_line += reader->block_lines)
+    {
+        from = (first_line > in_line) ? first_line : in_line;
+        to = first_line + reader->block_lines;
+        if (to > end_line)
+            to = end_line;
+
+        for (samp = reader->win_samp - reader->win_samp % reader->tile_width;
+            samp < reader->win_samp + nsamps; samp += reader->tile_width)
+        {
+            if (TIFFReadTile (fp_tiff, tile_buf, samp, first_line, 0, 0)
+                == -1)
+            {
+                sprintf (errmsg, "Error reading the tile at line %u, sample "
+                    "%u from %s", first_line, samp, reader->infile);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+
+            /* Only copy the part of the tile within the window, which
+               also leaves out the parts of the last tile in a row or
+               column that go outside the image boundaries */
+            first_samp = (samp > reader->win_samp) ? samp : reader->win_samp;
+            samples_to_copy = samp + reader->tile_width - first_samp;
+            if (first_samp + samples_to_copy > reader->win_samp + nsamps)
+                samples_to_copy = reader->win_samp + nsamps - first_samp;
+
+            /* Put each tile line in its spot of the block */
+            for (i = from; i < to; i++)
+                memcpy (&qa_buf[(size_t) (i - in_line) * nsamps +
+                    first_samp - reader->win_samp],
+                    &tile_buf[(size_t) (i - first_line) * reader->tile_width +
+                    first_samp - samp], samples_to_copy * sizeof (uint16));
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  release_in_worker
+
+PURPOSE:  Close the input file a worker of a lazy reader opened, once it is
+done reading for now.  The worker opens it again on its next read.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The first worker's file is the one passed to init_in_reader and is left
+   open, as are the files of a reader that isn't lazy.
+******************************************************************************/
+void release_in_worker
+(
+    In_reader_t *reader,  /* I/O: reader */
+    int worker            /* I: worker done reading for now */
+)
+{
+    if (!reader->lazy || worker < 1 || worker >= reader->nworkers ||
+        reader->worker_fp[worker] == NULL)
+        return;
+    XTIFFClose (reader->worker_fp[worker]);
+    reader->worker_fp[worker] = NULL;
+}
+
+
+/******************************************************************************
+MODULE:  free_in_reader
+
+PURPOSE:  Unmap the input file, close the files opened for the extra workers
+and free the buffers of the reader.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The tiff file pointer passed to init_in_reader is left open.
+******************************************************************************/
+void free_in_reader
+(
+    In_reader_t *reader   /* I/O: reader */
+)
+{
+    int worker;              /* looping variable for the workers */
+
+#if !defined (WIN32) && !defined (_WIN32)
+    if (reader->map != NULL)
+        munmap (reader->map, reader->map_size);
+#endif
+    reader->map = NULL;
+
+    if (reader->tile_buf != NULL)
+    {
+        for (worker = 0; worker < reader->nworkers; worker++)
+            if (reader->tile_buf[worker] != NULL)
+                _TIFFfree (reader->tile_buf[worker]);
+        free (reader->tile_buf);
+        reader->tile_buf = NULL;
+    }
+    if (reader->strip_buf != NULL)
+    {
+        for (worker = 0; worker < reader->nworkers; worker++)
+            if (reader->strip_buf[worker] != NULL)
+                _TIFFfree (reader->strip_buf[worker]);
+        free (reader->strip_buf);
+        reader->strip_buf = NULL;
+    }
+
+    if (reader->worker_fp != NULL)
+    {
+        for (worker = 1; worker < reader->nworkers; worker++)
+            if (reader->worker_fp[worker] != NULL)
+                XTIFFClose (reader->worker_fp[worker]);
+        free (reader->worker_fp);
+        reader->worker_fp = NULL;
+    }
+    reader->nworkers = 0;
+}
+
+
+/******************************************************************************
+MODULE:  read_qa_list
+
+PURPOSE:  Read a list of input QA filenames, one per line.  Blank lines and
+lines starting with # are skipped.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the list
+SUCCESS         Processing was successful
+
+NOTES:
+1. The filenames read so far are returned even on error, for the caller to
+   free.
+******************************************************************************/
+short read_qa_list
+(
+    char *list_file,      /* I: file listing the input QA filenames */
+    char ***infile,       /* O: input QA filenames, each allocated */
+    int *nfiles           /* O: number of input QA filenames */
+)
+{
+    char FUNC_NAME[] = "read_qa_list"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char line[STR_SIZE];     /* line of the list */
+    char *name;              /* filename on the line */
+    char **grown;            /* grown list of filenames */
+    int len;                 /* length of the filename */
+    int nalloc = 0;          /* number of filenames allocated */
+    FILE *fp;                /* list file pointer */
+
+    *infile = NULL;
+    *nfiles = 0;
+    fp = fopen (list_file, "r");
+    if (fp == NULL)
+    {
+        sprintf (errmsg, "Error opening the QA list file: %s", list_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    while (fgets (line, sizeof (line), fp) != NULL)
+    {
+        /* Trim the surrounding white space, including the line end */
+        name = line;
+        while (isspace ((unsigned char) *name))
+            name++;
+        len = strlen (name);
+        while (len > 0 && isspace ((unsigned char) name[len-1]))
+            name[--len] = '\0';
+        if (len == 0 || name[0] == '#')
+            continue;
+
+        if (*nfiles == nalloc)
+        {
+            nalloc = nalloc > 0 ? 2 * nalloc : 64;
+            grown = (char **) realloc (*infile, nalloc * sizeof (char *));
+            if (grown == NULL)
+            {
+                sprintf (errmsg, "Error allocating memory for the QA list");
+                error_handler (true, FUNC_NAME, errmsg);
+                fclose (fp);
+                return (ERROR);
+            }
+            *infile = grown;
+        }
+        (*infile)[*nfiles] = strdup (name);
+        if ((*infile)[*nfiles] == NULL)
+        {
+            sprintf (errmsg, "Error allocating memory for the QA list");
+            error_handler (true, FUNC_NAME, errmsg);
+            fclose (fp);
+            return (ERROR);
+        }
+        (*nfiles)++;
+    }
+    fclose (fp);
+
+    if (*nfiles == 0)
+    {
+        sprintf (errmsg, "No QA files are listed in %s", list_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
@@ -0,0 +1,103 @@
+#ifndef _UNPACK_IN_H_
+#define _UNPACK_IN_H_
+
+#include <stddef.h>
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+
+#ifndef STR_SIZE
+#define STR_SIZE 1024
+#endif
+
+/* Ways the QA band is read */
+#define IN_READ_MAP 0     /* uncompressed strips used in place in the mapped
+                             file */
+#define IN_READ_STRIP 1   /* whole strips decoded with TIFFReadEncodedStrip */
+#define IN_READ_TILE 2    /* rows of tiles decoded with TIFFReadTile */
+
+/* Reader of the uint16 QA band, or of a window of it.  Blocks of
+   block_lines lines are read starting at line 0 of the window, in order
+   unless the reader is parallel, the first block being lead_lines short so
+   the others start on the strips or tiles.  A parallel reader decodes
+   different blocks on several workers at once, each worker with its own
+   tiff file pointer.  A lazy reader opens those of the extra workers on
+   their first read and closes them again with release_in_worker. */
+typedef struct
+{
+    TIFF *fp_tiff;        /* tiff file pointer of the input file */
+    int nworkers;         /* number of workers reading blocks */
+    bool parallel;        /* the workers may read blocks at the same time */
+    bool lazy;            /* the extra workers open the input file when they
+                             read, NULL until then */
+    TIFF **worker_fp;     /* tiff file pointer of each worker, the first is
+                             fp_tiff */
+    char *infile;         /* input filename */
+    uint32 nlines;        /* number of lines in the input */
+    uint32 nsamps;        /* number of samples in the input */
+    int method;           /* one of the IN_READ_* methods */
+    uint32 block_lines;   /* lines in each block to be read */
+    uint32 rows_per_strip;  /* lines in each strip (if stripped) */
+    uint64 *strip_offset; /* file offset of each strip (if mapped) */
+    uint8 *map;           /* mapped input file (if mapped) */
+    size_t map_size;      /* size of the mapped input file */
+    uint32 tile_width;    /* width of each tile (if tiled) */
+    uint16 **tile_buf;    /* one tile per worker (if tiled) */
+    uint32 win_line;      /* first input line of the window */
+    uint32 win_samp;      /* first input sample of the window */
+    uint32 win_nlines;    /* number of lines in the window */
+    uint32 win_nsamps;    /* number of samples in the window */
+    uint32 lead_lines;    /* lines the first block of the window is short */
+    uint16 **strip_buf;   /* one strip per worker, for the strips only partly
+                             in the window (if decoded strips) */
+} In_reader_t;
+
+short init_in_reader
+(
+    In_reader_t *reader,  /* O: reader */
+    TIFF *fp_tiff,        /* I: tiff file pointer of the input file */
+    char *infile,         /* I: input filename */
+    int nworkers,         /* I: number of workers that will read blocks */
+    bool lazy             /* I: open the input file for the extra workers on
+                                their first read rather than now */
+);
+
+short set_in_window
+(
+    In_reader_t *reader,  /* I/O: reader */
+    uint32 line,          /* I: first input line of the window */
+    uint32 samp,          /* I: first input sample of the window */
+    uint32 nlines,        /* I: number of lines in the window */
+    uint32 nsamps         /* I: number of samples in the window */
+);
+
+short read_in_lines
+(
+    In_reader_t *reader,  /* I/O: reader */
+    int worker,           /* I: worker reading the block */
+    uint32 line,          /* I: first line of the window to read */
+    uint32 nlines,        /* I: number of lines to read */
+    uint16 *qa_buf,       /* O: buffer for nlines lines of QA values */
+    uint16 **qa_lines     /* O: the nlines lines, either qa_buf or the lines
+                                in the mapped file */
+);
+
+void release_in_worker
+(
+    In_reader_t *reader,  /* I/O: reader */
+    int worker            /* I: worker done reading for now */
+);
+
+void free_in_reader
+(
+    In_reader_t *reader   /* I/O: reader */
+);
+
+short read_qa_list
+(
+    char *list_file,      /* I: file listing the input QA filenames */
+    char ***infile,       /* O: input QA filenames, each allocated */
+    int *nfiles           /* O: number of input QA filenames */
+);
+
+#endif
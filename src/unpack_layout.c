@@ -0,0 +1,2180 @@
+#include <math.h>
+#include "unpack_in.h"
+#include "unpack_pipeline.h"
+#include "unpack_stats.h"
+#include "unpack_estimate.h"
+#include "unpack_expr.h"
+#include "unpack_freq.h"
+#include "unpack_points.h"
+#include "unpack_tar.h"
+#include "unpack_layout.h"
+
+/* Context shared by the read, unpack and write stages of the pipeline */
+typedef struct
+{
+    In_reader_t reader;    /* reader of the input QA band */
+    uint32 nsamps;         /* number of samples */
+    int nout;              /* number of output files */
+    uint16 planar_config;  /* PLANARCONFIG_* of multiband output, 0 when each
+                              field has its own output */
+    Unpacker_t unpacker;   /* unpacker for all the outputs */
+    Out_writer_t writer[UNPACK_MAX_FIELDS];  /* writer of each output */
+    Qa_stats_t *stats;     /* statistics gathered from the QA values, NULL
+                              if none */
+} Unpack_ctx_t;
+
+/* Context shared by the stages of the pipeline of a stack of QA bands.
+   Each unpack thread counts its bands of lines with its own counters. */
+typedef struct
+{
+    int nscenes;           /* number of scenes in the stack */
+    In_reader_t *reader;   /* reader of the QA band of each scene */
+    uint32 nsamps;         /* number of samples */
+    int nout;              /* number of output files */
+    Unpacker_t unpacker;   /* unpacker of the fields and the fill field */
+    Qa_freq_t *freq;       /* counters of each unpack thread */
+    Out_writer_t writer[UNPACK_MAX_FIELDS];  /* writer of each output */
+} Freq_ctx_t;
+
+/* Attributes and geokeys of the input QA band, copied to the outputs */
+typedef struct
+{
+    TIFF *fp_tiff;           /* tiff file pointer for input file */
+    uint32 nlines, nsamps;   /* number of lines and samples */
+    int proj_type;           /* projection type */
+    uint16 coord_sys;        /* geokey for coordinate system */
+    uint16 model_type;       /* geokey for the model type */
+    uint16 linear_units;     /* geokey for the linear units */
+    uint16 angular_units;    /* geokey for the angular units */
+    uint16 projected_type;   /* geokey for the angular units */
+    uint16 proj_linear_units; /* geokey for the proj linear units (PS proj) */
+    double proj_parms[15];   /* projection parameters (PS proj) */
+    double tie_points[6];    /* corner point information */
+    double pixel_size[3];    /* pixel size (x, y, -) */
+    char citation[STR_SIZE]; /* geokey for citation string */
+} Qa_band_t;
+
+
+/******************************************************************************
+MODULE:  read_attributes
+
+PURPOSE:  Read the file attributes and geokey information from the GeoTIFF file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+HISTORY:
+Date          Programmer       Reason
+----------    ---------------  -------------------------------------
+6/19/2013     Gail Schmidt     Original Development
+7/12/2016     Gail Schmidt     Updated to read ProjStraightVertPoleLongGeoKey
+                               if ProjStraightVertPoleLongGeoKey does not exist
+                               for Polar Stereographic scenes
+
+NOTES:
+******************************************************************************/
+short read_attributes
+(
+    char *infile,      /* I: input geotiff filename */
+    int *proj,         /* O: projection type */
+    uint32 *nlines,    /* O: number of lines in tiff image */
+    uint32 *nsamps,    /* O: number of samples in tiff image */
+    uint32 *tile_width,     /* O: width of each tile (if tiled) */
+    uint32 *tile_length,    /* O: length of each tile (if tiled) */
+    bool *tiled,            /* O: image is in Geotiff tiled format */
+    uint16 *bitspersample,  /* O: bits per sample in tiff image */
+    uint16 *sampleformat,   /* O: data type of tiff image */
+    double tie_point[6],    /* O: corner tie points for projection [3] is ULx
+                                  and [4] is ULy */
+    double pixel_size[3],   /* O: pixel size array (x, y, -) */
+    uint16 *coord_sys,      /* O: coordinate system used (PixelIsArea or
+                                  PixelIsPoint) */
+    uint16 *model_type,     /* O: geokey for the model type */
+    uint16 *linear_units,   /* O: geokey for the linear units */
+    uint16 *angular_units,  /* O: geokey for the angular units */
+    uint16 *projected_type, /* O: geokey for the angular units */
+    uint16 *proj_linear_units, /* O: geokey for proj linear units (PS proj) */
+    double proj_parms[15],  /* O: projection parameters (PS proj) */
+    char *citation          /* O: citation string */
+)
+{
+    char FUNC_NAME[] = "read_attributes"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    int i;                   /* looping variable */
+    int cit_length;          /* length of citation key */
+    int size;                /* size of individual element in citation var */
+    int proj_type;           /* projection type geokey value */
+    tagtype_t type;          /* tag type of the citation variable */
+    double *tiePoint=NULL;   /* pointer for reading the tiepoints */
+    double *pixelScale=NULL; /* pointer for reading the pixel size */
+    uint16 count;            /* count of attributes to be read from tiff file */
+    TIFF *fp_tiff=NULL;      /* tiff file pointer for input file */
+    GTIF *fp_gtif=NULL;      /* geotiff key parser for input file */
+
+    /* Open the input tiff file, which may be a member of a tar bundle */
+    if ((fp_tiff = open_qa_tiff (infile)) == NULL)
+    {
+        sprintf (errmsg, "Error opening base TIFF file %s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    } 
+  
+    /* Get metadata from tiff file */
+    if (TIFFGetField (fp_tiff, TIFFTAG_IMAGELENGTH, nlines) == 0)
+    {
+        sprintf (errmsg, "Error reading number of lines from base TIFF file "
+            "%s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+  
+    if (TIFFGetField (fp_tiff, TIFFTAG_IMAGEWIDTH, nsamps) == 0)
+    {
+        sprintf (errmsg, "Error reading number of samples from base TIFF file "
+            "%s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+  
+    if (TIFFGetField (fp_tiff, TIFFTAG_BITSPERSAMPLE, bitspersample) == 0)
+    {
+        sprintf (errmsg, "Error reading bitspersample from base TIFF file "
+            "%s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+  
+    if (TIFFGetField (fp_tiff, TIFFTAG_SAMPLEFORMAT, sampleformat) == 0)
+    {
+        sprintf (errmsg, "Error reading sampleformat from base TIFF file "
+            "%s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    *tiled = false;
+    if (TIFFIsTiled(fp_tiff))
+    {
+        if (TIFFGetField (fp_tiff, TIFFTAG_TILEWIDTH, tile_width) == 0)
+        {
+            sprintf (errmsg, "Error reading tile width from base TIFF file "
+                "%s", infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        if (TIFFGetField (fp_tiff, TIFFTAG_TILELENGTH, tile_length) == 0)
+        {
+            sprintf (errmsg, "Error reading tile length from base TIFF file "
+                "%s", infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        *tiled = true;
+    }
+  
+    count = 6;
+    if (TIFFGetField (fp_tiff, TIFFTAG_GEOTIEPOINTS, &count, &tiePoint) == 0)
+    {
+        sprintf (errmsg, "Error reading tiepoints from base TIFF file %s",
+            infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    for (i = 0; i < count; i++)
+        tie_point[i] = tiePoint[i];
+  
+    count = 3;
+    if (TIFFGetField (fp_tiff, TIFFTAG_GEOPIXELSCALE, &count, &pixelScale) == 0)
+    {
+        sprintf (errmsg, "Error reading pixel size from base TIFF file %s",
+            infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    for (i = 0; i < count; i++)
+        pixel_size[i] = pixelScale[i];
+
+    /* Open the key parser for the geotiff file */
+    fp_gtif = GTIFNew (fp_tiff);
+
+    /* Try to read the coordinate transform geokey.  If it is set and set to
+       polar stereographic, then process the PS geokeys.  If it isn't set, then
+       assume geokeys for UTM.  If it's set and not PS, then flag it as an
+       error. */
+    *proj = UNDEFINED_PROJ;
+    if (!GTIFKeyGet (fp_gtif, ProjCoordTransGeoKey, &proj_type, 0, 1))
+    {  /* assume UTM projection */
+        *proj = UTM_PROJ;
+    }
+    else if (proj_type == CT_PolarStereographic)
+    {  /* assume PS projection */
+        *proj = PS_PROJ;
+    }
+    else
+    {
+        sprintf (errmsg, "Unsupported projection type in the GeoTIFF file.  "
+            "If the ProjCoordTransGeoKey is not set, then UTM is assumed.  If "
+            "this key is set, then it is expected to be "
+            "CT_PolarStereographic.");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Read the various GeoKeys */
+    if (!GTIFKeyGet (fp_gtif, GTModelTypeGeoKey, model_type, 0, 1))
+    {
+        sprintf (errmsg, "Error reading the GTModelTypeGeoKey from the "
+            "GeoTIFF file %s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    cit_length = GTIFKeyInfo (fp_gtif, GTCitationGeoKey, &size, &type);
+    if (GTIFKeyGet (fp_gtif, GTCitationGeoKey, citation, 0, cit_length) !=
+        cit_length)
+    {
+        sprintf (errmsg, "Error reading the GTCitationGeoKey from the "
+            "GeoTIFF file %s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Allow either GeogLinearUnitsGeoKey or ProjLinearUnitsGeoKey for
+       linear_units.  Use GeogLinearUnitsGeoKey if available */
+    if (!GTIFKeyGet (fp_gtif, GeogLinearUnitsGeoKey, linear_units, 0, 1))
+    {
+        if (!GTIFKeyGet (fp_gtif, ProjLinearUnitsGeoKey, linear_units,
+            0, 1))
+        {
+            sprintf (errmsg, "Error reading GeogLinearUnitsGeoKey or "
+                "ProjLinearUnitsGeoKey from GeoTIFF file %s", infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    if (!GTIFKeyGet (fp_gtif, GeogAngularUnitsGeoKey, angular_units, 0, 1))
+    {
+        sprintf (errmsg, "Error reading the GeogAngularUnitsGeoKey from the "
+            "GeoTIFF file %s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (!GTIFKeyGet (fp_gtif, ProjectedCSTypeGeoKey, projected_type, 0, 1))
+    {
+        sprintf (errmsg, "Error reading the ProjectedCSTypeGeoKey from the "
+            "GeoTIFF file %s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* GTRasterTypeGeoKey dictates whether the reference coordinate is the UL
+       (*RasterPixelIsArea*, code 1) or center (*RasterPixelIsPoint*, code 2)
+       of the UL pixel. If this key is missing, the default (as defined by the
+       specification) is to be *RasterPixelIsArea*, which is the UL of the UL
+       pixel. */
+    if (!GTIFKeyGet (fp_gtif, GTRasterTypeGeoKey, coord_sys, 0, 1))
+    {
+        /* use a flag to specify that it wasn't in the current file */
+        *coord_sys = -99;
+    }
+
+    /* Read additional geokeys for polar stereographic projection */
+    if (*proj == PS_PROJ)
+    {
+        if (!GTIFKeyGet (fp_gtif, ProjLinearUnitsGeoKey, proj_linear_units,
+            0, 1))
+        {
+            sprintf (errmsg, "Error reading ProjLinearUnitsGeoKey from "
+                "GeoTIFF file %s", infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        if (!GTIFKeyGet (fp_gtif, ProjNatOriginLongGeoKey, &proj_parms[4],
+            0, 1))
+        {
+            if (!GTIFKeyGet (fp_gtif, ProjStraightVertPoleLongGeoKey,
+                &proj_parms[4], 0, 1))
+            {
+                sprintf (errmsg, "Error reading ProjNatOriginLongGeoKey or "
+                    "ProjStraightVertPoleLongGeoKey from GeoTIFF file %s",
+                    infile);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+        }
+
+        if (!GTIFKeyGet (fp_gtif, ProjNatOriginLatGeoKey, &proj_parms[5], 0, 1))
+        {
+            sprintf (errmsg, "Error reading ProjNatOrigintLatGeoKey from "
+                "GeoTIFF file %s", infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        if (!GTIFKeyGet (fp_gtif, ProjFalseEastingGeoKey, &proj_parms[6], 0, 1))
+        {
+            sprintf (errmsg, "Error reading ProjFalseEastingGeoKey from "
+                "GeoTIFF file %s", infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        if (!GTIFKeyGet (fp_gtif, ProjFalseNorthingGeoKey, &proj_parms[7],
+            0, 1))
+        {
+            sprintf (errmsg, "Error reading ProjFalseNorthingGeoKey from "
+                "GeoTIFF file %s", infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    /* Close the geotiff key parser */
+    GTIFFree (fp_gtif);
+
+    /* Close the input tiff file */
+    XTIFFClose (fp_tiff);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  create_tiff
+
+PURPOSE:  Create the tiff file and set the attributes.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+NULL            An error occurred during processing
+TIFF *          Successful creation of the new GeoTIFF file
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+HISTORY:
+Date          Programmer       Reason
+----------    ---------------  -------------------------------------
+6/19/2013     Gail Schmidt     Original Development
+
+NOTES:
+******************************************************************************/
+TIFF *create_tiff
+(
+    char *tiffile,         /* I: geotiff filename */
+    int proj,              /* I: projection type */
+    uint32 nlines,         /* I: number of lines in tiff image */
+    uint32 nsamps,         /* I: number of samples in tiff image */
+    double *tie_point,     /* I: corner tie points for projection [3] is ULx
+                                 and [4] is ULy (pass address of this array, as
+                                 memory is allocated) */
+    double *pixel_size,    /* I: pixel size array (x, y) (pass address of this
+                                 array, as memory is allocated) */
+    uint16 coord_sys,      /* I: coordinate system used (PixelIsArea or
+                                 PixelIsPoint) */
+    uint16 model_type,     /* I: geokey for the model type */
+    uint16 linear_units,   /* I: geokey for the linear units */
+    uint16 angular_units,  /* I: geokey for the angular units */
+    uint16 projected_type, /* I: geokey for the angular units */
+    uint16 proj_linear_units, /* O: geokey for proj linear units (PS proj) */
+    double proj_parms[15],  /* O: projection parameters (PS proj) */
+    char *citation,        /* I: citation string */
+    uint16 nbands,         /* I: number of bands */
+    uint16 bitspersample,  /* I: bits per sample, 8 or 16 or packed 1 or 2 */
+    Out_opts_t *out_opts   /* I: compression and layout of the output */
+)
+{
+    char FUNC_NAME[] = "create_tiff"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+
+    uint16 count;            /* count of attributes written to tiff file */
+    TIFF *fp_tiff=NULL;      /* tiff file pointer */
+    GTIF *fp_gtif=NULL;      /* geotiff key parser */
+
+    /* Create the tiff file */
+    if ((fp_tiff = XTIFFOpen (tiffile, "w")) == NULL)
+    {
+        sprintf (errmsg, "Error creating base TIFF file %s", tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    } 
+  
+    /* Set metadata for tiff file */
+    if (TIFFSetField (fp_tiff, TIFFTAG_IMAGELENGTH, nlines) == 0)
+    {
+        sprintf (errmsg, "Error setting number of lines to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+  
+    if (TIFFSetField (fp_tiff, TIFFTAG_IMAGEWIDTH, nsamps) == 0)
+    {
+        sprintf (errmsg, "Error setting number of samples to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+  
+    if (TIFFSetField (fp_tiff, TIFFTAG_BITSPERSAMPLE, bitspersample) == 0)
+    {
+        sprintf (errmsg, "Error setting bitspersample to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+  
+    if (TIFFSetField (fp_tiff, TIFFTAG_SAMPLESPERPIXEL, nbands) == 0)
+    {
+        sprintf (errmsg, "Error setting samplesperpixel to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+  
+    if (TIFFSetField (fp_tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT) == 0)
+    {
+        sprintf (errmsg, "Error setting sampleformat to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+  
+    /* Set the compression and the strip or tile layout */
+    if (set_tiff_layout (fp_tiff, tiffile, out_opts) != SUCCESS)
+        return (NULL);
+  
+    if (TIFFSetField (fp_tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK)
+        == 0)
+    {
+        sprintf (errmsg, "Error setting photometric to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+  
+    if (TIFFSetField (fp_tiff, TIFFTAG_PLANARCONFIG, (nbands > 1) ?
+        out_opts->planar_config : PLANARCONFIG_CONTIG) == 0)
+    {
+        sprintf (errmsg, "Error setting planarconfig to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+  
+    count = 6;
+    if (TIFFSetField (fp_tiff, TIFFTAG_GEOTIEPOINTS, count, tie_point) == 0)
+    {
+        sprintf (errmsg, "Error setting tiepoints to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+  
+    count = 3;
+    if (TIFFSetField (fp_tiff, TIFFTAG_GEOPIXELSCALE, count, pixel_size) == 0)
+    {
+        sprintf (errmsg, "Error setting pixel size to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+
+    /* Open the geotiff key parser */
+    fp_gtif = GTIFNew (fp_tiff);
+
+    /* Set the GTRasterTypeGeoKey, if it was set in the original product */
+    if (coord_sys != -99)
+    {
+        if (!GTIFKeySet (fp_gtif, GTRasterTypeGeoKey, TYPE_SHORT, 1, coord_sys))
+        {
+            sprintf (errmsg, "Error setting GTRasterTypeGeokey to GeoTIFF file "
+                "%s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (NULL);
+        }
+    }
+
+    /* Set the rest of the geokeys */
+    if (!GTIFKeySet (fp_gtif, GTModelTypeGeoKey, TYPE_SHORT, 1, model_type))
+    {
+        sprintf (errmsg, "Error setting GTModelTypeGeoKey to GeoTIFF file "
+            "%s", tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+
+    if (!GTIFKeySet (fp_gtif, GTCitationGeoKey, TYPE_ASCII, 0, citation))
+    {
+        sprintf (errmsg, "Error setting GTCitationGeoKey to GeoTIFF file "
+            "%s", tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+
+    if (!GTIFKeySet (fp_gtif, GeogLinearUnitsGeoKey, TYPE_SHORT, 1,
+        linear_units))
+    {
+        sprintf (errmsg, "Error setting GeogLinearUnitsGeoKey to GeoTIFF file "
+            "%s", tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+
+    if (!GTIFKeySet (fp_gtif, GeogAngularUnitsGeoKey, TYPE_SHORT, 1,
+        angular_units))
+    {
+        sprintf (errmsg, "Error setting GeogAngularUnitsGeoKey to GeoTIFF file "
+            "%s", tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+
+    if (!GTIFKeySet (fp_gtif, ProjectedCSTypeGeoKey, TYPE_SHORT, 1,
+        projected_type))
+    {
+        sprintf (errmsg, "Error setting ProjectedCSTypeGeoKey to GeoTIFF file "
+            "%s", tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+
+    /* Set additional geokeys for polar stereographic projection */
+    if (proj == PS_PROJ)
+    {
+        if (!GTIFKeySet (fp_gtif, ProjCoordTransGeoKey, TYPE_SHORT, 1,
+            CT_PolarStereographic))
+        {
+            sprintf (errmsg, "Error setting ProjCoordTransGeoKey for Polar "
+                "Stereographic in the GeoTIFF file %s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (NULL);
+        }
+
+        if (!GTIFKeySet (fp_gtif, GeographicTypeGeoKey, TYPE_SHORT, 1,
+            GCS_WGS_84))
+        {
+            sprintf (errmsg, "Error setting GeographicTypeGeoKey for Polar "
+                "Stereographic in the GeoTIFF file %s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (NULL);
+        }
+
+        if (!GTIFKeySet (fp_gtif, ProjLinearUnitsGeoKey, TYPE_SHORT, 1,
+            proj_linear_units))
+        {
+            sprintf (errmsg, "Error setting ProjLinearUnitsGeoKey to GeoTIFF "
+                "file %s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (NULL);
+        }
+
+        if (!GTIFKeySet (fp_gtif, ProjNatOriginLongGeoKey, TYPE_DOUBLE, 1,
+            proj_parms[4]))
+        {
+            sprintf (errmsg, "Error setting ProjNatOrigintLongGeoKey to "
+                "GeoTIFF file %s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (NULL);
+        }
+
+        if (!GTIFKeySet (fp_gtif, ProjNatOriginLatGeoKey, TYPE_DOUBLE, 1,
+            proj_parms[5]))
+        {
+            sprintf (errmsg, "Error setting ProjNatOrigintLatGeoKey to "
+                "GeoTIFF file %s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (NULL);
+        }
+
+        if (!GTIFKeySet (fp_gtif, ProjFalseEastingGeoKey, TYPE_DOUBLE, 1,
+            proj_parms[6]))
+        {
+            sprintf (errmsg, "Error setting ProjFalseEastingGeoKey to "
+                "GeoTIFF file %s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (NULL);
+        }
+
+        if (!GTIFKeySet (fp_gtif, ProjFalseNorthingGeoKey, TYPE_DOUBLE, 1,
+            proj_parms[7]))
+        {
+            sprintf (errmsg, "Error setting ProjFalseNorthingGeoKey to "
+                "GeoTIFF file %s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (NULL);
+        }
+    }
+
+    /* Write the geotiff keys */
+    if (!GTIFWriteKeys (fp_gtif))
+    {
+        sprintf (errmsg, "Error writing the geokeys to the GeoTIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+
+    /* Close the geotiff key parser */
+    GTIFFree (fp_gtif);
+
+    /* Pass back the input tiff file pointer */
+    return (fp_tiff);
+}
+
+
+/******************************************************************************
+MODULE:  read_qa_lines
+
+PURPOSE:  Pipeline reader.  Reads a block of lines of the input QA band,
+in place when the input file is mapped.  Compressed input is decoded on each
+unpack thread with the thread's own tiff file pointer.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+static short read_qa_lines
+(
+    void *arg,            /* I: unpack context */
+    int worker,           /* I: index of the reading thread */
+    int line,             /* I: first line to read */
+    int nlines,           /* I: number of lines to read */
+    uint16 *qa_buf,       /* O: buffer for nlines lines of QA values */
+    uint16 **qa_lines     /* O: the QA values for nlines lines */
+)
+{
+    Unpack_ctx_t *ctx = (Unpack_ctx_t *) arg;
+
+    return (read_in_lines (&ctx->reader, worker, line, nlines, qa_buf,
+        qa_lines));
+}
+
+
+/******************************************************************************
+MODULE:  unpack_qa_lines
+
+PURPOSE:  Pipeline unpacker.  Unpacks a block of QA lines into all the outputs
+in one pass over the QA values, counting them into the statistics of the
+unpack thread if statistics are gathered.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Multiband output is a single pipeline output.  Its buffer holds the fields
+   interleaved by pixel, or one plane of nlines lines per field.
+2. Without outputs only the statistics are gathered.
+******************************************************************************/
+static void unpack_qa_lines
+(
+    void *arg,            /* I: unpack context */
+    int worker,           /* I: index of the unpack thread */
+    uint16 *qa_buf,       /* I: QA values for nlines lines */
+    int nlines,           /* I: number of lines in qa_buf */
+    uint8 **out_buf       /* O: one buffer of nlines lines per output */
+)
+{
+    Unpack_ctx_t *ctx = (Unpack_ctx_t *) arg;
+    uint8 *plane_buf[UNPACK_MAX_FIELDS];  /* plane of each field (multiband
+                                             output) */
+    int i;                   /* looping variable */
+
+    if (ctx->stats != NULL)
+        add_qa_stats (ctx->stats, worker, qa_buf, (long) nlines *
+            ctx->nsamps);
+    if (ctx->nout == 0)
+        return;
+
+    if (ctx->planar_config == PLANARCONFIG_CONTIG)
+    {
+        run_unpacker_interleaved (&ctx->unpacker, qa_buf, (long) nlines *
+            ctx->nsamps, out_buf[0]);
+    }
+    else if (ctx->planar_config == PLANARCONFIG_SEPARATE)
+    {
+        for (i = 0; i < ctx->unpacker.nout; i++)
+            plane_buf[i] = &out_buf[0][(size_t) i * nlines * ctx->nsamps];
+        run_unpacker (&ctx->unpacker, qa_buf, nlines, ctx->nsamps,
+            plane_buf);
+    }
+    else
+        run_unpacker (&ctx->unpacker, qa_buf, nlines, ctx->nsamps, out_buf);
+}
+
+
+/******************************************************************************
+MODULE:  write_qa_lines
+
+PURPOSE:  Pipeline writer.  Writes a block of unpacked lines to one output,
+which writes them out a strip or row of tiles at a time.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+static short write_qa_lines
+(
+    void *arg,            /* I: unpack context */
+    int out,              /* I: output index */
+    int line,             /* I: first line to write */
+    int nlines,           /* I: number of lines to write */
+    uint8 *out_buf        /* I: unpacked values for nlines lines */
+)
+{
+    Unpack_ctx_t *ctx = (Unpack_ctx_t *) arg;
+
+    return (write_out_lines (&ctx->writer[out], line, nlines, out_buf));
+}
+
+
+
+
+/******************************************************************************
+MODULE:  get_qa_window
+
+PURPOSE:  Get the pixel window of the QA band given by the output options,
+converting a map window to the pixels it touches.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           The map window doesn't overlap the QA band
+SUCCESS         Processing was successful
+
+NOTES:
+1. A map window is clipped to the QA band.  A pixel window is checked by
+   set_in_window.
+******************************************************************************/
+static short get_qa_window
+(
+    char *qa_infile,      /* I: input QA filename */
+    Qa_band_t *band,      /* I: attributes of the QA band */
+    Out_opts_t *out_opts, /* I: window of the QA band */
+    uint32 *line,         /* O: first line of the window */
+    uint32 *samp,         /* O: first sample of the window */
+    uint32 *nlines,       /* O: number of lines in the window */
+    uint32 *nsamps        /* O: number of samples in the window */
+)
+{
+    char FUNC_NAME[] = "get_qa_window"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    double *win = out_opts->win;  /* window values */
+    double first[2];         /* first sample and line, fractional */
+    double last[2];          /* sample and line after the last, fractional */
+
+    if (out_opts->window == OUT_WIN_PIXEL)
+    {
+        *line = (uint32) win[0];
+        *samp = (uint32) win[1];
+        *nlines = (uint32) win[2];
+        *nsamps = (uint32) win[3];
+        return (SUCCESS);
+    }
+
+    /* Take every pixel the map window touches, allowing for rounding of
+       windows given on the pixel edges */
+    first[0] = band->tie_points[0] + (win[0] - band->tie_points[3]) /
+        band->pixel_size[0];
+    first[1] = band->tie_points[1] + (band->tie_points[4] - win[1]) /
+        band->pixel_size[1];
+    last[0] = band->tie_points[0] + (win[2] - band->tie_points[3]) /
+        band->pixel_size[0];
+    last[1] = band->tie_points[1] + (band->tie_points[4] - win[3]) /
+        band->pixel_size[1];
+    first[0] = floor (first[0] + 1e-6);
+    first[1] = floor (first[1] + 1e-6);
+    last[0] = ceil (last[0] - 1e-6);
+    last[1] = ceil (last[1] - 1e-6);
+    if (first[0] < 0.0)
+        first[0] = 0.0;
+    if (first[1] < 0.0)
+        first[1] = 0.0;
+    if (last[0] > band->nsamps)
+        last[0] = band->nsamps;
+    if (last[1] > band->nlines)
+        last[1] = band->nlines;
+    if (last[0] <= first[0] || last[1] <= first[1])
+    {
+        sprintf (errmsg, "Map window %f,%f,%f,%f doesn't overlap %s",
+            win[0], win[1], win[2], win[3], qa_infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    *line = (uint32) first[1];
+    *samp = (uint32) first[0];
+    *nlines = (uint32) (last[1] - first[1]);
+    *nsamps = (uint32) (last[0] - first[0]);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  open_qa_band
+
+PURPOSE:  Read the attributes of the input QA band, check it is a 16-bit
+unsigned band, open it and set up its reader for the pipeline.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. With a window in the output options, the attributes are those of the
+   window, its upper left tie point moved to the first line and sample of
+   the window, and the reader only reads the window.
+******************************************************************************/
+static short open_qa_band
+(
+    char *qa_infile,      /* I: input QA filename */
+    int nthreads,         /* I: number of unpack threads */
+    bool lazy,            /* I: the extra unpack threads open the input file
+                                on their first read (see init_in_reader) */
+    Out_opts_t *out_opts, /* I: window of the QA band to read */
+    Qa_band_t *band,      /* O: attributes of the QA band */
+    In_reader_t *reader   /* O: reader of the QA band */
+)
+{
+    char FUNC_NAME[] = "open_qa_band"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char tmpstr[STR_SIZE];   /* temporary pointer string message */
+    uint32 tile_width;       /* width of each tile (if tiled) */
+    uint32 tile_length;      /* length of each tile (if tiled) */
+    bool tiled;              /* image is in Geotiff tiled format */
+    uint16 bitspersample;    /* bits per sample in input tiff image */
+    uint16 sampleformat;     /* data type of input tiff image */
+    uint32 win_line, win_samp;  /* first line and sample of the window */
+    uint32 win_nlines, win_nsamps;  /* lines and samples in the window */
+
+    /* Open the input tiff file first, so a member of a compressed tar
+       bundle is only decompressed once for all its readers */
+    if ((band->fp_tiff = open_qa_tiff (qa_infile)) == NULL)
+    {
+        sprintf (errmsg, "Error opening base TIFF file %s", qa_infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Read the file attributes from the input file */
+    if (read_attributes (qa_infile, &band->proj_type, &band->nlines,
+        &band->nsamps, &tile_width, &tile_length, &tiled, &bitspersample,
+        &sampleformat, band->tie_points, band->pixel_size, &band->coord_sys,
+        &band->model_type, &band->linear_units, &band->angular_units,
+        &band->projected_type, &band->proj_linear_units, band->proj_parms,
+        band->citation) != SUCCESS)
+    {
+        sprintf (errmsg, "Error reading attributes from geoTIFF file %s",
+            qa_infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        XTIFFClose (band->fp_tiff);
+        return (ERROR);
+    }
+
+    /* Check to make sure the product is a 16-bit unsigned integer */
+    if (bitspersample != 16)
+    {
+        sprintf (errmsg, "Input GeoTIFF QA band is expected to be a 16-bit "
+            "integer but instead it is a %d-bit product", bitspersample);
+        error_handler (true, FUNC_NAME, errmsg);
+        XTIFFClose (band->fp_tiff);
+        return (ERROR);
+    }
+
+    if (sampleformat != SAMPLEFORMAT_UINT)
+    {
+        if (sampleformat == SAMPLEFORMAT_INT)
+            sprintf (tmpstr, "signed integer");
+        else if (sampleformat == SAMPLEFORMAT_IEEEFP)
+            sprintf (tmpstr, "float");
+        else
+            sprintf (tmpstr, "unknown");
+        sprintf (errmsg, "Error: input GeoTIFF QA band is expected to be "
+            "an unsigned integer but instead it is a %s product", tmpstr);
+        error_handler (true, FUNC_NAME, errmsg);
+        XTIFFClose (band->fp_tiff);
+        return (ERROR);
+    }
+
+    /* Set up the reader of the QA band.  The pipeline reads the QA band one
+       block of lines at a time, in place for uncompressed stripped files. */
+    if (init_in_reader (reader, band->fp_tiff, qa_infile, nthreads,
+        lazy) != SUCCESS)
+    {
+        sprintf (errmsg, "Error setting up the reader for %s", qa_infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        XTIFFClose (band->fp_tiff);
+        return (ERROR);
+    }
+    if (out_opts->window == OUT_WIN_NONE)
+        return (SUCCESS);
+
+    /* Only read the window, which the outputs then cover */
+    if (get_qa_window (qa_infile, band, out_opts, &win_line, &win_samp,
+        &win_nlines, &win_nsamps) != SUCCESS || set_in_window (reader,
+        win_line, win_samp, win_nlines, win_nsamps) != SUCCESS)
+    {
+        free_in_reader (reader);
+        XTIFFClose (band->fp_tiff);
+        return (ERROR);
+    }
+    band->nlines = win_nlines;
+    band->nsamps = win_nsamps;
+    band->tie_points[3] += win_samp * band->pixel_size[0];
+    band->tie_points[4] -= win_line * band->pixel_size[1];
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  create_qa_output
+
+PURPOSE:  Create an output GeoTIFF file with the size and geokeys of the
+input QA band.
+
+RETURN VALUE:
+Type = TIFF *
+Value           Description
+-----           -----------
+NULL            Error creating the GeoTIFF file
+TIFF *          Successful creation of the new GeoTIFF file
+
+NOTES:
+******************************************************************************/
+static TIFF *create_qa_output
+(
+    Qa_band_t *band,      /* I: attributes of the input QA band */
+    char *tiffile,        /* I: output filename */
+    uint16 nbands,        /* I: number of bands */
+    uint16 bitspersample, /* I: bits per sample, 8 or 16 or packed 1 or 2 */
+    Out_opts_t *out_opts  /* I: compression and layout of the output */
+)
+{
+    char FUNC_NAME[] = "create_qa_output"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    TIFF *fp_tiff;           /* tiff file pointer for the output file */
+
+    fp_tiff = create_tiff (tiffile, band->proj_type, band->nlines,
+        band->nsamps, band->tie_points, band->pixel_size, band->coord_sys,
+        band->model_type, band->linear_units, band->angular_units,
+        band->projected_type, band->proj_linear_units, band->proj_parms,
+        band->citation, nbands, bitspersample, out_opts);
+    if (fp_tiff == NULL)
+    {
+        sprintf (errmsg, "Error creating geoTIFF file %s", tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+    }
+
+    return (fp_tiff);
+}
+
+
+/******************************************************************************
+MODULE:  get_layout_fields
+
+PURPOSE:  Gather the specified quality fields of the layout, with their
+confidence levels, for the lookup table builder.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+n               Number of fields gathered
+
+NOTES:
+1. Fields the product doesn't have are skipped even if specified.
+******************************************************************************/
+static int get_layout_fields
+(
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: which quality fields were specified */
+    Confidence_t *qa_conf,  /* I: confidence level of each quality field */
+    Unpack_field_t field[UNPACK_MAX_FIELDS],  /* O: specified fields */
+    int qa_type[UNPACK_MAX_FIELDS]  /* O: layout index of each field */
+)
+{
+    int i;                   /* looping variable */
+    int nfields = 0;         /* number of fields gathered */
+
+    for (i = 0; i < layout->nfields; i++)
+    {
+        if (!qa_specd[i] || layout->field[i].name == NULL)
+            continue;
+        field[nfields].shift = layout->field[i].shift;
+        field[nfields].mask = layout->field[i].mask;
+        field[nfields].conf = qa_conf[i];
+        qa_type[nfields] = i;
+        nfields++;
+    }
+
+    return (nfields);
+}
+
+
+/******************************************************************************
+MODULE:  run_qa_pipeline
+
+PURPOSE:  Set up the unpacker and read, unpack and write the QA band one
+block of lines at a time, gathering the statistics of the QA band if a
+statistics sidecar was requested.  Then write the statistics, close the files
+and free the pipeline.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The writers of the outputs are already set up in the context.  Without
+   outputs only the statistics are gathered.
+2. A combined output is given by the QA expression of the output options
+   when there is one, rather than by the quality fields.
+3. The overview levels of the outputs are built while their lines are
+   written and are written out once the whole QA band is unpacked.
+******************************************************************************/
+static short run_qa_pipeline
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Confidence_t *qa_conf,  /* I: confidence level of each quality field */
+    Qa_band_t *band,      /* I: attributes of the QA band */
+    Unpack_ctx_t *ctx,    /* I: pipeline context */
+    Unpack_field_t *field,  /* I: quality fields */
+    int nfields,          /* I: number of quality fields */
+    bool combine,         /* I: combine the fields into one output */
+    int out_line_size,    /* I: bytes in one line of each output buffer */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    char FUNC_NAME[] = "run_qa_pipeline"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char statsfile[STR_SIZE];  /* statistics sidecar filename */
+    short status = SUCCESS;  /* return status */
+    int i;                   /* looping variable */
+    Qa_stats_t stats;        /* statistics of the QA band */
+    uint8 *lut;              /* lookup table of the QA expression */
+
+    ctx->nsamps = band->nsamps;
+    ctx->stats = NULL;
+    if (ctx->nout > 0 && combine && out_opts->qa_expr != NULL)
+    {
+        /* The combined output is the compiled QA expression */
+        lut = build_expr_lut (out_opts->qa_expr, layout, qa_conf);
+        if (lut != NULL)
+            init_unpacker_lut (&ctx->unpacker, lut, out_opts->packed);
+        else
+        {
+            ctx->unpacker.nout = 0;
+            sprintf (errmsg, "Error compiling the QA expression for %s",
+                qa_infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+    else if (ctx->nout > 0 && init_unpacker (&ctx->unpacker, field, nfields,
+        combine, out_opts->packed) != SUCCESS)
+    {
+        sprintf (errmsg, "Error setting up the unpacker for %s", qa_infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+    if (status == SUCCESS && out_opts->stats_format != OUT_STATS_NONE)
+    {
+        if (init_qa_stats (&stats, nthreads) == SUCCESS)
+            ctx->stats = &stats;
+        else
+            status = ERROR;
+    }
+
+    /* Read, unpack and write the QA band one block of lines at a time */
+    if (status == SUCCESS && run_unpack_pipeline (nthreads, band->nlines,
+        band->nsamps, ctx->reader.block_lines, ctx->reader.lead_lines,
+        ctx->nout, out_line_size, ctx->reader.parallel, read_qa_lines,
+        unpack_qa_lines, write_qa_lines, ctx) != SUCCESS)
+    {
+        sprintf (errmsg, "Error unpacking the QA band %s", qa_infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+
+    /* Write the overview levels of each output */
+    for (i = 0; status == SUCCESS && i < ctx->nout; i++)
+        status = write_out_overviews (&ctx->writer[i]);
+
+    /* Write the statistics sidecar */
+    if (status == SUCCESS && ctx->stats != NULL)
+    {
+        get_stats_filename (qa_outfile, "stats", out_opts->stats_format,
+            statsfile);
+        status = write_qa_stats (ctx->stats, layout, qa_conf, qa_infile,
+            statsfile, out_opts->stats_format);
+    }
+
+    /* Close the input and output tiff files and free the reader, the
+       unpacker, the writers and the statistics */
+    XTIFFClose (band->fp_tiff);
+    for (i = 0; i < ctx->nout; i++)
+    {
+        XTIFFClose (ctx->writer[i].fp_tiff);
+        free_out_writer (&ctx->writer[i]);
+    }
+    if (ctx->nout > 0)
+        free_unpacker (&ctx->unpacker);
+    if (ctx->stats != NULL)
+        free_qa_stats (ctx->stats);
+    free_in_reader (&ctx->reader);
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  unpack_qa_stats
+
+PURPOSE:  Gather the statistics of the QA band and write them to the
+statistics sidecar, without unpacking the quality bits to any output.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The sidecar is named after qa_outfile.  See get_stats_filename.
+******************************************************************************/
+short unpack_qa_stats
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    Qa_band_t band;          /* attributes of the QA band */
+    Unpack_ctx_t ctx;        /* pipeline context */
+
+    if (open_qa_band (qa_infile, nthreads, false, out_opts, &band,
+        &ctx.reader) != SUCCESS)
+        return (ERROR);
+
+    ctx.planar_config = 0;
+    ctx.nout = 0;
+    return (run_qa_pipeline (qa_infile, qa_outfile, layout, qa_conf, &band,
+        &ctx, NULL, 0, false, 0, nthreads, out_opts));
+}
+
+
+/******************************************************************************
+MODULE:  estimate_qa_cover
+
+PURPOSE:  Estimate the percent of pixels flagged in each specified quality
+field from an evenly spread sample of the blocks of lines of the QA band.
+Sampling stops once the 95% confidence bounds of every field are within the
+margin, and the estimates are written to the estimate sidecar.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The sidecar is named after qa_outfile with an _estimate suffix.
+2. The blocks are those the reader decodes at once, whole strips or rows of
+   tiles, so the blocks not sampled are never decoded.  They are read on the
+   calling thread.
+******************************************************************************/
+short estimate_qa_cover
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which QA bands were
+                                specified for processing */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    char FUNC_NAME[] = "estimate_qa_cover"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char estfile[STR_SIZE];  /* estimate sidecar filename */
+    short status = SUCCESS;  /* return status */
+    int block;               /* block being sampled */
+    int i;                   /* looping variable */
+    uint32 nblocks;          /* number of blocks in the QA band */
+    uint32 line;             /* first line of the block */
+    uint32 nlines;           /* number of lines in the block */
+    uint16 *qa_buf = NULL;   /* buffer for one block of QA values */
+    uint16 *qa_lines;        /* QA values of the block */
+    Qa_band_t band;          /* attributes of the QA band */
+    In_reader_t reader;      /* reader of the QA band */
+    Qa_estimate_t est;       /* estimate of the cover */
+
+    if (open_qa_band (qa_infile, 1, false, out_opts, &band, &reader)
+        != SUCCESS)
+        return (ERROR);
+
+    nblocks = (band.nlines + reader.lead_lines + reader.block_lines - 1) /
+        reader.block_lines;
+    if (init_qa_estimate (&est, layout, qa_specd, qa_conf, nblocks)
+        != SUCCESS)
+        status = ERROR;
+    else
+    {
+        qa_buf = (uint16 *) malloc ((size_t) reader.block_lines *
+            band.nsamps * sizeof (uint16));
+        if (qa_buf == NULL)
+        {
+            sprintf (errmsg, "Error allocating memory for the QA band of %s",
+                qa_infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+
+    /* Sample the blocks until the bounds are within the margin */
+    while (status == SUCCESS && (block = next_estimate_block (&est)) >= 0)
+    {
+        line = (uint32) block * reader.block_lines - reader.lead_lines;
+        nlines = reader.block_lines;
+        if (block == 0)
+        {
+            line = 0;
+            nlines -= reader.lead_lines;
+        }
+        if (line + nlines > band.nlines)
+            nlines = band.nlines - line;
+        if (read_in_lines (&reader, 0, line, nlines, qa_buf, &qa_lines)
+            != SUCCESS)
+        {
+            sprintf (errmsg, "Error reading the QA band %s", qa_infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+            break;
+        }
+        if (add_qa_estimate (&est, qa_lines, (long) nlines * band.nsamps,
+            out_opts->est_margin))
+            break;
+    }
+
+    if (status == SUCCESS)
+    {
+        printf ("%s: sampled %u of %u blocks (%.1f%% of the pixels)\n",
+            qa_infile, est.nsampled, est.nblocks, 100.0 * est.npix /
+            ((double) band.nlines * band.nsamps));
+        for (i = 0; i < est.nfields; i++)
+            printf ("    %-16s %7.3f%% +/- %.3f%%\n",
+                layout->field[est.qa_type[i]].name, est.percent[i],
+                est.half_width[i]);
+
+        get_stats_filename (qa_outfile, "estimate", out_opts->stats_format,
+            estfile);
+        status = write_qa_estimate (&est, layout, qa_infile, estfile,
+            out_opts->stats_format, out_opts->est_margin);
+    }
+
+    free (qa_buf);
+    free_qa_estimate (&est);
+    free_in_reader (&reader);
+    XTIFFClose (band.fp_tiff);
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  extract_qa_points
+
+PURPOSE:  Extract the QA value and the specified quality fields at each point
+of the points file, decoding only the strips or tiles that hold points, and
+write them to the points sidecar.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The points are grouped by the strip or tile holding them, each strip or
+   tile being read through a window of the reader that covers just it.
+   Mapped strips are used in place.
+2. A point is in the pixel its map coordinates fall in, or at its line and
+   sample counted from 0.  Points outside the QA band are still written,
+   without values.
+3. The sidecar is named after qa_outfile with a _points suffix.  See
+   get_stats_filename.
+******************************************************************************/
+short extract_qa_points
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which quality fields are
+                                extracted */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    Out_opts_t *out_opts  /* I: points file and sidecar format */
+)
+{
+    char FUNC_NAME[] = "extract_qa_points"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char ptsfile[STR_SIZE];  /* points sidecar filename */
+    short status = SUCCESS;  /* return status */
+    int i, j;                /* looping variables */
+    int nfields;             /* number of extracted fields */
+    int nblocks_read = 0;    /* number of strips or tiles read */
+    int qa_type[UNPACK_MAX_FIELDS];  /* layout index of each field */
+    uint32 block_lines;      /* lines in each strip or tile */
+    uint32 block_samps;      /* samples in each strip or tile */
+    uint32 nblock_cols;      /* strips or tiles across the QA band */
+    uint32 line, samp;       /* first line and sample of the strip or tile */
+    uint32 nlines, nsamps;   /* lines and samples in the strip or tile */
+    double pix_line, pix_samp;  /* line and sample of a map point */
+    uint16 *qa_buf = NULL;   /* buffer for one strip or tile */
+    uint16 *qa_lines;        /* QA values of the strip or tile */
+    Qa_point_t *pt;          /* current point */
+    Qa_band_t band;          /* attributes of the QA band */
+    In_reader_t reader;      /* reader of the QA band */
+    Qa_points_t pts;         /* points */
+    Unpack_field_t field[UNPACK_MAX_FIELDS];  /* extracted fields */
+
+    if (open_qa_band (qa_infile, 1, false, out_opts, &band, &reader)
+        != SUCCESS)
+        return (ERROR);
+    if (read_qa_points (out_opts->points_file, &pts) != SUCCESS)
+        status = ERROR;
+
+    /* Blocks are the strips, or the tiles, of the QA band */
+    if (reader.method == IN_READ_TILE)
+    {
+        block_lines = reader.block_lines;
+        block_samps = reader.tile_width;
+    }
+    else
+    {
+        block_lines = reader.rows_per_strip;
+        block_samps = band.nsamps;
+    }
+    nblock_cols = (band.nsamps + block_samps - 1) / block_samps;
+
+    /* Locate each point and group the points by block */
+    for (i = 0; status == SUCCESS && i < pts.npts; i++)
+    {
+        pt = &pts.pt[i];
+        if (out_opts->points == OUT_PTS_MAP)
+        {
+            pix_samp = floor (band.tie_points[0] + (pt->x -
+                band.tie_points[3]) / band.pixel_size[0]);
+            pix_line = floor (band.tie_points[1] + (band.tie_points[4] -
+                pt->y) / band.pixel_size[1]);
+        }
+        else
+        {
+            pix_line = pt->x;
+            pix_samp = pt->y;
+        }
+        if (pix_line < 0.0 || pix_line >= band.nlines || pix_samp < 0.0 ||
+            pix_samp >= band.nsamps)
+        {
+            pt->line = -1;
+            pt->samp = -1;
+            continue;
+        }
+        pt->line = (long) pix_line;
+        pt->samp = (long) pix_samp;
+        pt->block = (pt->line / block_lines) * nblock_cols +
+            pt->samp / block_samps;
+    }
+    if (status == SUCCESS)
+    {
+        sort_qa_points (&pts);
+        if (pts.by_block == NULL)
+        {
+            sprintf (errmsg, "Error allocating memory for the points");
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+    if (status == SUCCESS && pts.ninside > 0)
+    {
+        qa_buf = (uint16 *) malloc ((size_t) block_lines * block_samps *
+            sizeof (uint16));
+        if (qa_buf == NULL)
+        {
+            sprintf (errmsg, "Error allocating memory for a block of %s",
+                qa_infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+
+    /* Read each block holding points once and take the QA values of its
+       points */
+    for (i = 0; status == SUCCESS && i < pts.ninside; i = j)
+    {
+        pt = pts.by_block[i];
+        line = (pt->block / nblock_cols) * block_lines;
+        samp = (pt->block % nblock_cols) * block_samps;
+        nlines = (line + block_lines > band.nlines) ? band.nlines - line :
+            block_lines;
+        nsamps = (samp + block_samps > band.nsamps) ? band.nsamps - samp :
+            block_samps;
+        if (set_in_window (&reader, line, samp, nlines, nsamps) != SUCCESS ||
+            read_in_lines (&reader, 0, 0, nlines, qa_buf, &qa_lines)
+            != SUCCESS)
+        {
+            sprintf (errmsg, "Error reading the QA band %s", qa_infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+            break;
+        }
+        nblocks_read++;
+
+        for (j = i; j < pts.ninside && pts.by_block[j]->block == pt->block;
+            j++)
+            pts.by_block[j]->qa = qa_lines[(size_t) (pts.by_block[j]->line -
+                line) * nsamps + pts.by_block[j]->samp - samp];
+    }
+
+    if (status == SUCCESS)
+    {
+        printf ("%s: %d of %d points inside, read from %d %s\n", qa_infile,
+            pts.ninside, pts.npts, nblocks_read,
+            (reader.method == IN_READ_TILE) ? "tiles" : "strips");
+
+        nfields = get_layout_fields (layout, qa_specd, qa_conf, field,
+            qa_type);
+        get_stats_filename (qa_outfile, "points", out_opts->stats_format,
+            ptsfile);
+        status = write_qa_points (&pts, layout, field, qa_type, nfields,
+            qa_infile, ptsfile, out_opts->stats_format);
+    }
+
+    free (qa_buf);
+    free_qa_points (&pts);
+    free_in_reader (&reader);
+    XTIFFClose (band.fp_tiff);
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  read_freq_lines
+
+PURPOSE:  Stack pipeline reader.  Reads a band of lines of each scene in turn,
+unpacks its fields and fill field with the unpack kernels and counts them
+into the counters of the unpack thread.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. Run on the unpack thread with the stack's parallel read, just before the
+   thread's count_freq_lines call for the same band, so the counters of the
+   thread hold one band at a time.
+2. Each scene is read in its own blocks, whole strips or rows of tiles,
+   through qa_buf.  The bands are a multiple of the blocks of all the scenes
+   and start on them unless the windows of the scenes differ.
+3. The thread closes its file of each scene before reading the next, so it
+   only holds one open at a time besides the first thread's files.
+******************************************************************************/
+static short read_freq_lines
+(
+    void *arg,            /* I: stack context */
+    int worker,           /* I: index of the unpack thread */
+    int line,             /* I: first line of the band */
+    int nlines,           /* I: number of lines in the band */
+    uint16 *qa_buf,       /* I: buffer for one band of QA values */
+    uint16 **qa_lines     /* O: qa_buf, unused by count_freq_lines */
+)
+{
+    Freq_ctx_t *ctx = (Freq_ctx_t *) arg;
+    Qa_freq_t *freq = &ctx->freq[worker];
+    In_reader_t *reader;     /* reader of the current scene */
+    uint16 *lines;           /* QA values of the current block */
+    uint8 *plane[UNPACK_MAX_FIELDS];  /* planes at the current block */
+    uint32 block_lines;      /* lines in each block of the current scene */
+    uint32 nread;            /* number of lines in the current block */
+    uint32 done;             /* lines of the band already counted */
+    int scene;               /* looping variable for the scenes */
+    int i;                   /* looping variable for the planes */
+
+    *qa_lines = qa_buf;
+    for (scene = 0; scene < ctx->nscenes; scene++)
+    {
+        reader = &ctx->reader[scene];
+        block_lines = reader->block_lines;
+        for (done = 0; done < (uint32) nlines; done += nread)
+        {
+            /* Stop each read at the end of a block of the scene */
+            nread = nlines - done;
+            if (reader->method != IN_READ_MAP && nread > block_lines -
+                (reader->win_line + line + done) % block_lines)
+                nread = block_lines - (reader->win_line + line + done) %
+                    block_lines;
+            if (read_in_lines (reader, worker, line + done, nread, qa_buf,
+                &lines) != SUCCESS)
+                return (ERROR);
+
+            for (i = 0; i < ctx->unpacker.nout; i++)
+                plane[i] = &freq->plane[i][(size_t) done * ctx->nsamps];
+            run_unpacker (&ctx->unpacker, lines, nread, ctx->nsamps, plane);
+            add_qa_freq (freq, (long) done * ctx->nsamps, (long) nread *
+                ctx->nsamps);
+        }
+        release_in_worker (reader, worker);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  count_freq_lines
+
+PURPOSE:  Stack pipeline unpacker.  Turns the counters of the band of lines
+just read by the unpack thread into the frequency and valid observation
+outputs.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void count_freq_lines
+(
+    void *arg,            /* I: stack context */
+    int worker,           /* I: index of the unpack thread */
+    uint16 *qa_buf,       /* I: unused, the band is in the counters */
+    int nlines,           /* I: number of lines in the band */
+    uint8 **out_buf       /* O: one buffer of nlines lines per output */
+)
+{
+    Freq_ctx_t *ctx = (Freq_ctx_t *) arg;
+
+    (void) qa_buf;
+    get_qa_freq (&ctx->freq[worker], (long) nlines * ctx->nsamps, out_buf);
+}
+
+
+/******************************************************************************
+MODULE:  write_freq_lines
+
+PURPOSE:  Stack pipeline writer.  Writes a band of lines to one output.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+static short write_freq_lines
+(
+    void *arg,            /* I: stack context */
+    int out,              /* I: output index */
+    int line,             /* I: first line to write */
+    int nlines,           /* I: number of lines to write */
+    uint8 *out_buf        /* I: output values for nlines lines */
+)
+{
+    Freq_ctx_t *ctx = (Freq_ctx_t *) arg;
+
+    return (write_out_lines (&ctx->writer[out], line, nlines, out_buf));
+}
+
+
+/******************************************************************************
+MODULE:  get_gcd
+
+PURPOSE:  Get the greatest common divisor of two line counts.
+
+RETURN VALUE:
+Type = uint32
+Value           Description
+-----           -----------
+n               Greatest common divisor
+
+NOTES:
+******************************************************************************/
+static uint32 get_gcd
+(
+    uint32 a,             /* I: first line count */
+    uint32 b              /* I: second line count */
+)
+{
+    uint32 rem;              /* remainder */
+
+    while (b != 0)
+    {
+        rem = a % b;
+        a = b;
+        b = rem;
+    }
+
+    return (a);
+}
+
+
+/******************************************************************************
+MODULE:  unpack_qa_freq
+
+PURPOSE:  Count, for each pixel of a stack of aligned QA bands, how many
+scenes have a valid observation and how many of those flag each specified
+quality field, and write the frequency of each field and the valid
+observation count.  The scenes are streamed one band of lines at a time, so
+no scene is unpacked to disk.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The outputs are named from the base filename: one 8-bit percent output
+   per field with a _freq suffix (FREQ_NO_OBS where there is no valid
+   observation), and the valid observation count with a _nobs suffix, 8-bit
+   for up to FREQ_MAX_COUNT8 scenes and 16-bit beyond.
+2. A field is flagged at or above its confidence level, or when nonzero
+   without one.  The fill field is never counted, its pixels not being valid
+   observations.
+3. All the scenes must have the size, pixel size and upper left corner of
+   the first.  The outputs take its geokeys.
+4. The bands of lines are unpacked in parallel on the unpack threads, each
+   reading its own bands from every scene.  A band is a whole number of the
+   strips or rows of tiles of each scene.
+5. Each scene stays open for its attributes and the first unpack thread,
+   but the other threads open a scene only while reading it, so a stack
+   holds the scenes plus one file per extra thread open rather than a file
+   per scene and thread.
+******************************************************************************/
+short unpack_qa_freq
+(
+    char **qa_infile,     /* I: input QA filename of each scene */
+    int nscenes,          /* I: number of scenes */
+    char *qa_outfile,     /* I: output QA base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA bands */
+    bool *qa_specd,       /* I: array to specify which quality fields are
+                                counted */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    char FUNC_NAME[] = "unpack_qa_freq"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char outfile[UNPACK_MAX_FIELDS][STR_SIZE];  /* output filenames */
+    short status = SUCCESS;  /* return status */
+    int i;                   /* looping variable */
+    int nopened = 0;         /* number of scenes opened */
+    int nfields;             /* number of counted fields */
+    int nkept = 0;           /* number of fields other than the fill field */
+    int nfreq = 0;           /* number of counter sets set up */
+    int qa_type[UNPACK_MAX_FIELDS];  /* layout index of each field */
+    uint32 align;            /* lines the bands must be a multiple of */
+    uint32 band_lines = 1;   /* lines in each band */
+    uint16 nobs_bits;        /* bits per sample of the observation count */
+    TIFF *out_fp_tiff;       /* tiff file pointer for each output file */
+    Qa_band_t *band = NULL;  /* attributes of the QA band of each scene */
+    Freq_ctx_t ctx;          /* pipeline context */
+    Unpack_field_t field[UNPACK_MAX_FIELDS];  /* counted fields, then the
+                                                 fill field */
+
+    if (nscenes < 1 || nscenes > FREQ_MAX_SCENES)
+    {
+        sprintf (errmsg, "A stack holds 1 to %d scenes but %d were given",
+            FREQ_MAX_SCENES, nscenes);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    if (nthreads < 1)
+        nthreads = 1;
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.nscenes = nscenes;
+    band = (Qa_band_t *) calloc (nscenes, sizeof (Qa_band_t));
+    ctx.reader = (In_reader_t *) calloc (nscenes, sizeof (In_reader_t));
+    ctx.freq = (Qa_freq_t *) calloc (nthreads, sizeof (Qa_freq_t));
+    if (band == NULL || ctx.reader == NULL || ctx.freq == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the stack of %d "
+            "scenes", nscenes);
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+
+    /* Open every scene and check it lines up with the first */
+    for (i = 0; status == SUCCESS && i < nscenes; i++)
+    {
+        if (open_qa_band (qa_infile[i], nthreads, true, out_opts, &band[i],
+            &ctx.reader[i]) != SUCCESS)
+        {
+            status = ERROR;
+            break;
+        }
+        nopened++;
+
+        if (band[i].nlines != band[0].nlines || band[i].nsamps !=
+            band[0].nsamps || band[i].pixel_size[0] != band[0].pixel_size[0]
+            || band[i].pixel_size[1] != band[0].pixel_size[1] ||
+            fabs (band[i].tie_points[3] - band[0].tie_points[3]) >
+            0.5 * band[0].pixel_size[0] ||
+            fabs (band[i].tie_points[4] - band[0].tie_points[4]) >
+            0.5 * band[0].pixel_size[1])
+        {
+            sprintf (errmsg, "QA band %s doesn't line up with %s",
+                qa_infile[i], qa_infile[0]);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+            break;
+        }
+
+        /* Grow the bands to a multiple of the blocks of the scene */
+        align = (ctx.reader[i].method == IN_READ_MAP) ? 1 :
+            ctx.reader[i].block_lines;
+        band_lines = band_lines / get_gcd (band_lines, align) * align;
+        if (band_lines > FREQ_MAX_BAND_LINES)
+        {
+            sprintf (errmsg, "The strips or tiles of %s don't line up with "
+                "those of the other scenes", qa_infile[i]);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+            break;
+        }
+    }
+    if (status == SUCCESS)
+    {
+        band_lines *= (PIPE_BLOCK_LINES + band_lines - 1) / band_lines;
+        if (band_lines > band[0].nlines)
+            band_lines = band[0].nlines;
+    }
+
+    /* Set up the unpacker of the fields, with the fill field unpacked last
+       to tell the valid observations */
+    nfields = get_layout_fields (layout, qa_specd, qa_conf, field, qa_type);
+    for (i = 0; i < nfields; i++)
+    {
+        if (qa_type[i] == layout->fill_field)
+            continue;
+        field[nkept] = field[i];
+        qa_type[nkept] = qa_type[i];
+        if (field[nkept].conf == UNDEFINED)
+            field[nkept].conf = 1;
+        nkept++;
+    }
+    nfields = nkept;
+    if (status == SUCCESS && nfields == 0)
+    {
+        sprintf (errmsg, "No quality fields of the stack are counted");
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+    if (status == SUCCESS && layout->fill_field >= 0)
+    {
+        field[nfields].shift = layout->field[layout->fill_field].shift;
+        field[nfields].mask = layout->field[layout->fill_field].mask;
+        field[nfields].conf = 1;
+        if (init_unpacker (&ctx.unpacker, field, nfields + 1, false, false)
+            != SUCCESS)
+            status = ERROR;
+    }
+    else if (status == SUCCESS && init_unpacker (&ctx.unpacker, field,
+        nfields, false, false) != SUCCESS)
+        status = ERROR;
+
+    /* Set up the counters of each unpack thread */
+    for (i = 0; status == SUCCESS && i < nthreads; i++)
+    {
+        if (init_qa_freq (&ctx.freq[i], nfields, layout->fill_field >= 0,
+            (long) band_lines * band[0].nsamps, nscenes) != SUCCESS)
+        {
+            status = ERROR;
+            break;
+        }
+        nfreq++;
+    }
+
+    /* Create an output for the frequency of each field and one for the
+       valid observation count */
+    nobs_bits = (nscenes > FREQ_MAX_COUNT8) ? 16 : 8;
+    for (i = 0; status == SUCCESS && i <= nfields; i++)
+    {
+        if (i < nfields)
+            sprintf (outfile[i], "%s_%s_freq.tif", qa_outfile,
+                layout->field[qa_type[i]].name);
+        else
+            sprintf (outfile[i], "%s_nobs.tif", qa_outfile);
+        out_fp_tiff = create_qa_output (&band[0], outfile[i], 1,
+            (i < nfields) ? 8 : nobs_bits, out_opts);
+        if (out_fp_tiff == NULL)
+        {
+            status = ERROR;
+            break;
+        }
+        if (init_out_writer (&ctx.writer[i], out_fp_tiff, outfile[i],
+            band[0].nlines, band[0].nsamps, out_opts->overviews) != SUCCESS)
+        {
+            sprintf (errmsg, "Error setting up the writer for %s",
+                outfile[i]);
+            error_handler (true, FUNC_NAME, errmsg);
+            XTIFFClose (out_fp_tiff);
+            status = ERROR;
+            break;
+        }
+        ctx.nout++;
+    }
+
+    /* Read, count and write the stack one band of lines at a time */
+    if (status == SUCCESS)
+    {
+        ctx.nsamps = band[0].nsamps;
+        if (run_unpack_pipeline (nthreads, band[0].nlines, band[0].nsamps,
+            band_lines, ctx.reader[0].win_line % band_lines, ctx.nout,
+            band[0].nsamps * nobs_bits / 8, true, read_freq_lines,
+            count_freq_lines, write_freq_lines, &ctx) != SUCCESS)
+        {
+            sprintf (errmsg, "Error counting the stack of %d scenes",
+                nscenes);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+    for (i = 0; status == SUCCESS && i < ctx.nout; i++)
+        status = write_out_overviews (&ctx.writer[i]);
+
+    /* Close the files and free the readers, the counters and the writers */
+    for (i = 0; i < ctx.nout; i++)
+    {
+        XTIFFClose (ctx.writer[i].fp_tiff);
+        free_out_writer (&ctx.writer[i]);
+    }
+    if (ctx.unpacker.nout > 0)
+        free_unpacker (&ctx.unpacker);
+    for (i = 0; i < nfreq; i++)
+        free_qa_freq (&ctx.freq[i]);
+    for (i = 0; i < nopened; i++)
+    {
+        free_in_reader (&ctx.reader[i]);
+        XTIFFClose (band[i].fp_tiff);
+    }
+    free (ctx.freq);
+    free (ctx.reader);
+    free (band);
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  unpack_bits
+
+PURPOSE:  Unpack the QA band for the specified quality bits, each into its
+own output file named from the base filename and the field name.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+HISTORY:
+Date          Programmer       Reason
+----------    ---------------  -------------------------------------
+6/19/2013     Gail Schmidt     Original Development
+8/31/2016     Ray Dittmeier    Collection version
+
+NOTES:
+******************************************************************************/
+short unpack_bits
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which QA bands were
+                                specified for processing */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    char FUNC_NAME[] = "unpack_bits"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char outfile[UNPACK_MAX_FIELDS][STR_SIZE];  /* output filenames */
+    int i;                   /* looping variable */
+    int nfields;             /* number of specified quality fields */
+    int qa_type[UNPACK_MAX_FIELDS];  /* layout index of each field */
+    TIFF *out_fp_tiff;       /* tiff file pointer for each output file */
+    Qa_band_t band;          /* attributes of the QA band */
+    Unpack_ctx_t ctx;        /* pipeline context */
+    Unpack_field_t field[UNPACK_MAX_FIELDS];  /* quality field of each
+                                                 output */
+
+    if (open_qa_band (qa_infile, nthreads, false, out_opts, &band,
+        &ctx.reader) != SUCCESS)
+        return (ERROR);
+
+    /* Create and open an output tiff file for each specified quality field,
+       1 or 2 bits per sample when the outputs are packed */
+    nfields = get_layout_fields (layout, qa_specd, qa_conf, field, qa_type);
+    ctx.planar_config = 0;
+    ctx.nout = 0;
+    for (i = 0; i < nfields; i++)
+    {
+        sprintf (outfile[i], "%s_%s.tif", qa_outfile,
+            layout->field[qa_type[i]].name);
+        out_fp_tiff = create_qa_output (&band, outfile[i], 1,
+            unpack_field_bits (&field[i], false, out_opts->packed), out_opts);
+        if (out_fp_tiff == NULL)
+            break;
+        if (init_out_writer (&ctx.writer[ctx.nout], out_fp_tiff, outfile[i],
+            band.nlines, band.nsamps, out_opts->overviews) != SUCCESS)
+        {
+            sprintf (errmsg, "Error setting up the writer for %s",
+                outfile[i]);
+            error_handler (true, FUNC_NAME, errmsg);
+            XTIFFClose (out_fp_tiff);
+            break;
+        }
+        ctx.nout++;
+    }
+    if (ctx.nout < nfields)
+    {
+        XTIFFClose (band.fp_tiff);
+        for (i = 0; i < ctx.nout; i++)
+        {
+            XTIFFClose (ctx.writer[i].fp_tiff);
+            free_out_writer (&ctx.writer[i]);
+        }
+        free_in_reader (&ctx.reader);
+        return (ERROR);
+    }
+
+    /* Unpack with one output per quality field */
+    return (run_qa_pipeline (qa_infile, qa_outfile, layout, qa_conf, &band,
+        &ctx, field, nfields, false, band.nsamps, nthreads, out_opts));
+}
+
+
+/******************************************************************************
+MODULE:  unpack_combine_bits
+
+PURPOSE:  Unpack the QA band for the specified quality bits and combine
+them into one output mask.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+HISTORY:
+Date          Programmer       Reason
+----------    ---------------  -------------------------------------
+6/21/2013     Gail Schmidt     Original Development
+8/31/2016     Ray Dittmeier    Collection version
+
+NOTES:
+******************************************************************************/
+short unpack_combine_bits
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which QA bands were
+                                specified for processing */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    char FUNC_NAME[] = "unpack_combine_bits"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    int nfields;             /* number of specified quality fields */
+    int qa_type[UNPACK_MAX_FIELDS];  /* layout index of each field */
+    TIFF *out_fp_tiff;       /* tiff file pointer for output file */
+    Qa_band_t band;          /* attributes of the QA band */
+    Unpack_ctx_t ctx;        /* pipeline context */
+    Unpack_field_t field[UNPACK_MAX_FIELDS];  /* specified quality fields */
+
+    if (open_qa_band (qa_infile, nthreads, false, out_opts, &band,
+        &ctx.reader) != SUCCESS)
+        return (ERROR);
+
+    /* Gather the specified quality fields, which are combined into the one
+       output, and create and open the output tiff file */
+    nfields = get_layout_fields (layout, qa_specd, qa_conf, field, qa_type);
+    out_fp_tiff = create_qa_output (&band, qa_outfile, 1,
+        unpack_field_bits (&field[0], true, out_opts->packed), out_opts);
+    if (out_fp_tiff == NULL)
+    {
+        XTIFFClose (band.fp_tiff);
+        free_in_reader (&ctx.reader);
+        return (ERROR);
+    }
+
+    ctx.planar_config = 0;
+    ctx.nout = 0;
+    if (init_out_writer (&ctx.writer[0], out_fp_tiff, qa_outfile,
+        band.nlines, band.nsamps, out_opts->overviews) != SUCCESS)
+    {
+        sprintf (errmsg, "Error setting up the writer for %s", qa_outfile);
+        error_handler (true, FUNC_NAME, errmsg);
+        XTIFFClose (out_fp_tiff);
+        XTIFFClose (band.fp_tiff);
+        free_in_reader (&ctx.reader);
+        return (ERROR);
+    }
+    ctx.nout = 1;
+
+    /* Unpack with the quality fields combined into the one output */
+    return (run_qa_pipeline (qa_infile, qa_outfile, layout, qa_conf, &band,
+        &ctx, field, nfields, true, band.nsamps, nthreads, out_opts));
+}
+
+
+/******************************************************************************
+MODULE:  unpack_multiband_bits
+
+PURPOSE:  Unpack the QA band for the specified quality bits and write them as
+the bands of one output file, interleaved by pixel or by band.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The bands are in quality field order and their names are listed in the
+   image description.
+2. The bands are written 8-bit.
+******************************************************************************/
+short unpack_multiband_bits
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which QA bands were
+                                specified for processing */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+)
+{
+    char FUNC_NAME[] = "unpack_multiband_bits"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char band_names[STR_SIZE];  /* names of the bands, in band order */
+    int i;                   /* looping variable */
+    int nfields;             /* number of specified quality fields */
+    int qa_type[UNPACK_MAX_FIELDS];  /* layout index of each field */
+    TIFF *out_fp_tiff;       /* tiff file pointer for output file */
+    Qa_band_t band;          /* attributes of the QA band */
+    Unpack_ctx_t ctx;        /* pipeline context */
+    Unpack_field_t field[UNPACK_MAX_FIELDS];  /* specified quality fields */
+
+    if (open_qa_band (qa_infile, nthreads, false, out_opts, &band,
+        &ctx.reader) != SUCCESS)
+        return (ERROR);
+
+    /* Gather the specified quality fields, one band each */
+    nfields = get_layout_fields (layout, qa_specd, qa_conf, field, qa_type);
+    band_names[0] = '\0';
+    for (i = 0; i < nfields; i++)
+    {
+        if (i > 0)
+            strcat (band_names, ",");
+        strcat (band_names, layout->field[qa_type[i]].name);
+    }
+
+    /* Create and open the output tiff file */
+    out_fp_tiff = create_qa_output (&band, qa_outfile, nfields, 8, out_opts);
+    if (out_fp_tiff == NULL)
+    {
+        XTIFFClose (band.fp_tiff);
+        free_in_reader (&ctx.reader);
+        return (ERROR);
+    }
+
+    ctx.planar_config = out_opts->planar_config;
+    ctx.nout = 0;
+    if (TIFFSetField (out_fp_tiff, TIFFTAG_IMAGEDESCRIPTION, band_names) == 0
+        || init_out_writer (&ctx.writer[0], out_fp_tiff, qa_outfile,
+        band.nlines, band.nsamps, out_opts->overviews) != SUCCESS)
+    {
+        sprintf (errmsg, "Error setting up the writer for %s", qa_outfile);
+        error_handler (true, FUNC_NAME, errmsg);
+        XTIFFClose (out_fp_tiff);
+        XTIFFClose (band.fp_tiff);
+        free_in_reader (&ctx.reader);
+        return (ERROR);
+    }
+    ctx.nout = 1;
+
+    /* Unpack with the one multiband output */
+    return (run_qa_pipeline (qa_infile, qa_outfile, layout, qa_conf, &band,
+        &ctx, field, nfields, false, band.nsamps * nfields, nthreads,
+        out_opts));
+}
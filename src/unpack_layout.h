@@ -0,0 +1,189 @@
+#ifndef _UNPACK_LAYOUT_H_
+#define _UNPACK_LAYOUT_H_
+
+#include "xtiffio.h"
+#include "geotiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+#include "unpack_lut.h"
+#include "unpack_out.h"
+
+#ifndef STR_SIZE
+#define STR_SIZE 1024
+#endif
+
+/* Set up the enumerated types for low, medium, or high confidence */
+typedef enum
+{
+    UNDEFINED = 0,
+    LOW,
+    MED,
+    HIGH,
+    NCONF_TYPES
+} Confidence_t;
+
+/* Set up local defines for the UTM and PS projections */
+#define UNDEFINED_PROJ -99
+#define UTM_PROJ 1
+#define PS_PROJ 2
+
+/* One quality field of a QA band bit layout */
+typedef struct
+{
+    const char *name;     /* output filename suffix and band name, NULL when
+                             the product doesn't have the field */
+    int shift;            /* bit offset of the field in the QA value */
+    uint16 mask;          /* mask of the field once shifted down to bit 0 */
+} Qa_field_desc_t;
+
+/* Bit layout of the QA band of a product.  The fields are in the order of
+   the product's quality field enum, which indexes the qa_specd and qa_conf
+   arrays passed to the unpack routines. */
+typedef struct
+{
+    const char *product;  /* product described */
+    int nfields;          /* number of quality fields */
+    int fill_field;       /* index of the fill field, -1 if none */
+    Qa_field_desc_t field[UNPACK_MAX_FIELDS];  /* quality fields */
+} Qa_layout_t;
+
+/* Prototypes */
+TIFF *create_tiff
+(
+    char *tiffile,         /* I: geotiff filename */
+    int proj,              /* I: projection type */
+    uint32 nlines,         /* I: number of lines in tiff image */
+    uint32 nsamps,         /* I: number of samples in tiff image */
+    double *tie_point,     /* I: corner tie points for projection [3] is ULx
+                                 and [4] is ULy (pass address of this array, as
+                                 memory is allocated) */
+    double *pixel_size,    /* I: pixel size array (x, y) (pass address of this
+                                 array, as memory is allocated) */
+    uint16 coord_sys,      /* I: coordinate system used (PixelIsArea or
+                                 PixelIsPoint) */
+    uint16 model_type,     /* I: geokey for the model type */
+    uint16 linear_units,   /* I: geokey for the linear units */
+    uint16 angular_units,  /* I: geokey for the angular units */
+    uint16 projected_type, /* I: geokey for the angular units */
+    uint16 proj_linear_units, /* O: geokey for proj linear units (PS proj) */
+    double proj_parms[15],  /* O: projection parameters (PS proj) */
+    char *citation,        /* I: citation string */
+    uint16 nbands,         /* I: number of bands */
+    uint16 bitspersample,  /* I: bits per sample, 8 or 16 or packed 1 or 2 */
+    Out_opts_t *out_opts   /* I: compression and layout of the output */
+);
+
+short read_attributes
+(
+    char *infile,      /* I: input geotiff filename */
+    int *proj,         /* O: projection type */
+    uint32 *nlines,    /* O: number of lines in tiff image */
+    uint32 *nsamps,    /* O: number of samples in tiff image */
+    uint32 *tile_width,     /* O: width of each tile (if tiled) */
+    uint32 *tile_length,    /* O: length of each tile (if tiled) */
+    bool *tiled,            /* O: Image is in GeoTiff tiled format */
+    uint16 *bitspersample,  /* O: bits per sample in tiff image */
+    uint16 *sampleformat,   /* O: data type of tiff image */
+    double tie_point[6],    /* O: corner tie points for projection [3] is ULx
+                                  and [4] is ULy */
+    double pixel_size[3],   /* O: pixel size array (x, y, -) */
+    uint16 *coord_sys,      /* O: coordinate system used (PixelIsArea or
+                                  PixelIsPoint) */
+    uint16 *model_type,     /* O: geokey for the model type */
+    uint16 *linear_units,   /* O: geokey for the linear units */
+    uint16 *angular_units,  /* O: geokey for the angular units */
+    uint16 *projected_type, /* O: geokey for the angular units */
+    uint16 *proj_linear_units, /* O: geokey for proj linear units (PS proj) */
+    double proj_parms[15],  /* O: projection parameters (PS proj) */
+    char *citation          /* O: citation string */
+);
+
+short unpack_bits
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which QA bands were
+                                specified for processing */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+);
+
+short unpack_combine_bits
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which QA bands were
+                                specified for processing */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+);
+
+short unpack_qa_stats
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+);
+
+short estimate_qa_cover
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which QA bands were
+                                specified for processing */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+);
+
+short extract_qa_points
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which quality fields are
+                                extracted */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    Out_opts_t *out_opts  /* I: points file and sidecar format */
+);
+
+short unpack_qa_freq
+(
+    char **qa_infile,     /* I: input QA filename of each scene */
+    int nscenes,          /* I: number of scenes */
+    char *qa_outfile,     /* I: output QA base filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA bands */
+    bool *qa_specd,       /* I: array to specify which quality fields are
+                                counted */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+);
+
+short unpack_multiband_bits
+(
+    char *qa_infile,      /* I: input QA filename */
+    char *qa_outfile,     /* I: output QA filename */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    bool *qa_specd,       /* I: array to specify which QA bands were
+                                specified for processing */
+    Confidence_t *qa_conf,  /* I: array to specify the confidence level for
+                                  each of the quality fields */
+    int nthreads,         /* I: number of unpack threads */
+    Out_opts_t *out_opts  /* I: compression and layout of the outputs */
+);
+
+#endif
@@ -0,0 +1,669 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#if defined (__SSE2__)
+#include <immintrin.h>
+#if defined (__GNUC__)
+/* The AVX2 kernel is built with a target attribute and chosen at run time */
+#define UNPACK_AVX2
+#endif
+#endif
+#include "unpack_lut.h"
+
+#ifndef STR_SIZE
+#define STR_SIZE 1024
+#endif
+
+/* Each byte value with its bit order reversed.  Packed samples are stored
+   most significant bit first. */
+static uint8 bit_reverse[256];
+static pthread_once_t bit_reverse_once = PTHREAD_ONCE_INIT;
+
+/******************************************************************************
+MODULE:  init_bit_reverse
+
+PURPOSE:  Fill the table of reversed byte values.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Run once through pthread_once, as unpackers may be set up on several
+   threads at the same time.
+******************************************************************************/
+static void init_bit_reverse (void)
+{
+    int i, bit;              /* looping variables */
+
+    for (i = 0; i < 256; i++)
+    {
+        bit_reverse[i] = 0;
+        for (bit = 0; bit < 8; bit++)
+            if (i & (1 << bit))
+                bit_reverse[i] |= 0x80 >> bit;
+    }
+}
+
+/******************************************************************************
+MODULE:  build_unpack_lut
+
+PURPOSE:  Build the lookup table holding the unpacked output value for every
+possible 16-bit QA value.
+
+RETURN VALUE:
+Type = uint8 *
+Value           Description
+-----           -----------
+NULL            An error occurred allocating the table
+uint8 *         Table of UNPACK_LUT_SIZE entries, to be freed by the caller
+
+NOTES:
+1. Without combine, only the first field is used.  Its raw value is output if
+   it has no confidence level, otherwise 1 if the value is at or above the
+   confidence level and 0 if not.
+2. With combine, the output is 1 if any of the fields is at or above its
+   confidence level.  Fields without a confidence level count as set for any
+   nonzero value.
+******************************************************************************/
+uint8 *build_unpack_lut
+(
+    Unpack_field_t *field,  /* I: quality fields for the output */
+    int nfields,          /* I: number of quality fields */
+    bool combine          /* I: combine the fields into one mask */
+)
+{
+    char FUNC_NAME[] = "build_unpack_lut"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    long qa_val;             /* current QA value */
+    int i;                   /* looping variable */
+    int conf;                /* confidence level of the current field */
+    uint16 unpack_val;       /* unpacked value of the current field */
+    uint8 *lut = NULL;       /* lookup table */
+
+    lut = (uint8 *) calloc (UNPACK_LUT_SIZE, sizeof (uint8));
+    if (lut == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the unpack lookup "
+            "table");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+
+    for (qa_val = 0; qa_val < UNPACK_LUT_SIZE; qa_val++)
+    {
+        if (!combine)
+        {
+            unpack_val = (qa_val >> field[0].shift) & field[0].mask;
+            if (field[0].conf == 0)
+                lut[qa_val] = (uint8) unpack_val;
+            else
+                lut[qa_val] = (unpack_val >= field[0].conf);
+            continue;
+        }
+
+        for (i = 0; i < nfields; i++)
+        {
+            unpack_val = (qa_val >> field[i].shift) & field[i].mask;
+            conf = (field[i].conf == 0) ? 1 : field[i].conf;
+            if (unpack_val >= conf)
+            {
+                lut[qa_val] = 1;
+                break;
+            }
+        }
+    }
+
+    return (lut);
+}
+
+
+/******************************************************************************
+MODULE:  unpack_field_bits
+
+PURPOSE:  Get the bits per sample of an output holding a quality field.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+8               Byte output, or the output is not packed
+1               Packed 0/1 output: single-bit raw fields, fields tested
+                against a confidence level and the combined mask
+2               Packed raw 2-bit fields
+
+NOTES:
+******************************************************************************/
+int unpack_field_bits
+(
+    Unpack_field_t *field,  /* I: quality field of the output */
+    bool combine,         /* I: the output is the combined mask */
+    bool packed           /* I: pack the output samples */
+)
+{
+    if (!packed)
+        return (8);
+    if (combine || field->conf != 0 || field->mask <= 0x01)
+        return (1);
+    if (field->mask <= 0x03)
+        return (2);
+    return (8);
+}
+
+
+/******************************************************************************
+MODULE:  init_unpacker
+
+PURPOSE:  Set up the unpacker for a run, either with one output per quality
+field or with all the fields combined into one output.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. Must be called before any threads run the unpacker.
+******************************************************************************/
+short init_unpacker
+(
+    Unpacker_t *unpacker, /* O: unpacker */
+    Unpack_field_t *field,  /* I: quality fields */
+    int nfields,          /* I: number of quality fields */
+    bool combine,         /* I: combine the fields into one output, otherwise
+                                one output per field */
+    bool packed           /* I: pack 1-bit and 2-bit outputs */
+)
+{
+    char FUNC_NAME[] = "init_unpacker"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    int i;                   /* looping variable */
+
+    unpacker->nout = 0;
+    if (nfields > UNPACK_MAX_FIELDS)
+    {
+        sprintf (errmsg, "Too many quality fields (%d) to unpack, the "
+            "maximum is %d", nfields, UNPACK_MAX_FIELDS);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    pthread_once (&bit_reverse_once, init_bit_reverse);
+
+    unpacker->combine = combine;
+    unpacker->nfields = nfields;
+    for (i = 0; i < nfields; i++)
+        unpacker->field[i] = field[i];
+
+    if (combine)
+    {
+        unpacker->bits[0] = unpack_field_bits (&field[0], true, packed);
+        unpacker->lut[0] = build_unpack_lut (field, nfields, true);
+        if (unpacker->lut[0] == NULL)
+            return (ERROR);
+        unpacker->nout = 1;
+        return (SUCCESS);
+    }
+
+    for (i = 0; i < nfields; i++)
+    {
+        unpacker->bits[i] = unpack_field_bits (&field[i], false, packed);
+        unpacker->lut[i] = build_unpack_lut (&field[i], 1, false);
+        if (unpacker->lut[i] == NULL)
+        {
+            free_unpacker (unpacker);
+            return (ERROR);
+        }
+        unpacker->nout++;
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  init_unpacker_lut
+
+PURPOSE:  Set up an unpacker with a single 0/1 output given by a prebuilt
+lookup table, such as a compiled QA expression.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The unpacker takes over the table and frees it in free_unpacker.
+2. The unpacker has no fields, so each pixel is unpacked with one table
+   lookup rather than by the vector kernels.
+******************************************************************************/
+void init_unpacker_lut
+(
+    Unpacker_t *unpacker, /* O: unpacker */
+    uint8 *lut,           /* I: lookup table of the output */
+    bool packed           /* I: pack the output as 1-bit samples */
+)
+{
+    pthread_once (&bit_reverse_once, init_bit_reverse);
+
+    unpacker->combine = true;
+    unpacker->nfields = 0;
+    unpacker->bits[0] = packed ? 1 : 8;
+    unpacker->lut[0] = lut;
+    unpacker->nout = 1;
+}
+
+
+/******************************************************************************
+MODULE:  free_unpacker
+
+PURPOSE:  Free the lookup tables of the unpacker.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void free_unpacker
+(
+    Unpacker_t *unpacker  /* I/O: unpacker */
+)
+{
+    int i;                   /* looping variable */
+
+    for (i = 0; i < unpacker->nout; i++)
+        free (unpacker->lut[i]);
+    unpacker->nout = 0;
+}
+
+
+#if defined (__SSE2__)
+/******************************************************************************
+MODULE:  store_vec
+
+PURPOSE:  Store 16 unpacked values, one per byte, to an output line as 8-bit,
+1-bit or 2-bit samples.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. samp is a multiple of 16, so the packed samples start on a byte.
+2. 1-bit samples are gathered with movemask, which puts the first pixel in the
+   least significant bit, so each byte is bit reversed.
+3. 2-bit samples are merged in pairs within each 16-bit lane, then the pairs
+   in each 32-bit lane, leaving one packed byte per 32-bit lane.
+******************************************************************************/
+static void store_vec
+(
+    uint8 *out_line,      /* O: output line */
+    long samp,            /* I: sample of the first value */
+    int bits,             /* I: bits per sample of the output */
+    __m128i res           /* I: 16 unpacked values */
+)
+{
+    int mask;                /* 1-bit samples of the 16 values */
+    int quad;                /* 2-bit samples of the 16 values */
+    __m128i pairs, quads;    /* 2-bit samples merged in pairs and quads */
+
+    if (bits == 8)
+    {
+        _mm_storeu_si128 ((__m128i *) &out_line[samp], res);
+    }
+    else if (bits == 1)
+    {
+        mask = _mm_movemask_epi8 (_mm_slli_epi16 (res, 7));
+        out_line[samp / 8] = bit_reverse[mask & 0xff];
+        out_line[samp / 8 + 1] = bit_reverse[(mask >> 8) & 0xff];
+    }
+    else
+    {
+        pairs = _mm_or_si128 (_mm_slli_epi16 (_mm_and_si128 (res,
+            _mm_set1_epi16 (0x00ff)), 2), _mm_srli_epi16 (res, 8));
+        quads = _mm_or_si128 (_mm_slli_epi32 (_mm_and_si128 (pairs,
+            _mm_set1_epi32 (0xffff)), 4), _mm_srli_epi32 (pairs, 16));
+        quads = _mm_packs_epi32 (quads, quads);
+        quads = _mm_packus_epi16 (quads, quads);
+        quad = _mm_cvtsi128_si32 (quads);
+        memcpy (&out_line[samp / 4], &quad, 4);
+    }
+}
+#endif
+
+
+#if defined (UNPACK_AVX2)
+/******************************************************************************
+MODULE:  run_unpacker_avx2
+
+PURPOSE:  AVX2 kernel of run_unpacker.  Unpacks all the outputs of one line in
+one pass over the QA values, 32 pixels at a time.
+
+RETURN VALUE:
+Type = long
+Value           Description
+-----           -----------
+n               Number of pixels unpacked, a multiple of 32
+
+NOTES:
+1. _mm256_packus_epi16 packs within each 128-bit lane, so the packed bytes are
+   put back in pixel order with a 64-bit permute.
+2. Only called when the CPU supports AVX2.
+******************************************************************************/
+__attribute__ ((target ("avx2")))
+static long run_unpacker_avx2
+(
+    Unpacker_t *unpacker, /* I: unpacker */
+    uint16 *qa_line,      /* I: QA values of the line */
+    long nsamps,          /* I: number of values in qa_line */
+    uint8 **out_line      /* O: unpacked line of each output */
+)
+{
+    __m128i shift[UNPACK_MAX_FIELDS];  /* shift count of each field */
+    __m256i mask[UNPACK_MAX_FIELDS];   /* mask of each field */
+    __m256i thresh[UNPACK_MAX_FIELDS]; /* confidence level - 1 of each field */
+    __m256i one = _mm256_set1_epi16 (1);
+    __m256i qa_lo, qa_hi;    /* QA values of the current 32 pixels */
+    __m256i val_lo, val_hi;  /* unpacked values of the current field */
+    __m256i acc_lo, acc_hi;  /* combined mask of the current 32 pixels */
+    __m256i res;             /* unpacked bytes of the current output */
+    long samp;               /* current sample */
+    int i;                   /* looping variable */
+    int out;                 /* current output */
+    int conf;                /* confidence level of the current field */
+
+    for (i = 0; i < unpacker->nfields; i++)
+    {
+        shift[i] = _mm_cvtsi32_si128 (unpacker->field[i].shift);
+        mask[i] = _mm256_set1_epi16 (unpacker->field[i].mask);
+        conf = unpacker->field[i].conf;
+        if (unpacker->combine && conf == 0)
+            conf = 1;
+        thresh[i] = _mm256_set1_epi16 (conf - 1);
+    }
+
+    for (samp = 0; samp + 32 <= nsamps; samp += 32)
+    {
+        qa_lo = _mm256_loadu_si256 ((__m256i *) &qa_line[samp]);
+        qa_hi = _mm256_loadu_si256 ((__m256i *) &qa_line[samp + 16]);
+        acc_lo = _mm256_setzero_si256 ();
+        acc_hi = _mm256_setzero_si256 ();
+        for (i = 0; i < unpacker->nfields; i++)
+        {
+            val_lo = _mm256_and_si256 (_mm256_srl_epi16 (qa_lo, shift[i]),
+                mask[i]);
+            val_hi = _mm256_and_si256 (_mm256_srl_epi16 (qa_hi, shift[i]),
+                mask[i]);
+            if (unpacker->combine || unpacker->field[i].conf != 0)
+            {
+                val_lo = _mm256_and_si256 (_mm256_cmpgt_epi16 (val_lo,
+                    thresh[i]), one);
+                val_hi = _mm256_and_si256 (_mm256_cmpgt_epi16 (val_hi,
+                    thresh[i]), one);
+            }
+            if (unpacker->combine)
+            {
+                acc_lo = _mm256_or_si256 (acc_lo, val_lo);
+                acc_hi = _mm256_or_si256 (acc_hi, val_hi);
+                if (i < unpacker->nfields - 1)
+                    continue;
+                val_lo = acc_lo;
+                val_hi = acc_hi;
+            }
+
+            out = unpacker->combine ? 0 : i;
+            res = _mm256_permute4x64_epi64 (_mm256_packus_epi16 (val_lo,
+                val_hi), 0xD8);
+            if (unpacker->bits[out] == 8)
+            {
+                _mm256_storeu_si256 ((__m256i *) &out_line[out][samp], res);
+                continue;
+            }
+            store_vec (out_line[out], samp, unpacker->bits[out],
+                _mm256_castsi256_si128 (res));
+            store_vec (out_line[out], samp + 16, unpacker->bits[out],
+                _mm256_extracti128_si256 (res, 1));
+        }
+    }
+
+    return (samp);
+}
+#endif
+
+
+#if defined (__SSE2__)
+/******************************************************************************
+MODULE:  run_unpacker_sse2
+
+PURPOSE:  SSE2 kernel of run_unpacker.  Unpacks all the outputs of one line in
+one pass over the QA values, 16 pixels at a time.
+
+RETURN VALUE:
+Type = long
+Value           Description
+-----           -----------
+n               Number of pixels unpacked, a multiple of 16
+
+NOTES:
+******************************************************************************/
+static long run_unpacker_sse2
+(
+    Unpacker_t *unpacker, /* I: unpacker */
+    uint16 *qa_line,      /* I: QA values of the line */
+    long nsamps,          /* I: number of values in qa_line */
+    uint8 **out_line      /* O: unpacked line of each output */
+)
+{
+    __m128i shift[UNPACK_MAX_FIELDS];  /* shift count of each field */
+    __m128i mask[UNPACK_MAX_FIELDS];   /* mask of each field */
+    __m128i thresh[UNPACK_MAX_FIELDS]; /* confidence level - 1 of each field */
+    __m128i one = _mm_set1_epi16 (1);
+    __m128i qa_lo, qa_hi;    /* QA values of the current 16 pixels */
+    __m128i val_lo, val_hi;  /* unpacked values of the current field */
+    __m128i acc_lo, acc_hi;  /* combined mask of the current 16 pixels */
+    long samp;               /* current sample */
+    int i;                   /* looping variable */
+    int out;                 /* current output */
+    int conf;                /* confidence level of the current field */
+
+    for (i = 0; i < unpacker->nfields; i++)
+    {
+        shift[i] = _mm_cvtsi32_si128 (unpacker->field[i].shift);
+        mask[i] = _mm_set1_epi16 (unpacker->field[i].mask);
+        conf = unpacker->field[i].conf;
+        if (unpacker->combine && conf == 0)
+            conf = 1;
+        thresh[i] = _mm_set1_epi16 (conf - 1);
+    }
+
+    for (samp = 0; samp + 16 <= nsamps; samp += 16)
+    {
+        qa_lo = _mm_loadu_si128 ((__m128i *) &qa_line[samp]);
+        qa_hi = _mm_loadu_si128 ((__m128i *) &qa_line[samp + 8]);
+        acc_lo = _mm_setzero_si128 ();
+        acc_hi = _mm_setzero_si128 ();
+        for (i = 0; i < unpacker->nfields; i++)
+        {
+            val_lo = _mm_and_si128 (_mm_srl_epi16 (qa_lo, shift[i]), mask[i]);
+            val_hi = _mm_and_si128 (_mm_srl_epi16 (qa_hi, shift[i]), mask[i]);
+            if (unpacker->combine || unpacker->field[i].conf != 0)
+            {
+                val_lo = _mm_and_si128 (_mm_cmpgt_epi16 (val_lo, thresh[i]),
+                    one);
+                val_hi = _mm_and_si128 (_mm_cmpgt_epi16 (val_hi, thresh[i]),
+                    one);
+            }
+            if (unpacker->combine)
+            {
+                acc_lo = _mm_or_si128 (acc_lo, val_lo);
+                acc_hi = _mm_or_si128 (acc_hi, val_hi);
+                if (i < unpacker->nfields - 1)
+                    continue;
+                val_lo = acc_lo;
+                val_hi = acc_hi;
+            }
+
+            out = unpacker->combine ? 0 : i;
+            store_vec (out_line[out], samp, unpacker->bits[out],
+                _mm_packus_epi16 (val_lo, val_hi));
+        }
+    }
+
+    return (samp);
+}
+#endif
+
+
+/******************************************************************************
+MODULE:  run_unpacker
+
+PURPOSE:  Unpack lines of QA values into every output of the unpacker in a
+single pass over the QA values.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The SSE2 kernel is used when the build targets it, or the AVX2 kernel when
+   the CPU also supports AVX2.  The remaining pixels of each line, or all of
+   them without a vector kernel, go through the lookup tables.
+2. Each output line holds unpacker_line_bytes bytes.  Packed lines are padded
+   to a whole byte, as in a TIFF scanline.
+******************************************************************************/
+void run_unpacker
+(
+    Unpacker_t *unpacker, /* I: unpacker */
+    uint16 *qa_buf,       /* I: QA values */
+    int nlines,           /* I: number of lines in qa_buf */
+    long nsamps,          /* I: number of samples in each line */
+    uint8 **out_buf       /* O: unpacked lines for each output */
+)
+{
+    int line;                /* current line */
+    long samp;               /* current sample */
+    uint16 *qa_line;         /* QA values of the current line */
+    uint16 qa_val;           /* QA value of the current pixel */
+    uint8 unpack_val;        /* unpacked value of the current output */
+    uint8 *out_line[UNPACK_MAX_FIELDS];  /* current line of each output */
+    long line_bytes;         /* bytes in a line of the current output */
+    int i;                   /* looping variable */
+#if defined (UNPACK_AVX2)
+    int avx2 = __builtin_cpu_supports ("avx2");  /* AVX2 kernel usable */
+#endif
+
+    for (line = 0; line < nlines; line++)
+    {
+        qa_line = &qa_buf[(size_t) line * nsamps];
+        for (i = 0; i < unpacker->nout; i++)
+            out_line[i] = &out_buf[i][(size_t) line *
+                unpacker_line_bytes (unpacker, i, nsamps)];
+
+        samp = 0;
+#if defined (UNPACK_AVX2)
+        if (unpacker->nfields > 0 && avx2)
+            samp = run_unpacker_avx2 (unpacker, qa_line, nsamps, out_line);
+        else
+#endif
+#if defined (__SSE2__)
+        if (unpacker->nfields > 0)
+            samp = run_unpacker_sse2 (unpacker, qa_line, nsamps, out_line);
+#endif
+
+        /* Clear the packed bytes of the remaining pixels, which are ORed in */
+        for (i = 0; i < unpacker->nout; i++)
+        {
+            if (unpacker->bits[i] == 8)
+                continue;
+            line_bytes = unpacker_line_bytes (unpacker, i, nsamps);
+            memset (&out_line[i][samp * unpacker->bits[i] / 8], 0,
+                line_bytes - samp * unpacker->bits[i] / 8);
+        }
+
+        for (; samp < nsamps; samp++)
+        {
+            qa_val = qa_line[samp];
+            for (i = 0; i < unpacker->nout; i++)
+            {
+                unpack_val = unpacker->lut[i][qa_val];
+                if (unpacker->bits[i] == 8)
+                    out_line[i][samp] = unpack_val;
+                else if (unpacker->bits[i] == 1)
+                    out_line[i][samp / 8] |= unpack_val << (7 - samp % 8);
+                else
+                    out_line[i][samp / 4] |= unpack_val <<
+                        (6 - 2 * (samp % 4));
+            }
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  unpacker_line_bytes
+
+PURPOSE:  Get the number of bytes in one line of an output of the unpacker.
+
+RETURN VALUE:
+Type = long
+Value           Description
+-----           -----------
+n               Bytes in one line, packed lines padded to a whole byte
+
+NOTES:
+******************************************************************************/
+long unpacker_line_bytes
+(
+    Unpacker_t *unpacker, /* I: unpacker */
+    int out,              /* I: output index */
+    long nsamps           /* I: number of samples in each line */
+)
+{
+    return ((nsamps * unpacker->bits[out] + 7) / 8);
+}
+
+
+/******************************************************************************
+MODULE:  run_unpacker_interleaved
+
+PURPOSE:  Unpack QA values into one buffer holding the outputs of the
+unpacker interleaved by pixel, as the bands of a PLANARCONFIG_CONTIG file.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The values are unpacked UNPACK_CHUNK pixels at a time with run_unpacker
+   into a small buffer per output, which stays in cache, then interleaved.
+2. Only for unpackers with 8-bit outputs.
+******************************************************************************/
+void run_unpacker_interleaved
+(
+    Unpacker_t *unpacker, /* I: unpacker */
+    uint16 *qa_buf,       /* I: QA values */
+    long npix,            /* I: number of values in qa_buf */
+    uint8 *out_buf        /* O: unpacked values, nout per pixel */
+)
+{
+    uint8 chunk[UNPACK_MAX_FIELDS][UNPACK_CHUNK];  /* unpacked chunk of each
+                                                      output */
+    uint8 *chunk_ptr[UNPACK_MAX_FIELDS];  /* pointer to each chunk */
+    uint8 *out_pix;          /* output of the current pixel */
+    long pix;                /* first pixel of the current chunk */
+    long npix_chunk;         /* number of pixels in the current chunk */
+    long samp;               /* pixel in the current chunk */
+    int i;                   /* looping variable */
+
+    for (i = 0; i < unpacker->nout; i++)
+        chunk_ptr[i] = chunk[i];
+
+    for (pix = 0; pix < npix; pix += UNPACK_CHUNK)
+    {
+        npix_chunk = npix - pix;
+        if (npix_chunk > UNPACK_CHUNK)
+            npix_chunk = UNPACK_CHUNK;
+        run_unpacker (unpacker, &qa_buf[pix], 1, npix_chunk, chunk_ptr);
+
+        out_pix = &out_buf[(size_t) pix * unpacker->nout];
+        for (samp = 0; samp < npix_chunk; samp++)
+            for (i = 0; i < unpacker->nout; i++)
+                *out_pix++ = chunk[i][samp];
+    }
+}
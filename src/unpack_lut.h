@@ -0,0 +1,102 @@
+#ifndef _UNPACK_LUT_H_
+#define _UNPACK_LUT_H_
+
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+
+/* Number of entries in a lookup table, one per 16-bit QA value */
+#define UNPACK_LUT_SIZE 65536
+
+/* Maximum number of quality fields handled by one unpacker */
+#define UNPACK_MAX_FIELDS 16
+
+/* Number of pixels unpacked at a time when interleaving the outputs */
+#define UNPACK_CHUNK 256
+
+/* Location and confidence level of one quality field in the QA word */
+typedef struct
+{
+    int shift;            /* bit offset of the field */
+    uint16 mask;          /* mask of the field once shifted down to bit 0 */
+    int conf;             /* confidence level, 0 outputs the raw field value */
+} Unpack_field_t;
+
+/* Unpacker for all the outputs of a run, built once before processing */
+typedef struct
+{
+    int nout;             /* number of outputs */
+    bool combine;         /* the fields are combined into the one output */
+    int nfields;          /* number of quality fields, 0 when the one output
+                             comes from its lookup table alone */
+    Unpack_field_t field[UNPACK_MAX_FIELDS];  /* field of each output, or the
+                                                 fields combined into the one
+                                                 output */
+    uint8 *lut[UNPACK_MAX_FIELDS];  /* lookup table of each output, used for
+                                       the pixels not handled by the vector
+                                       kernels */
+    int bits[UNPACK_MAX_FIELDS];    /* bits per sample of each output, 8 or
+                                       packed 1 or 2 */
+} Unpacker_t;
+
+uint8 *build_unpack_lut
+(
+    Unpack_field_t *field,  /* I: quality fields for the output */
+    int nfields,          /* I: number of quality fields */
+    bool combine          /* I: combine the fields into one mask */
+);
+
+int unpack_field_bits
+(
+    Unpack_field_t *field,  /* I: quality field of the output */
+    bool combine,         /* I: the output is the combined mask */
+    bool packed           /* I: pack the output samples */
+);
+
+short init_unpacker
+(
+    Unpacker_t *unpacker, /* O: unpacker */
+    Unpack_field_t *field,  /* I: quality fields */
+    int nfields,          /* I: number of quality fields */
+    bool combine,         /* I: combine the fields into one output, otherwise
+                                one output per field */
+    bool packed           /* I: pack 1-bit and 2-bit outputs */
+);
+
+void init_unpacker_lut
+(
+    Unpacker_t *unpacker, /* O: unpacker */
+    uint8 *lut,           /* I: lookup table of the output */
+    bool packed           /* I: pack the output as 1-bit samples */
+);
+
+void free_unpacker
+(
+    Unpacker_t *unpacker  /* I/O: unpacker */
+);
+
+void run_unpacker
+(
+    Unpacker_t *unpacker, /* I: unpacker */
+    uint16 *qa_buf,       /* I: QA values */
+    int nlines,           /* I: number of lines in qa_buf */
+    long nsamps,          /* I: number of samples in each line */
+    uint8 **out_buf       /* O: unpacked lines for each output */
+);
+
+long unpacker_line_bytes
+(
+    Unpacker_t *unpacker, /* I: unpacker */
+    int out,              /* I: output index */
+    long nsamps           /* I: number of samples in each line */
+);
+
+void run_unpacker_interleaved
+(
+    Unpacker_t *unpacker, /* I: unpacker */
+    uint16 *qa_buf,       /* I: QA values */
+    long npix,            /* I: number of values in qa_buf */
+    uint8 *out_buf        /* O: unpacked values, nout per pixel */
+);
+
+#endif
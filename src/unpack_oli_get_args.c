@@ -39,15 +39,20 @@ short get_args
     char **outfile,       /* O: address of output filename or base filename */
     bool qa_specd[NQUALITY_TYPES],  /* O: array to specify which of the QA
                                           bands was specified for processing */
-    Confidence_t qa_conf[NQUALITY_TYPES]
+    Confidence_t qa_conf[NQUALITY_TYPES],
                           /* O: array to specify the confidence level for
                                 each of the quality fields */
+    int *nthreads,        /* O: number of unpack threads */
+    Out_opts_t *out_opts  /* O: compression and layout of the outputs */
 )
 {
     int c;                               /* current argument index */
     int option_index;                    /* index for command-line option */
     int i;                               /* looping variable */
     static int combine_flag=false;       /* all quality bands flag */
+    static int tiled_flag=false;         /* tiled output flag */
+    static int packed_flag=false;        /* packed output flag */
+    static int stats_only_flag=false;    /* statistics only flag */
     static int all_flag=false;           /* all quality bands flag */
     static int fill_flag=false;          /* fill band flag */
     static int drop_frame_flag=false;    /* dropped frame band flag */
@@ -76,10 +81,31 @@ short get_args
         {"cloud", optional_argument, 0, 'c'},
         {"ifile", required_argument, 0, 'i'},
         {"ofile", required_argument, 0, 'o'},
+        {"threads", required_argument, 0, 't'},
+        {"compress", required_argument, 0, 'z'},
+        {"tiled", no_argument, &tiled_flag, true},
+        {"packed", no_argument, &packed_flag, true},
+        {"tile_size", required_argument, 0, 'x'},
+        {"strip_lines", required_argument, 0, 'l'},
+        {"multiband", required_argument, 0, 'm'},
+        {"overviews", optional_argument, 0, 'O'},
+        {"window", required_argument, 0, 'W'},
+        {"map_window", required_argument, 0, 'M'},
+        {"points", required_argument, 0, 'P'},
+        {"pixel_points", required_argument, 0, 'X'},
+        {"stats", required_argument, 0, 'S'},
+        {"stats_only", no_argument, &stats_only_flag, true},
+        {"estimate", optional_argument, 0, 'e'},
+        {"expr", required_argument, 0, 'q'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
+    /* Default to unpacking on the calling thread and to uncompressed,
+       stripped output */
+    *nthreads = 1;
+    init_out_opts (out_opts);
+
     /* Initialize the confidence levels for the QA fields.  Single bit QA
        fields will be undefined.  The two-bit fields will be medium. */
     qa_conf[FILL] = UNDEFINED;
@@ -124,6 +150,123 @@ short get_args
                 *outfile = strdup (optarg);
                 break;
      
+            case 't':  /* threads */
+                *nthreads = atoi (optarg);
+                if (*nthreads < 1)
+                {
+                    sprintf (errmsg, "Number of threads must be at least 1 "
+                        "but %s was specified", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'z':  /* compress */
+                if (parse_out_compress (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'x':  /* tile_size */
+                tiled_flag = true;
+                out_opts->tile_size = atoi (optarg);
+                if (atoi (optarg) < 16 || out_opts->tile_size % 16 != 0)
+                {
+                    sprintf (errmsg, "Tile size must be a positive multiple "
+                        "of 16 but %s was specified", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'l':  /* strip_lines */
+                out_opts->strip_lines = atoi (optarg);
+                if (atoi (optarg) < 1)
+                {
+                    sprintf (errmsg, "Lines per strip must be at least 1 "
+                        "but %s was specified", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'm':  /* multiband */
+                if (parse_out_multiband (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'O':  /* overviews */
+                if (parse_out_overviews (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'W':  /* window */
+                if (parse_out_window (optarg, OUT_WIN_PIXEL, out_opts)
+                    != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'M':  /* map_window */
+                if (parse_out_window (optarg, OUT_WIN_MAP, out_opts)
+                    != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'P':  /* points */
+                if (parse_out_points (optarg, OUT_PTS_MAP, out_opts)
+                    != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'X':  /* pixel_points */
+                if (parse_out_points (optarg, OUT_PTS_PIXEL, out_opts)
+                    != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'S':  /* stats */
+                if (parse_out_stats (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'e':  /* estimate */
+                if (parse_out_estimate (optarg, out_opts) != SUCCESS)
+                {
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+     
+            case 'q':  /* expr */
+                out_opts->qa_expr = strdup (optarg);
+                break;
+     
             case 'a':  /* all */
                 all_flag = true;
                 /* Validate the confidence argument.  Default of medium is
@@ -312,11 +455,61 @@ short get_args
         return (ERROR);
     }
 
-    /* Check if the bits are to be combined */
+    /* Check if the bits are to be combined, as they always are into the
+       result of a QA expression */
     *combine_bits = false;
-    if (combine_flag)
+    if (combine_flag || out_opts->qa_expr != NULL)
         *combine_bits = true;
 
+    /* Check if the output is to be tiled */
+    out_opts->tiled = false;
+    if (tiled_flag)
+        out_opts->tiled = true;
+
+    /* Check if the output samples are to be packed */
+    out_opts->packed = false;
+    if (packed_flag)
+        out_opts->packed = true;
+
+    /* Multiband output holds each quality field in its own 8-bit band */
+    if (out_opts->multiband && (*combine_bits || out_opts->packed))
+    {
+        sprintf (errmsg, "Multiband output can't be combined or packed");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    /* Check if only the statistics are to be written, by default as JSON */
+    out_opts->stats_only = false;
+    if (stats_only_flag)
+    {
+        out_opts->stats_only = true;
+        if (out_opts->stats_format == OUT_STATS_NONE)
+            out_opts->stats_format = OUT_STATS_JSON;
+    }
+
+    /* The cover estimate is written in the statistics format, by default as
+       JSON */
+    if (out_opts->estimate && out_opts->stats_format == OUT_STATS_NONE)
+        out_opts->stats_format = OUT_STATS_JSON;
+
+    /* Points are extracted from the whole QA band into a sidecar written in
+       the statistics format, by default as JSON */
+    if (out_opts->points != OUT_PTS_NONE && (out_opts->window != OUT_WIN_NONE
+        || out_opts->estimate || out_opts->stats_only || out_opts->multiband
+        || *combine_bits || out_opts->packed))
+    {
+        sprintf (errmsg, "Points can't be extracted from a window, or with "
+            "estimates, statistics or unpacked outputs options");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+    if (out_opts->points != OUT_PTS_NONE &&
+        out_opts->stats_format == OUT_STATS_NONE)
+        out_opts->stats_format = OUT_STATS_JSON;
+
     /* If none of the quality band flags were specified, then set the all_flag
        to true as the default */
     if (!all_flag && !fill_flag && !drop_frame_flag && !terrain_occl_flag &&
@@ -39,13 +39,15 @@ int main (int argc, char *argv[])
     char *qa_outfile=NULL;   /* output QA filename or basename */
     char tmp_char;           /* temporary character for each QA band */
     int retval;              /* return status */
+    int nthreads;            /* number of unpack threads */
+    Out_opts_t out_opts;     /* compression and layout of the outputs */
 
     printf ("Unpack of OLI QA band started ...\n");
 
     /* Read the command-line arguments to determine which file needs to be
        processed and which quality bands will be dumped */
     retval = get_args (argc, argv, &combine_bits, &qa_infile, &qa_outfile,
-        qa_specd, qa_conf);
+        qa_specd, qa_conf, &nthreads, &out_opts);
     if (retval != SUCCESS)
     {   /* get_args already printed the error message */
         exit (ERROR);
@@ -53,10 +55,24 @@ int main (int argc, char *argv[])
 
     /* Tell the user which bands will be unpacked */
     printf ("OLI QA input file: %s\n", qa_infile);
-    if (!combine_bits)
+    if (out_opts.points != OUT_PTS_NONE)
+    {
+        printf ("QA points file: %s\n", out_opts.points_file);
+        printf ("QA points output basename: %s\n", qa_outfile);
+    }
+    else if (out_opts.estimate)
+        printf ("QA cover estimate output basename: %s\n", qa_outfile);
+    else if (out_opts.stats_only)
+        printf ("QA statistics output basename: %s\n", qa_outfile);
+    else if (out_opts.multiband)
+        printf ("Unpacked multiband QA output filename: %s\n", qa_outfile);
+    else if (!combine_bits)
         printf ("Unpacked QA output file basename: %s\n", qa_outfile);
     else
         printf ("Unpacked and combined QA output filename: %s\n", qa_outfile);
+    if (out_opts.qa_expr != NULL)
+        printf ("QA expression of the combined output: %s\n",
+            out_opts.qa_expr);
     printf ("Process    Description\n"
             "-------    -----------\n");
     if (qa_specd[FILL])
@@ -115,10 +131,51 @@ int main (int argc, char *argv[])
 
     /* Read the input QA band, unpack the bits, combine if specified, and
        write out the desired band(s) */
-    if (!combine_bits)
+    if (out_opts.points != OUT_PTS_NONE)
+    {
+        /* Only extract the quality fields at the points */
+        retval = extract_qa_points (qa_infile, qa_outfile, &OLI_QA_LAYOUT,
+            qa_specd, qa_conf, &out_opts);
+        if (retval != SUCCESS)
+        {   /* extract_qa_points already printed the error message */
+            exit (ERROR);
+        }
+    }
+    else if (out_opts.estimate)
+    {
+        /* Only estimate the cover of the quality fields from a sample */
+        retval = estimate_qa_cover (qa_infile, qa_outfile, &OLI_QA_LAYOUT,
+            qa_specd, qa_conf, &out_opts);
+        if (retval != SUCCESS)
+        {   /* estimate_qa_cover already printed the error message */
+            exit (ERROR);
+        }
+    }
+    else if (out_opts.stats_only)
+    {
+        /* Only gather the statistics of the QA band */
+        retval = unpack_qa_stats (qa_infile, qa_outfile, &OLI_QA_LAYOUT,
+            qa_conf, nthreads, &out_opts);
+        if (retval != SUCCESS)
+        {   /* unpack_qa_stats already printed the error message */
+            exit (ERROR);
+        }
+    }
+    else if (out_opts.multiband)
+    {
+        /* Unpack the bits into the bands of one file */
+        retval = unpack_multiband_bits (qa_infile, qa_outfile,
+            &OLI_QA_LAYOUT, qa_specd, qa_conf, nthreads, &out_opts);
+        if (retval != SUCCESS)
+        {   /* unpack_multiband_bits already printed the error message */
+            exit (ERROR);
+        }
+    }
+    else if (!combine_bits)
     {
         /* Unpack the bits into individual bands */
-        retval = unpack_bits (qa_infile, qa_outfile, qa_specd, qa_conf);
+        retval = unpack_bits (qa_infile, qa_outfile, &OLI_QA_LAYOUT,
+            qa_specd, qa_conf, nthreads, &out_opts);
         if (retval != SUCCESS)
         {   /* unpack_bits already printed the error message */
             exit (ERROR);
@@ -127,18 +184,23 @@ int main (int argc, char *argv[])
     else
     {
         /* Unpack the bits and combine into one band */
-        retval = unpack_combine_bits (qa_infile, qa_outfile, qa_specd, qa_conf);
+        retval = unpack_combine_bits (qa_infile, qa_outfile,
+            &OLI_QA_LAYOUT, qa_specd, qa_conf, nthreads, &out_opts);
         if (retval != SUCCESS)
         {   /* unpack_bits already printed the error message */
             exit (ERROR);
         }
     }
 
-    /* Free the filename pointers */
+    /* Free the filename pointers and the QA expression */
     if (qa_infile != NULL)
         free (qa_infile);
     if (qa_outfile != NULL)
         free (qa_outfile);
+    if (out_opts.qa_expr != NULL)
+        free (out_opts.qa_expr);
+    if (out_opts.points_file != NULL)
+        free (out_opts.points_file);
 
     /* Indicate successful completion of processing */
     printf ("Unpack of OLI QA band complete!\n");
@@ -222,11 +284,20 @@ void usage ()
             "[--terrain_occl=conf_level][--water=conf_level] "
             "[--cloud_shadow=conf_level][--veg=conf_level] "
             "[--snow_ice=conf_level][--cirrus=conf_level] "
-            "[--cloud=conf_level] [--combine]\n");
+            "[--cloud=conf_level] [--combine] [--threads=nthreads] "
+            "[--compress=type] [--tiled] [--tile_size=n] [--strip_lines=n] "
+            "[--packed] [--multiband=interleave] [--overviews=reduction] "
+            "[--window=line,samp,nlines,nsamps] "
+            "[--map_window=ulx,uly,lrx,lry] "
+            "[--points=file] [--pixel_points=file] "
+            "[--stats=format] [--stats_only] [--estimate=margin] "
+            "[--expr=expression]\n");
 
     printf ("\nwhere the following parameters are required:\n");
     printf ("    -ifile: name of the input QA file (GeoTIFF product with "
-            "uint16 bands)\n");
+            "uint16 bands).  A QA file in a tar bundle is read without "
+            "extracting the bundle when named as bundle.tar:member, "
+            "bundle.tar.gz:member or bundle.tgz:member.\n");
     printf ("    -ofile: basename of the output unpacked QA file if not "
             "combining the QA bits, otherwise the full filename of the output "
             "file if combining the QA bits (GeoTIFF products with uint8 bands "
@@ -234,6 +305,69 @@ void usage ()
     printf ("\nwhere the following is optional:\n");
     printf ("    -combine: indicates the specified QA bits will be combined "
             "into one single output band (default is false)\n");
+    printf ("    -expr: write the boolean QA expression as the one combined "
+            "output band, 1 where it is true and 0 elsewhere, in place of "
+            "the specified QA bits.  Fields are compared with numbers or "
+            "low, med and high using >=, >, <=, <, == and !=, and joined "
+            "with NOT, AND, OR and parentheses.  A confidence field on its "
+            "own is true at or above its confidence level (med unless set "
+            "by its own option) and any other field when nonzero, e.g. \"cloud_conf>=med AND NOT snow OR "
+            "shadow>=high\".  A field may be named by the start of its "
+            "name or of one of its words.  Implies -combine.\n");
+    printf ("    -threads: number of threads used to unpack the QA band "
+            "(default is 1).  The input is read and each output is written "
+            "on its own thread alongside the unpack threads.  Compressed "
+            "input is decoded in parallel on the unpack threads.\n");
+    printf ("    -compress: compression of the output files, one of 'none', "
+            "'deflate', 'lzw' or 'zstd' (default is none).  Compressed "
+            "8-bit output uses the horizontal predictor.\n");
+    printf ("    -tiled: write tiled output files (default is stripped)\n");
+    printf ("    -tile_size: width and length of the output tiles, a "
+            "multiple of 16 (default is 256).  Implies -tiled.\n");
+    printf ("    -strip_lines: number of lines in each strip of stripped "
+            "output files (default is 64)\n");
+    printf ("    -packed: write 0/1 outputs as 1-bit samples and raw 2-bit "
+            "QA fields as 2-bit samples (default is 8-bit samples)\n");
+    printf ("    -multiband: write the QA bits as the bands of one output "
+            "file, -ofile being its full filename.  The bands are "
+            "interleaved by 'pixel' or by 'band'.  Can't be used with "
+            "-combine or -packed.\n");
+    printf ("    -overviews: also write reduced resolution overviews of "
+            "each output file, halving the size at each level until it is at "
+            "most 256 lines and samples, as SubIFDs of the file.  They are "
+            "built while the lines are written, reducing each block of pixels "
+            "to 'any' (1 where any of them is nonzero) or 'max' (their "
+            "largest value, the default).\n");
+    printf ("    -window: only unpack the window of nlines lines and nsamps "
+            "samples starting at line and samp (counted from 0) of the QA "
+            "band.  Only the strips or tiles of the QA band the window "
+            "touches are read, and the outputs cover the window, their tie "
+            "point moved to its upper left corner.\n");
+    printf ("    -map_window: as -window, for the window of pixels touched by "
+            "the upper left and lower right corners given in the map "
+            "coordinates of the QA band, clipped to the QA band\n");
+    printf ("    -points: only extract the QA value and the value of each "
+            "specified quality field at the points listed in the file, one "
+            "per line as map x and y and an optional label, to a 'json' or "
+            "'csv' sidecar named after -ofile with a _points suffix (default "
+            "format is json).  Only the strips or tiles of the QA band "
+            "holding points are read.\n");
+    printf ("    -pixel_points: as -points, for points given as line and "
+            "sample (counted from 0) of the QA band\n");
+    printf ("    -stats: also write the pixel counts and percentages of each "
+            "value of each quality field, gathered while unpacking, to a "
+            "'json' or 'csv' sidecar named after -ofile with a _stats "
+            "suffix\n");
+    printf ("    -stats_only: only write the statistics sidecar, without "
+            "unpacking the QA bits to any output file (default format is "
+            "json)\n");
+    printf ("    -estimate: only estimate the percent of pixels flagged in "
+            "each specified quality field, with 95%% confidence bounds, by "
+            "reading an evenly spread sample of the strips or rows of tiles "
+            "until the bounds are within +/- margin percent (default is 1).  "
+            "The estimates are printed and written in the -stats format "
+            "(default is json) to a sidecar named after -ofile with an "
+            "_estimate suffix.\n");
     printf ("\nwhere the following QA bit parameters are optional:\n");
     printf ("    -all: specifies all the quality bits should be output "
             "(default is true), using the specified confidence level for "
@@ -0,0 +1,1048 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unpack_out.h"
+
+#ifndef STR_SIZE
+#define STR_SIZE 1024
+#endif
+
+/******************************************************************************
+MODULE:  init_out_opts
+
+PURPOSE:  Set the output options to the defaults, uncompressed 8-bit output in
+strips of OUT_STRIP_LINES lines.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void init_out_opts
+(
+    Out_opts_t *out_opts  /* O: output options set to the defaults */
+)
+{
+    out_opts->compress = COMPRESSION_NONE;
+    out_opts->tiled = false;
+    out_opts->tile_size = OUT_TILE_SIZE;
+    out_opts->strip_lines = OUT_STRIP_LINES;
+    out_opts->packed = false;
+    out_opts->multiband = false;
+    out_opts->planar_config = PLANARCONFIG_CONTIG;
+    out_opts->stats_format = OUT_STATS_NONE;
+    out_opts->stats_only = false;
+    out_opts->qa_expr = NULL;
+    out_opts->estimate = false;
+    out_opts->est_margin = OUT_EST_MARGIN;
+    out_opts->overviews = OUT_OVR_NONE;
+    out_opts->window = OUT_WIN_NONE;
+    out_opts->points = OUT_PTS_NONE;
+    out_opts->points_file = NULL;
+}
+
+
+/******************************************************************************
+MODULE:  parse_out_compress
+
+PURPOSE:  Set the output compression from its name: none, deflate, lzw or
+zstd.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Unknown compression or not available in this libtiff
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+short parse_out_compress
+(
+    char *compress_str,   /* I: name of the compression */
+    Out_opts_t *out_opts  /* I/O: output options */
+)
+{
+    char FUNC_NAME[] = "parse_out_compress"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+
+    if (!strcmp (compress_str, "none"))
+        out_opts->compress = COMPRESSION_NONE;
+    else if (!strcmp (compress_str, "deflate"))
+        out_opts->compress = COMPRESSION_ADOBE_DEFLATE;
+    else if (!strcmp (compress_str, "lzw"))
+        out_opts->compress = COMPRESSION_LZW;
+#ifdef COMPRESSION_ZSTD
+    else if (!strcmp (compress_str, "zstd"))
+        out_opts->compress = COMPRESSION_ZSTD;
+#endif
+    else
+    {
+        sprintf (errmsg, "Unknown or unsupported compression %s",
+            compress_str);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (!TIFFIsCODECConfigured (out_opts->compress))
+    {
+        sprintf (errmsg, "Compression %s is not configured in this libtiff",
+            compress_str);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  parse_out_multiband
+
+PURPOSE:  Select multiband output with the band interleave named on the
+command line, 'pixel' (PLANARCONFIG_CONTIG) or 'band'
+(PLANARCONFIG_SEPARATE).
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+short parse_out_multiband
+(
+    char *interleave_str, /* I: name of the band interleave */
+    Out_opts_t *out_opts  /* I/O: output options */
+)
+{
+    char FUNC_NAME[] = "parse_out_multiband"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+
+    if (!strcmp (interleave_str, "pixel"))
+        out_opts->planar_config = PLANARCONFIG_CONTIG;
+    else if (!strcmp (interleave_str, "band"))
+        out_opts->planar_config = PLANARCONFIG_SEPARATE;
+    else
+    {
+        sprintf (errmsg, "Unknown band interleave %s, expected pixel or "
+            "band", interleave_str);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    out_opts->multiband = true;
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  parse_out_stats
+
+PURPOSE:  Select the QA statistics sidecar with the format named on the
+command line, 'json' or 'csv'.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+short parse_out_stats
+(
+    char *format_str,     /* I: name of the statistics format */
+    Out_opts_t *out_opts  /* I/O: output options */
+)
+{
+    char FUNC_NAME[] = "parse_out_stats"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+
+    if (!strcmp (format_str, "json"))
+        out_opts->stats_format = OUT_STATS_JSON;
+    else if (!strcmp (format_str, "csv"))
+        out_opts->stats_format = OUT_STATS_CSV;
+    else
+    {
+        sprintf (errmsg, "Unknown statistics format %s, expected json or "
+            "csv", format_str);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  parse_out_overviews
+
+PURPOSE:  Select the overview levels with the reduction named on the command
+line, 'any' or 'max', or the default max reduction.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Unknown reduction
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+short parse_out_overviews
+(
+    char *reduce_str,     /* I: name of the overview reduction, NULL for the
+                                default */
+    Out_opts_t *out_opts  /* I/O: output options */
+)
+{
+    char FUNC_NAME[] = "parse_out_overviews"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+
+    if (reduce_str == NULL || !strcmp (reduce_str, "max"))
+        out_opts->overviews = OUT_OVR_MAX;
+    else if (!strcmp (reduce_str, "any"))
+        out_opts->overviews = OUT_OVR_ANY;
+    else
+    {
+        sprintf (errmsg, "Unknown overview reduction %s, expected any or "
+            "max", reduce_str);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  parse_out_estimate
+
+PURPOSE:  Select the cover estimation, with the half-width in percent of the
+confidence bounds given on the command line or the default.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           The half-width isn't between 0 and 50 percent
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+short parse_out_estimate
+(
+    char *margin_str,     /* I: half-width of the bounds in percent, NULL for
+                                the default */
+    Out_opts_t *out_opts  /* I/O: output options */
+)
+{
+    char FUNC_NAME[] = "parse_out_estimate"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+
+    out_opts->estimate = true;
+    if (margin_str == NULL)
+        return (SUCCESS);
+
+    out_opts->est_margin = atof (margin_str);
+    if (out_opts->est_margin <= 0.0 || out_opts->est_margin > 50.0)
+    {
+        sprintf (errmsg, "Estimate margin must be more than 0 and at most "
+            "50 percent but %s was specified", margin_str);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  parse_out_window
+
+PURPOSE:  Set the window of the QA band to unpack from its four
+comma-separated values on the command line.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           The values don't give a window
+SUCCESS         Processing was successful
+
+NOTES:
+1. A pixel window is the first line, first sample, number of lines and
+   number of samples.  A map window is the upper left x and y and the lower
+   right x and y in the projection of the QA band.
+2. Only one window can be given.
+******************************************************************************/
+short parse_out_window
+(
+    char *window_str,     /* I: four comma-separated window values */
+    int window,           /* I: OUT_WIN_PIXEL or OUT_WIN_MAP */
+    Out_opts_t *out_opts  /* I/O: output options */
+)
+{
+    char FUNC_NAME[] = "parse_out_window"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    double *win = out_opts->win;  /* window values */
+    int i;                   /* looping variable */
+    int nchars = 0;          /* characters of the window values used */
+
+    if (out_opts->window != OUT_WIN_NONE)
+    {
+        sprintf (errmsg, "Only one window can be specified");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (sscanf (window_str, "%lf,%lf,%lf,%lf%n", &win[0], &win[1], &win[2],
+        &win[3], &nchars) != 4 || window_str[nchars] != '\0')
+    {
+        sprintf (errmsg, "Window must be four comma-separated values but %s "
+            "was specified", window_str);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (window == OUT_WIN_PIXEL)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            if (win[i] != floor (win[i]) || win[i] < 0.0 || win[i] >
+                4294967295.0 || (i >= 2 && win[i] < 1.0))
+            {
+                sprintf (errmsg, "Pixel window must be the first line and "
+                    "sample and a positive number of lines and samples but "
+                    "%s was specified", window_str);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+        }
+    }
+    else if (win[2] <= win[0] || win[3] >= win[1])
+    {
+        sprintf (errmsg, "Map window must be the upper left x and y and the "
+            "lower right x and y but %s was specified", window_str);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    out_opts->window = window;
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  parse_out_points
+
+PURPOSE:  Select the extraction of the QA values at the points listed in the
+points file, given by their line and sample or their map coordinates.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Points were already given or memory couldn't be allocated
+SUCCESS         Processing was successful
+
+NOTES:
+1. The points file name is copied and should be freed by the caller.
+******************************************************************************/
+short parse_out_points
+(
+    char *points_file,    /* I: file listing the points */
+    int points,           /* I: OUT_PTS_PIXEL or OUT_PTS_MAP */
+    Out_opts_t *out_opts  /* I/O: output options */
+)
+{
+    char FUNC_NAME[] = "parse_out_points"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+
+    if (out_opts->points != OUT_PTS_NONE)
+    {
+        sprintf (errmsg, "Only one points file can be specified");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    out_opts->points_file = strdup (points_file);
+    if (out_opts->points_file == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the points filename");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    out_opts->points = points;
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  set_tiff_layout
+
+PURPOSE:  Set the compression, predictor and strip or tile layout tags of an
+output tiff file.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The horizontal predictor is used with every compression.  The unpacked
+   values are small and mostly constant along a line, so the differences are
+   nearly all zero.  libtiff only supports it for 8-bit and wider samples, so
+   it is left off for packed outputs.
+2. BITSPERSAMPLE must already be set.
+******************************************************************************/
+short set_tiff_layout
+(
+    TIFF *fp_tiff,        /* I: tiff file pointer of the output file */
+    char *tiffile,        /* I: output filename */
+    Out_opts_t *out_opts  /* I: output options */
+)
+{
+    char FUNC_NAME[] = "set_tiff_layout"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    uint16 bits = 8;         /* bits per sample of the output file */
+
+    if (TIFFSetField (fp_tiff, TIFFTAG_COMPRESSION, out_opts->compress) == 0)
+    {
+        sprintf (errmsg, "Error setting compression to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    TIFFGetField (fp_tiff, TIFFTAG_BITSPERSAMPLE, &bits);
+    if (out_opts->compress != COMPRESSION_NONE && bits >= 8 &&
+        TIFFSetField (fp_tiff, TIFFTAG_PREDICTOR, PREDICTOR_HORIZONTAL) == 0)
+    {
+        sprintf (errmsg, "Error setting predictor to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (out_opts->tiled)
+    {
+        if (TIFFSetField (fp_tiff, TIFFTAG_TILEWIDTH, out_opts->tile_size) == 0
+            || TIFFSetField (fp_tiff, TIFFTAG_TILELENGTH, out_opts->tile_size)
+            == 0)
+        {
+            sprintf (errmsg, "Error setting tile size to base TIFF file %s",
+                tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+    else if (TIFFSetField (fp_tiff, TIFFTAG_ROWSPERSTRIP,
+        out_opts->strip_lines) == 0)
+    {
+        sprintf (errmsg, "Error setting rows per strip to base TIFF file %s",
+            tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  init_out_writer
+
+PURPOSE:  Set up the writer of an output tiff file created with
+set_tiff_layout.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. Multiband files are written one strip or row of tiles at a time across all
+   their planes, so a single writer handles the whole file.
+2. With overviews the SubIFD tag is set here, before any of the image is
+   written, with one entry per overview level.  libtiff fills in the offsets
+   as write_out_overviews writes the levels.
+******************************************************************************/
+short init_out_writer
+(
+    Out_writer_t *writer, /* O: writer */
+    TIFF *fp_tiff,        /* I: tiff file pointer of the output file */
+    char *tiffile,        /* I: output filename */
+    uint32 nlines,        /* I: number of lines in the output */
+    uint32 nsamps,        /* I: number of samples in the output */
+    int ovr_reduce        /* I: OUT_OVR_* reduction of the overviews */
+)
+{
+    char FUNC_NAME[] = "init_out_writer"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    uint32 tile_length;      /* tile length (if tiled) */
+    uint32 ovr_nlines;       /* lines of the current overview level */
+    uint32 ovr_nsamps;       /* samples of the current overview level */
+    uint16 planar_config;    /* PLANARCONFIG_* of the output file */
+    toff_t ovr_offset[OUT_MAX_OVERVIEWS];  /* SubIFD offsets, set by libtiff */
+
+    writer->fp_tiff = fp_tiff;
+    writer->tiffile = tiffile;
+    writer->nlines = nlines;
+    writer->nsamps = nsamps;
+    writer->tiled = TIFFIsTiled (fp_tiff);
+    TIFFGetField (fp_tiff, TIFFTAG_BITSPERSAMPLE, &writer->bits);
+    TIFFGetField (fp_tiff, TIFFTAG_SAMPLESPERPIXEL, &writer->nbands);
+    TIFFGetField (fp_tiff, TIFFTAG_PLANARCONFIG, &planar_config);
+    writer->nplanes = 1;
+    if (planar_config == PLANARCONFIG_SEPARATE)
+        writer->nplanes = writer->nbands;
+    writer->pixel_bits = writer->bits * (writer->nbands / writer->nplanes);
+    writer->line_bytes = ((size_t) nsamps * writer->pixel_bits + 7) / 8;
+    writer->buf_line = 0;
+    writer->buf_nlines = 0;
+    writer->buf = NULL;
+    writer->tile_buf = NULL;
+    writer->ovr_reduce = ovr_reduce;
+    writer->novr = 0;
+    writer->ovr_buf = NULL;
+
+    /* Count the overview levels, halving the size until it fits */
+    ovr_nlines = nlines;
+    ovr_nsamps = nsamps;
+    while (ovr_reduce != OUT_OVR_NONE && writer->novr < OUT_MAX_OVERVIEWS &&
+        (ovr_nlines > OUT_OVR_MIN_SIZE || ovr_nsamps > OUT_OVR_MIN_SIZE))
+    {
+        ovr_nlines = (ovr_nlines + 1) / 2;
+        ovr_nsamps = (ovr_nsamps + 1) / 2;
+        writer->novr++;
+    }
+    writer->ovr_nlines = (nlines + 1) / 2;
+    writer->ovr_nsamps = (nsamps + 1) / 2;
+    writer->ovr_line_bytes = ((size_t) writer->ovr_nsamps *
+        writer->pixel_bits + 7) / 8;
+
+    if (writer->novr > 0)
+    {
+        memset (ovr_offset, 0, sizeof (ovr_offset));
+        if (TIFFSetField (fp_tiff, TIFFTAG_SUBIFD, (uint16) writer->novr,
+            ovr_offset) == 0)
+        {
+            sprintf (errmsg, "Error setting the overview SubIFDs of %s",
+                tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        writer->ovr_buf = (uint8 *) calloc ((size_t) writer->nplanes *
+            writer->ovr_nlines * writer->ovr_line_bytes, sizeof (uint8));
+        if (writer->ovr_buf == NULL)
+        {
+            sprintf (errmsg, "Error allocating memory for the overviews of "
+                "%s", tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    if (writer->tiled)
+    {
+        TIFFGetField (fp_tiff, TIFFTAG_TILEWIDTH, &writer->tile_width);
+        TIFFGetField (fp_tiff, TIFFTAG_TILELENGTH, &tile_length);
+        writer->out_lines = tile_length;
+        writer->tile_buf = (uint8 *) calloc (TIFFTileSize (fp_tiff),
+            sizeof (uint8));
+    }
+    else
+    {
+        TIFFGetField (fp_tiff, TIFFTAG_ROWSPERSTRIP, &writer->out_lines);
+    }
+    if (writer->out_lines > nlines)
+        writer->out_lines = nlines;
+
+    writer->buf = (uint8 *) calloc ((size_t) writer->nplanes *
+        writer->out_lines * writer->line_bytes, sizeof (uint8));
+    if (writer->buf == NULL || (writer->tiled && writer->tile_buf == NULL))
+    {
+        sprintf (errmsg, "Error allocating memory for the output buffer of "
+            "%s", tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        free_out_writer (writer);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  write_out_block
+
+PURPOSE:  Write one full strip or row of tiles of one plane to the output
+file.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The edge tiles are padded with zeros.
+******************************************************************************/
+static short write_out_block
+(
+    Out_writer_t *writer, /* I: writer */
+    uint16 plane,         /* I: plane to write */
+    uint32 line,          /* I: first line of the strip or row of tiles */
+    uint32 nlines,        /* I: number of lines in the strip or row of tiles */
+    uint8 *buf            /* I: lines of the strip or row of tiles */
+)
+{
+    char FUNC_NAME[] = "write_out_block"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    uint32 i;                /* looping variable */
+    uint32 samp;             /* first sample of the current tile */
+    uint32 samples_to_copy;  /* number of samples of the tile in the image */
+    uint32 tile_row_bytes;   /* bytes in one line of a tile */
+    uint32 bytes_to_copy;    /* bytes of each tile line in the image */
+    tmsize_t tile_size;      /* bytes in one tile */
+
+    if (!writer->tiled)
+    {
+        if (TIFFWriteEncodedStrip (writer->fp_tiff, TIFFComputeStrip (
+            writer->fp_tiff, line, plane), buf, (tmsize_t) nlines *
+            writer->line_bytes) == -1)
+        {
+            sprintf (errmsg, "Error writing the strip at line %u to %s",
+                line, writer->tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        return (SUCCESS);
+    }
+
+    tile_size = TIFFTileSize (writer->fp_tiff);
+    tile_row_bytes = writer->tile_width * writer->pixel_bits / 8;
+    for (samp = 0; samp < writer->nsamps; samp += writer->tile_width)
+    {
+        samples_to_copy = writer->tile_width;
+        if (samp + writer->tile_width > writer->nsamps)
+            samples_to_copy = writer->nsamps - samp;
+        bytes_to_copy = (samples_to_copy * writer->pixel_bits + 7) / 8;
+        if (samples_to_copy < writer->tile_width || nlines <
+            writer->out_lines)
+            memset (writer->tile_buf, 0, tile_size);
+        for (i = 0; i < nlines; i++)
+            memcpy (&writer->tile_buf[i * tile_row_bytes],
+                &buf[(size_t) i * writer->line_bytes + samp *
+                writer->pixel_bits / 8], bytes_to_copy);
+
+        if (TIFFWriteEncodedTile (writer->fp_tiff, TIFFComputeTile (
+            writer->fp_tiff, samp, line, 0, plane), writer->tile_buf,
+            tile_size) == -1)
+        {
+            sprintf (errmsg, "Error writing the tile at line %u, sample %u "
+                "to %s", line, samp, writer->tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  reduce_out_line
+
+PURPOSE:  Reduce one line of a plane into the line of the next overview level
+it falls in, each pair of pixels into one pixel.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Both reductions only ever raise a value, so the two lines of each pair are
+   reduced into the overview line one after the other, starting from zeros.
+   An overview of an overview gives the same values as reducing the full
+   resolution lines directly.
+2. Packed samples are stored most significant bits first, as in a TIFF
+   scanline.
+******************************************************************************/
+static void reduce_out_line
+(
+    uint8 *line,          /* I: line of the plane */
+    uint32 nsamps,        /* I: number of samples in the line */
+    uint16 spp,           /* I: samples per pixel in the plane */
+    uint16 bits,          /* I: bits per sample, 8 or 16 or packed 1 or 2 */
+    int reduce,           /* I: OUT_OVR_* reduction */
+    uint8 *ovr_line       /* I/O: line of the overview level */
+)
+{
+    uint32 samp;             /* current sample of the line */
+    uint32 ovr_samp;         /* sample of the overview line it falls in */
+    uint16 band;             /* current sample of the pixel */
+    int shift;               /* shift of a packed sample in its byte */
+    uint8 mask;              /* mask of a packed sample */
+    uint8 val;               /* value of the current sample */
+    uint8 ovr_val;           /* value of the overview sample */
+    uint16 *line16;          /* line of 16-bit samples */
+    uint16 *ovr_line16;      /* overview line of 16-bit samples */
+
+    if (bits == 16)
+    {
+        line16 = (uint16 *) line;
+        ovr_line16 = (uint16 *) ovr_line;
+        for (samp = 0; samp < (uint32) nsamps * spp; samp++)
+        {
+            ovr_samp = (samp / spp / 2) * spp + samp % spp;
+            if (reduce == OUT_OVR_ANY && line16[samp] != 0)
+                ovr_line16[ovr_samp] = 1;
+            else if (line16[samp] > ovr_line16[ovr_samp])
+                ovr_line16[ovr_samp] = line16[samp];
+        }
+        return;
+    }
+
+    if (bits == 8)
+    {
+        for (samp = 0; samp < nsamps; samp++)
+        {
+            for (band = 0; band < spp; band++)
+            {
+                val = line[(size_t) samp * spp + band];
+                if (reduce == OUT_OVR_ANY && val != 0)
+                    val = 1;
+                ovr_samp = (samp / 2) * spp + band;
+                if (val > ovr_line[ovr_samp])
+                    ovr_line[ovr_samp] = val;
+            }
+        }
+        return;
+    }
+
+    /* Packed outputs have one sample per pixel */
+    mask = (1 << bits) - 1;
+    for (samp = 0; samp < nsamps; samp++)
+    {
+        shift = 8 - bits - bits * (samp % (8 / bits));
+        val = (line[samp * bits / 8] >> shift) & mask;
+        if (reduce == OUT_OVR_ANY && val != 0)
+            val = 1;
+        ovr_samp = samp / 2;
+        shift = 8 - bits - bits * (ovr_samp % (8 / bits));
+        ovr_val = (ovr_line[ovr_samp * bits / 8] >> shift) & mask;
+        if (val > ovr_val)
+            ovr_line[ovr_samp * bits / 8] = (ovr_line[ovr_samp * bits / 8] &
+                ~(mask << shift)) | (val << shift);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  write_out_lines
+
+PURPOSE:  Write lines to the output file.  The lines are collected until a
+full strip or row of tiles is available, then written encoded.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. Lines must be written in order.  The last strip or row of tiles is written
+   once the last line of the output has been passed in.
+2. Whole strips or rows of tiles passed in at once are written without being
+   copied.
+3. For PLANARCONFIG_SEPARATE files out_buf holds the nlines lines of each
+   plane one plane after the other.
+4. With overviews each line is reduced into the first overview level here,
+   so the output is never read back to build them.
+******************************************************************************/
+short write_out_lines
+(
+    Out_writer_t *writer, /* I/O: writer */
+    uint32 line,          /* I: first line to write */
+    uint32 nlines,        /* I: number of lines to write */
+    uint8 *out_buf        /* I: nlines lines of unpacked values for each
+                                plane */
+)
+{
+    uint32 block_lines;      /* lines of the current strip or row of tiles */
+    uint32 ncopy;            /* number of lines copied into the buffer */
+    uint32 done = 0;         /* number of lines of out_buf handled */
+    size_t in_plane_size;    /* bytes in one plane of out_buf */
+    size_t buf_plane_size;   /* bytes in one plane of the writer buffer */
+    size_t ovr_plane_size;   /* bytes in one plane of the first overview */
+    uint32 i;                /* looping variable for the lines */
+    uint16 plane;            /* looping variable for the planes */
+
+    in_plane_size = (size_t) nlines * writer->line_bytes;
+    buf_plane_size = (size_t) writer->out_lines * writer->line_bytes;
+
+    /* Reduce the lines into the first overview level */
+    if (writer->novr > 0)
+    {
+        ovr_plane_size = (size_t) writer->ovr_nlines * writer->ovr_line_bytes;
+        for (plane = 0; plane < writer->nplanes; plane++)
+            for (i = 0; i < nlines; i++)
+                reduce_out_line (&out_buf[plane * in_plane_size + (size_t) i *
+                    writer->line_bytes], writer->nsamps, writer->nbands /
+                    writer->nplanes, writer->bits, writer->ovr_reduce,
+                    &writer->ovr_buf[plane * ovr_plane_size + (size_t)
+                    ((line + i) / 2) * writer->ovr_line_bytes]);
+    }
+    while (done < nlines)
+    {
+        block_lines = writer->out_lines;
+        if (line - writer->buf_nlines + block_lines > writer->nlines)
+            block_lines = writer->nlines - (line - writer->buf_nlines);
+
+        if (writer->buf_nlines == 0 && nlines - done >= block_lines)
+        {
+            /* A whole strip or row of tiles is available in the caller's
+               buffer */
+            for (plane = 0; plane < writer->nplanes; plane++)
+            {
+                if (write_out_block (writer, plane, line, block_lines,
+                    &out_buf[plane * in_plane_size + (size_t) done *
+                    writer->line_bytes]) != SUCCESS)
+                    return (ERROR);
+            }
+            line += block_lines;
+            done += block_lines;
+            continue;
+        }
+
+        if (writer->buf_nlines == 0)
+            writer->buf_line = line;
+        ncopy = block_lines - writer->buf_nlines;
+        if (ncopy > nlines - done)
+            ncopy = nlines - done;
+        for (plane = 0; plane < writer->nplanes; plane++)
+            memcpy (&writer->buf[plane * buf_plane_size +
+                (size_t) writer->buf_nlines * writer->line_bytes],
+                &out_buf[plane * in_plane_size + (size_t) done *
+                writer->line_bytes], (size_t) ncopy * writer->line_bytes);
+        writer->buf_nlines += ncopy;
+        line += ncopy;
+        done += ncopy;
+
+        if (writer->buf_nlines == block_lines)
+        {
+            for (plane = 0; plane < writer->nplanes; plane++)
+            {
+                if (write_out_block (writer, plane, writer->buf_line,
+                    block_lines, &writer->buf[plane * buf_plane_size])
+                    != SUCCESS)
+                    return (ERROR);
+            }
+            writer->buf_nlines = 0;
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  write_out_overviews
+
+PURPOSE:  Write the full resolution directory of the output file, then each
+overview level as one of its SubIFDs, reducing each level from the one
+before.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. Called once all the lines have been written, before the file is closed.
+   Does nothing without overviews.
+2. The levels are marked as reduced images and have the compression and
+   strip or tile layout of the full resolution image.  They carry no
+   geokeys, as viewers scale those of the full resolution image.
+3. Only the first level is gathered while the lines are written.  Each
+   further level is a quarter of the size of the one before, so reducing it
+   from that level in memory is cheap.
+******************************************************************************/
+short write_out_overviews
+(
+    Out_writer_t *writer  /* I/O: writer */
+)
+{
+    char FUNC_NAME[] = "write_out_overviews"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    short status = SUCCESS;  /* return status */
+    int level;               /* current overview level */
+    uint32 i;                /* looping variable for the lines */
+    uint16 plane;            /* looping variable for the planes */
+    uint16 compress;         /* COMPRESSION_* of the output file */
+    uint16 predictor = PREDICTOR_NONE;  /* predictor of the output file */
+    uint16 planar_config;    /* PLANARCONFIG_* of the output file */
+    uint16 sampleformat;     /* data type of the output file */
+    uint32 tile_length = 0;  /* tile length (if tiled) */
+    uint32 strip_lines = 0;  /* lines per strip (if stripped) */
+    uint32 nlines;           /* lines of the current level */
+    uint32 nsamps;           /* samples of the current level */
+    uint32 line_bytes;       /* bytes in one line of the current level */
+    uint32 next_nlines;      /* lines of the next level */
+    uint32 next_nsamps;      /* samples of the next level */
+    uint32 next_line_bytes;  /* bytes in one line of the next level */
+    uint8 *next_buf;         /* next level */
+    TIFF *fp_tiff = writer->fp_tiff;  /* tiff file pointer */
+    Out_writer_t ovr_writer; /* writer of the current level */
+
+    if (writer->novr == 0)
+        return (SUCCESS);
+
+    /* Keep the layout of the full resolution image for the levels */
+    TIFFGetField (fp_tiff, TIFFTAG_COMPRESSION, &compress);
+    if (compress != COMPRESSION_NONE)
+        TIFFGetField (fp_tiff, TIFFTAG_PREDICTOR, &predictor);
+    TIFFGetField (fp_tiff, TIFFTAG_PLANARCONFIG, &planar_config);
+    TIFFGetField (fp_tiff, TIFFTAG_SAMPLEFORMAT, &sampleformat);
+    if (writer->tiled)
+        TIFFGetField (fp_tiff, TIFFTAG_TILELENGTH, &tile_length);
+    else
+        TIFFGetField (fp_tiff, TIFFTAG_ROWSPERSTRIP, &strip_lines);
+
+    if (!TIFFWriteDirectory (fp_tiff))
+    {
+        sprintf (errmsg, "Error writing the directory of %s",
+            writer->tiffile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    nlines = writer->ovr_nlines;
+    nsamps = writer->ovr_nsamps;
+    line_bytes = writer->ovr_line_bytes;
+    for (level = 1; level <= writer->novr; level++)
+    {
+        /* Set up the directory of the level */
+        if (TIFFSetField (fp_tiff, TIFFTAG_SUBFILETYPE,
+            FILETYPE_REDUCEDIMAGE) == 0 ||
+            TIFFSetField (fp_tiff, TIFFTAG_IMAGELENGTH, nlines) == 0 ||
+            TIFFSetField (fp_tiff, TIFFTAG_IMAGEWIDTH, nsamps) == 0 ||
+            TIFFSetField (fp_tiff, TIFFTAG_BITSPERSAMPLE, writer->bits) == 0 ||
+            TIFFSetField (fp_tiff, TIFFTAG_SAMPLESPERPIXEL, writer->nbands)
+            == 0 ||
+            TIFFSetField (fp_tiff, TIFFTAG_SAMPLEFORMAT, sampleformat) == 0 ||
+            TIFFSetField (fp_tiff, TIFFTAG_PHOTOMETRIC,
+            PHOTOMETRIC_MINISBLACK) == 0 ||
+            TIFFSetField (fp_tiff, TIFFTAG_PLANARCONFIG, planar_config) == 0 ||
+            TIFFSetField (fp_tiff, TIFFTAG_COMPRESSION, compress) == 0 ||
+            (predictor != PREDICTOR_NONE && TIFFSetField (fp_tiff,
+            TIFFTAG_PREDICTOR, predictor) == 0) ||
+            (writer->tiled && (TIFFSetField (fp_tiff, TIFFTAG_TILEWIDTH,
+            writer->tile_width) == 0 || TIFFSetField (fp_tiff,
+            TIFFTAG_TILELENGTH, tile_length) == 0)) ||
+            (!writer->tiled && TIFFSetField (fp_tiff, TIFFTAG_ROWSPERSTRIP,
+            strip_lines) == 0))
+        {
+            sprintf (errmsg, "Error setting up overview level %d of %s",
+                level, writer->tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+            break;
+        }
+
+        /* Write the level and its directory */
+        if (init_out_writer (&ovr_writer, fp_tiff, writer->tiffile, nlines,
+            nsamps, OUT_OVR_NONE) != SUCCESS)
+        {
+            status = ERROR;
+            break;
+        }
+        status = write_out_lines (&ovr_writer, 0, nlines, writer->ovr_buf);
+        free_out_writer (&ovr_writer);
+        if (status != SUCCESS)
+            break;
+        if (!TIFFWriteDirectory (fp_tiff))
+        {
+            sprintf (errmsg, "Error writing overview level %d of %s", level,
+                writer->tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+            break;
+        }
+        if (level == writer->novr)
+            break;
+
+        /* Reduce the level into the next one */
+        next_nlines = (nlines + 1) / 2;
+        next_nsamps = (nsamps + 1) / 2;
+        next_line_bytes = ((size_t) next_nsamps * writer->pixel_bits + 7) / 8;
+        next_buf = (uint8 *) calloc ((size_t) writer->nplanes * next_nlines *
+            next_line_bytes, sizeof (uint8));
+        if (next_buf == NULL)
+        {
+            sprintf (errmsg, "Error allocating memory for overview level %d "
+                "of %s", level + 1, writer->tiffile);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+            break;
+        }
+        for (plane = 0; plane < writer->nplanes; plane++)
+            for (i = 0; i < nlines; i++)
+                reduce_out_line (&writer->ovr_buf[((size_t) plane * nlines +
+                    i) * line_bytes], nsamps, writer->nbands /
+                    writer->nplanes, writer->bits, writer->ovr_reduce,
+                    &next_buf[((size_t) plane * next_nlines + i / 2) *
+                    next_line_bytes]);
+        free (writer->ovr_buf);
+        writer->ovr_buf = next_buf;
+        nlines = next_nlines;
+        nsamps = next_nsamps;
+        line_bytes = next_line_bytes;
+    }
+
+    free (writer->ovr_buf);
+    writer->ovr_buf = NULL;
+    writer->novr = 0;
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  free_out_writer
+
+PURPOSE:  Free the buffers of the writer.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void free_out_writer
+(
+    Out_writer_t *writer  /* I/O: writer */
+)
+{
+    free (writer->buf);
+    free (writer->tile_buf);
+    free (writer->ovr_buf);
+    writer->buf = NULL;
+    writer->tile_buf = NULL;
+    writer->ovr_buf = NULL;
+}
@@ -0,0 +1,189 @@
+#ifndef _UNPACK_OUT_H_
+#define _UNPACK_OUT_H_
+
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+
+/* Formats of the QA statistics sidecar file */
+#define OUT_STATS_NONE 0  /* no statistics */
+#define OUT_STATS_JSON 1
+#define OUT_STATS_CSV 2
+
+/* Default half-width, in percent, of the confidence bounds of the cover
+   estimates */
+#define OUT_EST_MARGIN 1.0
+
+/* Reductions of the overview levels of the unpacked GeoTIFF files */
+#define OUT_OVR_NONE 0    /* no overviews */
+#define OUT_OVR_ANY 1     /* 1 where any pixel covered is nonzero */
+#define OUT_OVR_MAX 2     /* largest value of the pixels covered */
+
+/* Overview levels are added until the last fits in this many lines and
+   samples, up to OUT_MAX_OVERVIEWS levels */
+#define OUT_OVR_MIN_SIZE 256
+#define OUT_MAX_OVERVIEWS 16
+
+/* Windows of the QA band to unpack */
+#define OUT_WIN_NONE 0    /* the whole QA band */
+#define OUT_WIN_PIXEL 1   /* first line and sample, lines and samples */
+#define OUT_WIN_MAP 2     /* upper left and lower right map coordinates */
+
+/* Coordinates of the points to extract */
+#define OUT_PTS_NONE 0    /* no points */
+#define OUT_PTS_PIXEL 1   /* line and sample */
+#define OUT_PTS_MAP 2     /* map x and y */
+
+/* Defaults for the layout of the unpacked GeoTIFF files */
+#define OUT_STRIP_LINES 64
+#define OUT_TILE_SIZE 256
+
+/* Compression and layout of the unpacked GeoTIFF files */
+typedef struct
+{
+    uint16 compress;      /* COMPRESSION_* codec of the output files */
+    bool tiled;           /* write tiled output, otherwise stripped output */
+    uint32 tile_size;     /* tile width and length of tiled output */
+    uint32 strip_lines;   /* lines per strip of stripped output */
+    bool packed;          /* write 1-bit and 2-bit fields as packed samples */
+    bool multiband;       /* write all the fields as bands of one file */
+    uint16 planar_config; /* PLANARCONFIG_* of multiband output */
+    int stats_format;     /* OUT_STATS_* format of the statistics sidecar */
+    bool stats_only;      /* only write the statistics sidecar */
+    char *qa_expr;        /* boolean QA expression of the combined output,
+                             NULL to combine the specified fields */
+    bool estimate;        /* only estimate the cover of each field from a
+                             sample of the QA band */
+    double est_margin;    /* half-width, in percent, the confidence bounds of
+                             the estimates must reach to stop sampling */
+    int overviews;        /* OUT_OVR_* reduction of the overview levels */
+    int window;           /* OUT_WIN_* window of the QA band to unpack */
+    double win[4];        /* first line, first sample, lines and samples of
+                             a pixel window, or upper left x and y and lower
+                             right x and y of a map window */
+    int points;           /* OUT_PTS_* coordinates of the points to extract */
+    char *points_file;    /* file listing the points, NULL without points */
+} Out_opts_t;
+
+/* Writer for one unpacked GeoTIFF file.  Lines are collected in order until
+   a full strip or row of tiles is available and then written encoded.  With
+   overviews each line is also reduced into the first overview level as it
+   passes through. */
+typedef struct
+{
+    TIFF *fp_tiff;        /* tiff file pointer of the output file */
+    char *tiffile;        /* output filename */
+    uint32 nlines;        /* number of lines in the output */
+    uint32 nsamps;        /* number of samples in the output */
+    uint16 bits;          /* bits per sample, 8 or 16 or packed 1 or 2 */
+    uint16 nbands;        /* samples per pixel */
+    uint16 nplanes;       /* planes written separately, nbands for
+                             PLANARCONFIG_SEPARATE otherwise 1 */
+    uint32 pixel_bits;    /* bits of one pixel in a plane */
+    uint32 line_bytes;    /* bytes in one line of a plane */
+    bool tiled;           /* output is tiled */
+    uint32 tile_width;    /* tile width (if tiled) */
+    uint32 out_lines;     /* lines in each strip or row of tiles */
+    uint32 buf_line;      /* first line held in buf */
+    uint32 buf_nlines;    /* number of lines held in buf */
+    uint8 *buf;           /* lines of the current strip or row of tiles,
+                             one set of lines per plane */
+    uint8 *tile_buf;      /* one tile (if tiled) */
+    int ovr_reduce;       /* OUT_OVR_* reduction of the overviews */
+    int novr;             /* number of overview levels, 0 for none */
+    uint32 ovr_nlines;    /* number of lines in the first overview level */
+    uint32 ovr_nsamps;    /* number of samples in the first overview level */
+    uint32 ovr_line_bytes;  /* bytes in one line of a plane of the first
+                               overview level */
+    uint8 *ovr_buf;       /* first overview level, one set of lines per
+                             plane */
+} Out_writer_t;
+
+void init_out_opts
+(
+    Out_opts_t *out_opts  /* O: output options set to the defaults */
+);
+
+short parse_out_compress
+(
+    char *compress_str,   /* I: name of the compression */
+    Out_opts_t *out_opts  /* I/O: output options */
+);
+
+short parse_out_multiband
+(
+    char *interleave_str, /* I: name of the band interleave */
+    Out_opts_t *out_opts  /* I/O: output options */
+);
+
+short parse_out_stats
+(
+    char *format_str,     /* I: name of the statistics format */
+    Out_opts_t *out_opts  /* I/O: output options */
+);
+
+short parse_out_overviews
+(
+    char *reduce_str,     /* I: name of the overview reduction, NULL for the
+                                default */
+    Out_opts_t *out_opts  /* I/O: output options */
+);
+
+short parse_out_estimate
+(
+    char *margin_str,     /* I: half-width of the bounds in percent, NULL for
+                                the default */
+    Out_opts_t *out_opts  /* I/O: output options */
+);
+
+short parse_out_window
+(
+    char *window_str,     /* I: four comma-separated window values */
+    int window,           /* I: OUT_WIN_PIXEL or OUT_WIN_MAP */
+    Out_opts_t *out_opts  /* I/O: output options */
+);
+
+short parse_out_points
+(
+    char *points_file,    /* I: file listing the points */
+    int points,           /* I: OUT_PTS_PIXEL or OUT_PTS_MAP */
+    Out_opts_t *out_opts  /* I/O: output options */
+);
+
+short set_tiff_layout
+(
+    TIFF *fp_tiff,        /* I: tiff file pointer of the output file */
+    char *tiffile,        /* I: output filename */
+    Out_opts_t *out_opts  /* I: output options */
+);
+
+short init_out_writer
+(
+    Out_writer_t *writer, /* O: writer */
+    TIFF *fp_tiff,        /* I: tiff file pointer of the output file */
+    char *tiffile,        /* I: output filename */
+    uint32 nlines,        /* I: number of lines in the output */
+    uint32 nsamps,        /* I: number of samples in the output */
+    int ovr_reduce        /* I: OUT_OVR_* reduction of the overviews */
+);
+
+short write_out_lines
+(
+    Out_writer_t *writer, /* I/O: writer */
+    uint32 line,          /* I: first line to write */
+    uint32 nlines,        /* I: number of lines to write */
+    uint8 *out_buf        /* I: nlines lines of unpacked values for each
+                                plane */
+);
+
+short write_out_overviews
+(
+    Out_writer_t *writer  /* I/O: writer */
+);
+
+void free_out_writer
+(
+    Out_writer_t *writer  /* I/O: writer */
+);
+
+#endif
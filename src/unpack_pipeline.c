@@ -0,0 +1,595 @@
+#include <pthread.h>
+#include "unpack_pipeline.h"
+
+/* States of a pipeline block slot */
+#define SLOT_FREE 0       /* slot can be filled by the reader */
+#define SLOT_READ 1       /* QA lines read, or only assigned with a parallel
+                             read, waiting for an unpack thread */
+#define SLOT_BUSY 2       /* being unpacked */
+#define SLOT_UNPACKED 3   /* unpacked, waiting for the writers */
+
+typedef struct
+{
+    int state;            /* one of the SLOT_* states */
+    int block;            /* index of the block held in the slot */
+    int line;             /* first line of the block */
+    int nlines;           /* number of lines in the block */
+    int nwrites;          /* number of outputs still to be written */
+    uint16 *qa_buf;       /* buffer for the QA lines of the block */
+    uint16 *qa_lines;     /* QA lines of the block, qa_buf or read in place */
+    uint8 **out_buf;      /* unpacked lines of the block for each output */
+} Pipe_slot_t;
+
+typedef struct
+{
+    pthread_mutex_t lock; /* protects the slot states and counters */
+    pthread_cond_t cond;  /* signaled on every slot state change */
+    Pipe_slot_t *slot;    /* ring of block slots */
+    int nslots;           /* number of slots */
+    int nblocks;          /* number of blocks in the QA band */
+    int nunpacked;        /* number of blocks taken by the unpack threads */
+    bool error;           /* a stage failed, all stages stop */
+    int nout;             /* number of outputs */
+    bool parallel_read;   /* the unpack threads read their own blocks */
+    Read_lines_t read_lines;      /* reader */
+    Unpack_lines_t unpack_lines;  /* unpacker */
+    Write_lines_t write_lines;    /* writer */
+    void *arg;            /* caller context */
+} Pipe_t;
+
+typedef struct
+{
+    Pipe_t *pipe;         /* shared pipeline state */
+    int worker;           /* index of this unpack thread */
+} Pipe_worker_t;
+
+/* Block slots kept by a calling thread from one run to the next */
+typedef struct
+{
+    bool keep;            /* keep the slots after each run */
+    Pipe_slot_t *slot;    /* kept slots */
+    int nslots;           /* number of kept slots */
+    int nout;             /* number of output buffers in each slot */
+    size_t qa_size;       /* number of QA values in each slot */
+    size_t out_size;      /* bytes in each output buffer */
+} Pipe_cache_t;
+
+static __thread Pipe_cache_t pipe_cache;
+
+typedef struct
+{
+    Pipe_t *pipe;         /* shared pipeline state */
+    int out;              /* output index written by this writer thread */
+} Pipe_writer_t;
+
+
+/******************************************************************************
+MODULE:  unpack_thread
+
+PURPOSE:  Unpack thread of the pipeline.  Takes the read blocks in block order
+and unpacks them into the output buffers of their slot.  With a parallel read
+the thread reads the block itself first, so blocks are decoded on all the
+unpack threads at once.
+
+RETURN VALUE:
+Type = void *
+Value           Description
+-----           -----------
+NULL            Always
+
+NOTES:
+******************************************************************************/
+static void *unpack_thread
+(
+    void *data            /* I: unpack thread state */
+)
+{
+    Pipe_worker_t *worker = (Pipe_worker_t *) data;
+    Pipe_t *pipe = worker->pipe;
+    Pipe_slot_t *slot;
+    short status = SUCCESS;  /* status of the read */
+
+    pthread_mutex_lock (&pipe->lock);
+    while (!pipe->error && pipe->nunpacked < pipe->nblocks)
+    {
+        /* Wait for the next block in order to be read */
+        slot = &pipe->slot[pipe->nunpacked % pipe->nslots];
+        if (slot->state != SLOT_READ || slot->block != pipe->nunpacked)
+        {
+            pthread_cond_wait (&pipe->cond, &pipe->lock);
+            continue;
+        }
+        slot->state = SLOT_BUSY;
+        pipe->nunpacked++;
+        pthread_mutex_unlock (&pipe->lock);
+
+        if (pipe->parallel_read)
+            status = pipe->read_lines (pipe->arg, worker->worker, slot->line,
+                slot->nlines, slot->qa_buf, &slot->qa_lines);
+        if (status == SUCCESS)
+            pipe->unpack_lines (pipe->arg, worker->worker, slot->qa_lines,
+                slot->nlines, slot->out_buf);
+
+        pthread_mutex_lock (&pipe->lock);
+        if (status != SUCCESS)
+        {
+            pipe->error = true;
+            pthread_cond_broadcast (&pipe->cond);
+            break;
+        }
+        slot->nwrites = pipe->nout;
+        slot->state = (pipe->nout > 0) ? SLOT_UNPACKED : SLOT_FREE;
+        pthread_cond_broadcast (&pipe->cond);
+    }
+    pthread_mutex_unlock (&pipe->lock);
+    return (NULL);
+}
+
+
+/******************************************************************************
+MODULE:  write_thread
+
+PURPOSE:  Writer thread of the pipeline for one output.  Writes the unpacked
+blocks in line order and frees each slot once all outputs have written it.
+
+RETURN VALUE:
+Type = void *
+Value           Description
+-----           -----------
+NULL            Always
+
+NOTES:
+******************************************************************************/
+static void *write_thread
+(
+    void *data            /* I: writer state */
+)
+{
+    Pipe_writer_t *writer = (Pipe_writer_t *) data;
+    Pipe_t *pipe = writer->pipe;
+    Pipe_slot_t *slot;
+    int block;            /* next block to be written */
+    short status;         /* status of the write */
+
+    pthread_mutex_lock (&pipe->lock);
+    for (block = 0; block < pipe->nblocks && !pipe->error; )
+    {
+        slot = &pipe->slot[block % pipe->nslots];
+        if (slot->state != SLOT_UNPACKED || slot->block != block)
+        {
+            pthread_cond_wait (&pipe->cond, &pipe->lock);
+            continue;
+        }
+        pthread_mutex_unlock (&pipe->lock);
+
+        status = pipe->write_lines (pipe->arg, writer->out, slot->line,
+            slot->nlines, slot->out_buf[writer->out]);
+
+        pthread_mutex_lock (&pipe->lock);
+        if (status != SUCCESS)
+            pipe->error = true;
+        if (--slot->nwrites == 0)
+            slot->state = SLOT_FREE;
+        pthread_cond_broadcast (&pipe->cond);
+        block++;
+    }
+    pthread_mutex_unlock (&pipe->lock);
+    return (NULL);
+}
+
+
+/******************************************************************************
+MODULE:  free_slots
+
+PURPOSE:  Free the block slots of the pipeline.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void free_slots
+(
+    Pipe_slot_t *slot,    /* I: block slots */
+    int nslots,           /* I: number of slots */
+    int nout              /* I: number of output buffers in each slot */
+)
+{
+    int i, out;              /* looping variables */
+
+    if (slot == NULL)
+        return;
+    for (i = 0; i < nslots; i++)
+    {
+        if (slot[i].out_buf != NULL)
+        {
+            for (out = 0; out < nout; out++)
+                free (slot[i].out_buf[out]);
+            free (slot[i].out_buf);
+        }
+        free (slot[i].qa_buf);
+    }
+    free (slot);
+}
+
+
+/******************************************************************************
+MODULE:  alloc_slots
+
+PURPOSE:  Allocate the block slots of the pipeline.
+
+RETURN VALUE:
+Type = Pipe_slot_t *
+Value           Description
+-----           -----------
+NULL            Error allocating the slots
+not NULL        Block slots
+
+NOTES:
+******************************************************************************/
+static Pipe_slot_t *alloc_slots
+(
+    int nslots,           /* I: number of slots */
+    int nout,             /* I: number of output buffers in each slot */
+    size_t qa_size,       /* I: number of QA values in each slot */
+    size_t out_size       /* I: bytes in each output buffer */
+)
+{
+    Pipe_slot_t *slot;       /* block slots */
+    int i, out;              /* looping variables */
+
+    slot = (Pipe_slot_t *) calloc (nslots, sizeof (Pipe_slot_t));
+    if (slot == NULL)
+        return (NULL);
+    for (i = 0; i < nslots; i++)
+    {
+        slot[i].qa_buf = (uint16 *) calloc (qa_size, sizeof (uint16));
+        slot[i].out_buf = (uint8 **) calloc (nout + 1, sizeof (uint8 *));
+        if (slot[i].qa_buf == NULL || slot[i].out_buf == NULL)
+        {
+            free_slots (slot, nslots, nout);
+            return (NULL);
+        }
+        for (out = 0; out < nout; out++)
+        {
+            slot[i].out_buf[out] = (uint8 *) calloc (out_size, sizeof (uint8));
+            if (slot[i].out_buf[out] == NULL)
+            {
+                free_slots (slot, nslots, nout);
+                return (NULL);
+            }
+        }
+    }
+
+    return (slot);
+}
+
+
+/******************************************************************************
+MODULE:  keep_pipeline_buffers
+
+PURPOSE:  Keep the block buffers of the pipelines run by the calling thread
+from one run to the next, so a thread running many pipelines in a row only
+allocates them once.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The buffers grow to the largest run.  free_pipeline_buffers frees them and
+   must be called before the thread exits.
+******************************************************************************/
+void keep_pipeline_buffers
+(
+    bool keep             /* I: keep the buffers between runs */
+)
+{
+    pipe_cache.keep = keep;
+}
+
+
+/******************************************************************************
+MODULE:  free_pipeline_buffers
+
+PURPOSE:  Free the block buffers kept by the calling thread and stop keeping
+them.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void free_pipeline_buffers (void)
+{
+    free_slots (pipe_cache.slot, pipe_cache.nslots, pipe_cache.nout);
+    pipe_cache.slot = NULL;
+    pipe_cache.nslots = 0;
+    pipe_cache.nout = 0;
+    pipe_cache.qa_size = 0;
+    pipe_cache.out_size = 0;
+    pipe_cache.keep = false;
+}
+
+
+/******************************************************************************
+MODULE:  set_slot_lines
+
+PURPOSE:  Set the lines of a block in its slot.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The first block is lead_lines short of block_lines, so the following
+   blocks start on the strips or tiles of a windowed input.
+******************************************************************************/
+static void set_slot_lines
+(
+    Pipe_slot_t *slot,    /* I/O: slot of the block */
+    int block,            /* I: index of the block */
+    uint32 nlines,        /* I: number of lines in the QA band */
+    int block_lines,      /* I: number of lines in each block */
+    int lead_lines        /* I: lines the first block is short */
+)
+{
+    int end;                 /* line after the block */
+
+    slot->line = block * block_lines - lead_lines;
+    if (slot->line < 0)
+        slot->line = 0;
+    end = (block + 1) * block_lines - lead_lines;
+    if (end > (int) nlines)
+        end = nlines;
+    slot->nlines = end - slot->line;
+}
+
+
+/******************************************************************************
+MODULE:  run_unpack_pipeline
+
+PURPOSE:  Run the read, unpack and write stages over the QA band one block of
+lines at a time.  With more than one thread, the calling thread reads the
+blocks, nthreads threads unpack them in parallel and one thread per output
+writes them in line order.  A ring of 2 * nthreads block slots bounds the
+memory used.  With a parallel read the calling thread only assigns the
+blocks to the slots and the unpack threads read them.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           An error occurred during processing
+SUCCESS         Processing was successful
+
+NOTES:
+1. The block buffers are reused from the previous run of the calling thread
+   when it keeps them (see keep_pipeline_buffers) and they are big enough.
+2. With lead_lines the first block is that many lines short, so the blocks
+   of a window of the QA band still line up with its strips or tiles.
+******************************************************************************/
+short run_unpack_pipeline
+(
+    int nthreads,         /* I: number of unpack threads, 1 runs serially */
+    uint32 nlines,        /* I: number of lines in the QA band */
+    uint32 nsamps,        /* I: number of samples in the QA band */
+    int block_lines,      /* I: number of lines in each block */
+    int lead_lines,       /* I: lines the first block is short of
+                                block_lines, 0 to block_lines-1 */
+    int nout,             /* I: number of outputs */
+    int out_line_size,    /* I: bytes in one line of each output buffer */
+    bool parallel_read,   /* I: the unpack threads read their own blocks */
+    Read_lines_t read_lines,      /* I: reader */
+    Unpack_lines_t unpack_lines,  /* I: unpacker */
+    Write_lines_t write_lines,    /* I: writer */
+    void *arg             /* I: caller context passed to the callbacks */
+)
+{
+    char FUNC_NAME[] = "run_unpack_pipeline"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    int i, out;              /* looping variables */
+    int block;               /* current block */
+    int nthreads_started = 0;  /* number of unpack threads started */
+    int nwriters_started = 0;  /* number of writer threads started */
+    short status = SUCCESS;  /* return status */
+    Pipe_t pipe;             /* pipeline state */
+    Pipe_slot_t *slot;       /* current slot */
+    Pipe_worker_t *worker = NULL;   /* unpack thread states */
+    Pipe_writer_t *writer = NULL;   /* writer thread states */
+    pthread_t *thread = NULL;       /* unpack and writer threads */
+    int alloc_nslots;        /* number of slots allocated */
+    int alloc_nout;          /* number of output buffers in each slot */
+    size_t qa_size;          /* number of QA values in each slot */
+    size_t out_size;         /* bytes in each output buffer */
+
+    if (block_lines < 1)
+        block_lines = PIPE_BLOCK_LINES;
+    if (lead_lines < 0 || lead_lines >= block_lines)
+        lead_lines = 0;
+    if (nthreads < 1)
+        nthreads = 1;
+    pipe.nblocks = (nlines + lead_lines + block_lines - 1) / block_lines;
+    pipe.nslots = (nthreads > 1) ? 2 * nthreads : 1;
+    if (pipe.nslots > pipe.nblocks)
+        pipe.nslots = (pipe.nblocks > 0) ? pipe.nblocks : 1;
+    pipe.nunpacked = 0;
+    pipe.error = false;
+    pipe.nout = nout;
+    pipe.parallel_read = parallel_read;
+    pipe.read_lines = read_lines;
+    pipe.unpack_lines = unpack_lines;
+    pipe.write_lines = write_lines;
+    pipe.arg = arg;
+
+    /* Allocate the block slots, or reuse the ones kept from the previous
+       run if they are big enough */
+    qa_size = (size_t) block_lines * nsamps;
+    out_size = (size_t) block_lines * out_line_size;
+    if (pipe_cache.slot != NULL && pipe_cache.nslots >= pipe.nslots &&
+        pipe_cache.nout >= nout && pipe_cache.qa_size >= qa_size &&
+        pipe_cache.out_size >= out_size)
+    {
+        pipe.slot = pipe_cache.slot;
+        alloc_nslots = pipe_cache.nslots;
+        alloc_nout = pipe_cache.nout;
+        qa_size = pipe_cache.qa_size;
+        out_size = pipe_cache.out_size;
+    }
+    else
+    {
+        /* Grow the kept slots to cover both runs */
+        alloc_nslots = pipe.nslots;
+        alloc_nout = nout;
+        if (pipe_cache.slot != NULL)
+        {
+            if (pipe_cache.nslots > alloc_nslots)
+                alloc_nslots = pipe_cache.nslots;
+            if (pipe_cache.nout > alloc_nout)
+                alloc_nout = pipe_cache.nout;
+            if (pipe_cache.qa_size > qa_size)
+                qa_size = pipe_cache.qa_size;
+            if (pipe_cache.out_size > out_size)
+                out_size = pipe_cache.out_size;
+            free_slots (pipe_cache.slot, pipe_cache.nslots, pipe_cache.nout);
+            pipe_cache.slot = NULL;
+        }
+        pipe.slot = alloc_slots (alloc_nslots, alloc_nout, qa_size,
+            out_size);
+        if (pipe.slot == NULL)
+        {
+            sprintf (errmsg, "Error allocating memory for the pipeline "
+                "blocks");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+    for (i = 0; i < pipe.nslots; i++)
+    {
+        slot = &pipe.slot[i];
+        slot->state = SLOT_FREE;
+        slot->block = -1;
+    }
+
+    if (status == SUCCESS && nthreads == 1)
+    {
+        /* Run the stages one after the other on the calling thread */
+        slot = &pipe.slot[0];
+        for (block = 0; block < pipe.nblocks && status == SUCCESS; block++)
+        {
+            set_slot_lines (slot, block, nlines, block_lines, lead_lines);
+            status = read_lines (arg, 0, slot->line, slot->nlines,
+                slot->qa_buf, &slot->qa_lines);
+            if (status != SUCCESS)
+                break;
+            unpack_lines (arg, 0, slot->qa_lines, slot->nlines,
+                slot->out_buf);
+            for (out = 0; out < nout && status == SUCCESS; out++)
+                status = write_lines (arg, out, slot->line, slot->nlines,
+                    slot->out_buf[out]);
+        }
+    }
+    else if (status == SUCCESS)
+    {
+        pthread_mutex_init (&pipe.lock, NULL);
+        pthread_cond_init (&pipe.cond, NULL);
+
+        thread = (pthread_t *) calloc (nthreads + nout, sizeof (pthread_t));
+        worker = (Pipe_worker_t *) calloc (nthreads, sizeof (Pipe_worker_t));
+        writer = (Pipe_writer_t *) calloc (nout + 1, sizeof (Pipe_writer_t));
+        if (thread == NULL || worker == NULL || writer == NULL)
+        {
+            sprintf (errmsg, "Error allocating memory for the pipeline "
+                "threads");
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+
+        /* Start the unpack threads and one writer thread per output */
+        for (i = 0; i < nthreads && status == SUCCESS; i++)
+        {
+            worker[i].pipe = &pipe;
+            worker[i].worker = i;
+            if (pthread_create (&thread[i], NULL, unpack_thread, &worker[i])
+                != 0)
+                status = ERROR;
+            else
+                nthreads_started++;
+        }
+        for (out = 0; out < nout && status == SUCCESS; out++)
+        {
+            writer[out].pipe = &pipe;
+            writer[out].out = out;
+            if (pthread_create (&thread[nthreads + out], NULL, write_thread,
+                &writer[out]) != 0)
+                status = ERROR;
+            else
+                nwriters_started++;
+        }
+        if (status != SUCCESS && thread != NULL)
+        {
+            sprintf (errmsg, "Error starting the pipeline threads");
+            error_handler (true, FUNC_NAME, errmsg);
+        }
+
+        /* Read the blocks in order into the free slots, or only assign them
+           to the slots with a parallel read */
+        pthread_mutex_lock (&pipe.lock);
+        if (status != SUCCESS)
+            pipe.error = true;
+        for (block = 0; block < pipe.nblocks && !pipe.error; )
+        {
+            slot = &pipe.slot[block % pipe.nslots];
+            if (slot->state != SLOT_FREE)
+            {
+                pthread_cond_wait (&pipe.cond, &pipe.lock);
+                continue;
+            }
+            pthread_mutex_unlock (&pipe.lock);
+
+            set_slot_lines (slot, block, nlines, block_lines, lead_lines);
+            if (!parallel_read)
+                status = read_lines (arg, 0, slot->line, slot->nlines,
+                    slot->qa_buf, &slot->qa_lines);
+
+            pthread_mutex_lock (&pipe.lock);
+            if (status != SUCCESS)
+                pipe.error = true;
+            else
+            {
+                slot->block = block;
+                slot->state = SLOT_READ;
+            }
+            pthread_cond_broadcast (&pipe.cond);
+            block++;
+        }
+        pthread_cond_broadcast (&pipe.cond);
+        pthread_mutex_unlock (&pipe.lock);
+
+        /* Wait for the unpack and writer threads to finish */
+        for (i = 0; i < nthreads_started; i++)
+            pthread_join (thread[i], NULL);
+        for (out = 0; out < nwriters_started; out++)
+            pthread_join (thread[nthreads + out], NULL);
+        if (pipe.error)
+            status = ERROR;
+
+        pthread_cond_destroy (&pipe.cond);
+        pthread_mutex_destroy (&pipe.lock);
+    }
+
+    /* Keep the block slots for the next run, or free them */
+    if (pipe_cache.keep)
+    {
+        pipe_cache.slot = pipe.slot;
+        pipe_cache.nslots = alloc_nslots;
+        pipe_cache.nout = alloc_nout;
+        pipe_cache.qa_size = qa_size;
+        pipe_cache.out_size = out_size;
+    }
+    else
+        free_slots (pipe.slot, alloc_nslots, alloc_nout);
+    free (thread);
+    free (worker);
+    free (writer);
+
+    return (status);
+}
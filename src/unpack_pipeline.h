@@ -0,0 +1,76 @@
+#ifndef _UNPACK_PIPELINE_H_
+#define _UNPACK_PIPELINE_H_
+
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+
+#ifndef STR_SIZE
+#define STR_SIZE 1024
+#endif
+
+/* Default number of lines unpacked as one block of the pipeline */
+#define PIPE_BLOCK_LINES 64
+
+/* Reads nlines lines of the QA band starting at line, into qa_buf or in
+   place.  Called from one thread in line order, or with a parallel read
+   from each unpack thread with its own worker index. */
+typedef short (*Read_lines_t)
+(
+    void *arg,            /* I: caller context */
+    int worker,           /* I: index of the reading thread, 0 to nthreads-1 */
+    int line,             /* I: first line to read */
+    int nlines,           /* I: number of lines to read */
+    uint16 *qa_buf,       /* O: buffer for nlines lines of QA values */
+    uint16 **qa_lines     /* O: the QA values for nlines lines, qa_buf or
+                                memory that stays valid for the whole run */
+);
+
+/* Unpacks nlines lines of QA values into the output buffers.  Called from
+   several threads at once, so it must only modify the parts of the caller
+   context that belong to its worker index. */
+typedef void (*Unpack_lines_t)
+(
+    void *arg,            /* I: caller context */
+    int worker,           /* I: index of the unpack thread, 0 to nthreads-1 */
+    uint16 *qa_buf,       /* I: QA values for nlines lines */
+    int nlines,           /* I: number of lines in qa_buf */
+    uint8 **out_buf       /* O: one buffer of nlines lines per output */
+);
+
+/* Writes nlines unpacked lines starting at line to output out.  Called from
+   one thread per output, in line order. */
+typedef short (*Write_lines_t)
+(
+    void *arg,            /* I: caller context */
+    int out,              /* I: output index */
+    int line,             /* I: first line to write */
+    int nlines,           /* I: number of lines to write */
+    uint8 *out_buf        /* I: unpacked values for nlines lines */
+);
+
+short run_unpack_pipeline
+(
+    int nthreads,         /* I: number of unpack threads, 1 runs serially */
+    uint32 nlines,        /* I: number of lines in the QA band */
+    uint32 nsamps,        /* I: number of samples in the QA band */
+    int block_lines,      /* I: number of lines in each block */
+    int lead_lines,       /* I: lines the first block is short of
+                                block_lines, 0 to block_lines-1 */
+    int nout,             /* I: number of outputs */
+    int out_line_size,    /* I: bytes in one line of each output buffer */
+    bool parallel_read,   /* I: the unpack threads read their own blocks */
+    Read_lines_t read_lines,      /* I: reader */
+    Unpack_lines_t unpack_lines,  /* I: unpacker */
+    Write_lines_t write_lines,    /* I: writer */
+    void *arg             /* I: caller context passed to the callbacks */
+);
+
+void keep_pipeline_buffers
+(
+    bool keep             /* I: keep the buffers between runs */
+);
+
+void free_pipeline_buffers (void);
+
+#endif
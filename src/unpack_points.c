@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "unpack_stats.h"
+#include "unpack_points.h"
+
+/******************************************************************************
+MODULE:  read_qa_points
+
+PURPOSE:  Read the points of the points file, one per line as two
+coordinates and an optional label, separated by commas or white space.
+Blank lines and lines starting with # are skipped.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Error reading the points
+SUCCESS         Processing was successful
+
+NOTES:
+1. The coordinates are map x and y or line and sample, as selected on the
+   command line.  They are located in the QA band by the caller.
+******************************************************************************/
+short read_qa_points
+(
+    char *points_file,    /* I: file listing the points */
+    Qa_points_t *pts      /* O: points */
+)
+{
+    char FUNC_NAME[] = "read_qa_points"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char line[STR_SIZE];     /* line of the points file */
+    char *start;             /* first character of the line */
+    char *label;             /* label on the line */
+    int len;                 /* length of the label */
+    int nchars;              /* characters of the coordinates used */
+    int line_num = 0;        /* line number in the points file */
+    int nalloc = 0;          /* number of points allocated */
+    Qa_point_t *grown;       /* grown list of points */
+    Qa_point_t *pt;          /* current point */
+    FILE *fp;                /* points file pointer */
+
+    memset (pts, 0, sizeof (Qa_points_t));
+    fp = fopen (points_file, "r");
+    if (fp == NULL)
+    {
+        sprintf (errmsg, "Error opening the points file: %s", points_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    while (fgets (line, sizeof (line), fp) != NULL)
+    {
+        line_num++;
+        start = line;
+        while (isspace ((unsigned char) *start))
+            start++;
+        if (*start == '\0' || *start == '#')
+            continue;
+
+        if (pts->npts == nalloc)
+        {
+            nalloc = nalloc > 0 ? 2 * nalloc : 256;
+            grown = (Qa_point_t *) realloc (pts->pt,
+                nalloc * sizeof (Qa_point_t));
+            if (grown == NULL)
+            {
+                sprintf (errmsg, "Error allocating memory for the points");
+                error_handler (true, FUNC_NAME, errmsg);
+                fclose (fp);
+                return (ERROR);
+            }
+            pts->pt = grown;
+        }
+        pt = &pts->pt[pts->npts];
+        memset (pt, 0, sizeof (Qa_point_t));
+
+        nchars = 0;
+        if (sscanf (start, "%lf%*[ \t,]%lf%n", &pt->x, &pt->y, &nchars) != 2
+            || nchars == 0)
+        {
+            sprintf (errmsg, "Line %d of the points file %s doesn't start "
+                "with two coordinates", line_num, points_file);
+            error_handler (true, FUNC_NAME, errmsg);
+            fclose (fp);
+            return (ERROR);
+        }
+
+        /* Anything after the coordinates is the label */
+        label = start + nchars;
+        while (isspace ((unsigned char) *label) || *label == ',')
+            label++;
+        len = strlen (label);
+        while (len > 0 && isspace ((unsigned char) label[len-1]))
+            label[--len] = '\0';
+        if (len > 0)
+        {
+            pt->label = strdup (label);
+            if (pt->label == NULL)
+            {
+                sprintf (errmsg, "Error allocating memory for the points");
+                error_handler (true, FUNC_NAME, errmsg);
+                fclose (fp);
+                return (ERROR);
+            }
+        }
+        pts->npts++;
+    }
+    fclose (fp);
+
+    if (pts->npts == 0)
+    {
+        sprintf (errmsg, "No points are listed in %s", points_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  compare_point_blocks
+
+PURPOSE:  Order two points by the strip or tile holding them, then by line
+and sample.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+<0, 0, >0       The first point goes before, with or after the second
+
+NOTES:
+******************************************************************************/
+static int compare_point_blocks
+(
+    const void *a,        /* I: first point */
+    const void *b         /* I: second point */
+)
+{
+    const Qa_point_t *pa = *(const Qa_point_t * const *) a;
+    const Qa_point_t *pb = *(const Qa_point_t * const *) b;
+
+    if (pa->block != pb->block)
+        return ((pa->block < pb->block) ? -1 : 1);
+    if (pa->line != pb->line)
+        return ((pa->line < pb->line) ? -1 : 1);
+    if (pa->samp != pb->samp)
+        return ((pa->samp < pb->samp) ? -1 : 1);
+    return (0);
+}
+
+
+/******************************************************************************
+MODULE:  sort_qa_points
+
+PURPOSE:  Group the points inside the QA band by the strip or tile holding
+them, so each strip or tile with points is decoded once.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The line, sample and block of each point must already be set, the line
+   and sample being -1 for points outside the QA band.
+2. If the list can't be allocated, no points are inside.
+******************************************************************************/
+void sort_qa_points
+(
+    Qa_points_t *pts      /* I/O: points, located in the QA band */
+)
+{
+    int i;                   /* looping variable */
+
+    pts->ninside = 0;
+    pts->by_block = (Qa_point_t **) malloc (pts->npts *
+        sizeof (Qa_point_t *));
+    if (pts->by_block == NULL)
+        return;
+    for (i = 0; i < pts->npts; i++)
+    {
+        if (pts->pt[i].line >= 0)
+            pts->by_block[pts->ninside++] = &pts->pt[i];
+    }
+    qsort (pts->by_block, pts->ninside, sizeof (Qa_point_t *),
+        compare_point_blocks);
+}
+
+
+/******************************************************************************
+MODULE:  write_qa_points
+
+PURPOSE:  Write the QA value and the value of each extracted field at each
+point to the points sidecar, in the order of the points file.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Error writing the points
+SUCCESS         Processing was successful
+
+NOTES:
+1. The field values are those of the unpacked outputs: 0 or 1 for a field
+   with a confidence level, otherwise the raw field value.
+2. Points outside the QA band have null (JSON) or empty (CSV) values.
+******************************************************************************/
+short write_qa_points
+(
+    Qa_points_t *pts,     /* I: points with their QA values */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Unpack_field_t *field,  /* I: extracted fields */
+    int qa_type[UNPACK_MAX_FIELDS],  /* I: layout index of each field */
+    int nfields,          /* I: number of extracted fields */
+    char *qa_infile,      /* I: input QA filename */
+    char *ptsfile,        /* I: points sidecar filename */
+    int format            /* I: OUT_STATS_* format of the points */
+)
+{
+    char FUNC_NAME[] = "write_qa_points"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    int i, f;                /* looping variables */
+    int value;               /* value of the current field */
+    Qa_point_t *pt;          /* current point */
+    FILE *fp = NULL;         /* points file pointer */
+
+    fp = fopen (ptsfile, "w");
+    if (fp == NULL)
+    {
+        sprintf (errmsg, "Error opening the QA points file %s", ptsfile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (format == OUT_STATS_JSON)
+    {
+        fprintf (fp, "{\n  \"qa_file\": ");
+        write_json_string (fp, qa_infile);
+        fprintf (fp, ",\n  \"product\": ");
+        write_json_string (fp, layout->product);
+        fprintf (fp, ",\n  \"points\": [");
+    }
+    else
+    {
+        fprintf (fp, "label,x,y,line,samp,qa");
+        for (f = 0; f < nfields; f++)
+            fprintf (fp, ",%s", layout->field[qa_type[f]].name);
+        fprintf (fp, "\n");
+    }
+
+    for (i = 0; i < pts->npts; i++)
+    {
+        pt = &pts->pt[i];
+        if (format == OUT_STATS_JSON)
+        {
+            fprintf (fp, "%s\n    {\"label\": ", (i > 0) ? "," : "");
+            if (pt->label != NULL)
+                write_json_string (fp, pt->label);
+            else
+                fprintf (fp, "null");
+            fprintf (fp, ", \"x\": %.6f, \"y\": %.6f, ", pt->x, pt->y);
+            if (pt->line < 0)
+            {
+                fprintf (fp, "\"line\": null, \"samp\": null, "
+                    "\"qa\": null, \"fields\": null}");
+                continue;
+            }
+            fprintf (fp, "\"line\": %ld, \"samp\": %ld, \"qa\": %u, "
+                "\"fields\": {", pt->line, pt->samp, pt->qa);
+        }
+        else
+        {
+            if (pt->label != NULL)
+                write_csv_string (fp, pt->label);
+            fprintf (fp, ",%.6f,%.6f,", pt->x, pt->y);
+            if (pt->line < 0)
+            {
+                fprintf (fp, ",,");
+                for (f = 0; f < nfields; f++)
+                    fputc (',', fp);
+                fputc ('\n', fp);
+                continue;
+            }
+            fprintf (fp, "%ld,%ld,%u", pt->line, pt->samp, pt->qa);
+        }
+
+        for (f = 0; f < nfields; f++)
+        {
+            value = (pt->qa >> field[f].shift) & field[f].mask;
+            if (field[f].conf > 0)
+                value = (value >= field[f].conf);
+            if (format == OUT_STATS_JSON)
+                fprintf (fp, "%s\"%s\": %d", (f > 0) ? ", " : "",
+                    layout->field[qa_type[f]].name, value);
+            else
+                fprintf (fp, ",%d", value);
+        }
+        if (format == OUT_STATS_JSON)
+            fprintf (fp, "}}");
+        else
+            fputc ('\n', fp);
+    }
+
+    if (format == OUT_STATS_JSON)
+        fprintf (fp, "\n  ]\n}\n");
+
+    if (fclose (fp) != 0)
+    {
+        sprintf (errmsg, "Error writing the QA points file %s", ptsfile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  free_qa_points
+
+PURPOSE:  Free the points and their labels.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void free_qa_points
+(
+    Qa_points_t *pts      /* I/O: points */
+)
+{
+    int i;                   /* looping variable */
+
+    for (i = 0; i < pts->npts; i++)
+        free (pts->pt[i].label);
+    free (pts->pt);
+    free (pts->by_block);
+    memset (pts, 0, sizeof (Qa_points_t));
+}
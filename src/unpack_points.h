@@ -0,0 +1,60 @@
+#ifndef _UNPACK_POINTS_H_
+#define _UNPACK_POINTS_H_
+
+#include <stdio.h>
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+#include "unpack_layout.h"
+
+/* Point whose QA value is extracted */
+typedef struct
+{
+    char *label;          /* label of the point, NULL if none was given */
+    double x, y;          /* coordinates as given, map x and y or line and
+                             sample */
+    long line, samp;      /* pixel of the point, -1 outside the QA band */
+    uint32 block;         /* strip or tile of the QA band holding the point */
+    uint16 qa;            /* QA value at the point */
+} Qa_point_t;
+
+/* Points of a points file, with the order they are read from the QA band
+   in.  The points are grouped by the strip or tile holding them, so each
+   strip or tile with points is decoded once. */
+typedef struct
+{
+    int npts;             /* number of points */
+    Qa_point_t *pt;       /* points in the order of the points file */
+    Qa_point_t **by_block;  /* points inside the QA band, by strip or tile */
+    int ninside;          /* number of points inside the QA band */
+} Qa_points_t;
+
+short read_qa_points
+(
+    char *points_file,    /* I: file listing the points */
+    Qa_points_t *pts      /* O: points */
+);
+
+void sort_qa_points
+(
+    Qa_points_t *pts      /* I/O: points, located in the QA band */
+);
+
+short write_qa_points
+(
+    Qa_points_t *pts,     /* I: points with their QA values */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Unpack_field_t *field,  /* I: extracted fields */
+    int qa_type[UNPACK_MAX_FIELDS],  /* I: layout index of each field */
+    int nfields,          /* I: number of extracted fields */
+    char *qa_infile,      /* I: input QA filename */
+    char *ptsfile,        /* I: points sidecar filename */
+    int format            /* I: OUT_STATS_* format of the points */
+);
+
+void free_qa_points
+(
+    Qa_points_t *pts      /* I/O: points */
+);
+
+#endif
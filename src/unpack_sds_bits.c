@@ -91,6 +91,7 @@
 "OPTIONS \n" \
 "    -help            Display this help message\n" \
 "    -of=filename     Output file \n" \
+SDS_COMPRESS_HELP(" ", "                     ") \
 "    -sds=<SDS list>  List of SDS to be unpacked (separated by commas). If\n"\
 "                     the SDS is 3D enter each SDS name in the list as\n"\
 "                     sdsname.n and if 4D enter sds_name.n.m where n and m\n"\
@@ -157,6 +158,7 @@
 "OPTIONS \n" \
 "    -help            Display this help message\n" \
 "    -of=filename     Output file \n" \
+SDS_COMPRESS_HELP(" ", "                     ") \
 "    -sds=<SDS list>  List of SDS to be unpacked (separated by commas). If\n"\
 "                     the SDS is 3D enter each SDS name in the list as\n"\
 "                     sdsname.n and if 4D enter sds_name.n.m where n and m\n"\
@@ -355,6 +357,7 @@ int parse_cmd_unpack_sds_bits(int argc, char **argv, int *if_cnt, char **sds_nam
 		int *sds_cnt, char **bn_str, int *bn_cnt, char *out_fname, int *m_opt, char *fillVal)
 {
   int i, status;
+  char comp_str[MAX_STR_LEN];
 
   status = 1;
   out_fname[0] = fillVal[0] = '\0';
@@ -371,6 +374,12 @@ int parse_cmd_unpack_sds_bits(int argc, char **argv, int *if_cnt, char **sds_nam
     else if ((is_arg_id(argv[i], "-of=") == 0) || (is_arg_id(argv[i], "-o=") == 0)) 
       get_arg_val(argv[i], out_fname);
 
+    else if (is_arg_id(argv[i], "-compress=") == 0)
+    {
+      get_arg_val(argv[i], comp_str);
+      if (set_sds_compress(comp_str) == -1) status = -1;
+    }
+
     else if ((is_arg_id(argv[i], "-bit=") == 0) || (is_arg_id(argv[i], "-bn=") == 0))
       get_arg_val_arr(argv[i], bn_str, bn_cnt);
 
@@ -413,10 +422,9 @@ void unpack_sds(char *in_fname, char **sds_names, char **bn_str, int bn_cnt, int
   int ndata_in = 0, ndata_out = 0;
   int max_nbit, *nbit, **bn_arr;
   int32 attr_type, attr_cnt;
-  int32 in_edge[4] = {0, 0, 0, 0}; 
-  int32 in_start[4] = {0, 0, 0, 0};
-  int32 out_edge[4] = {0, 0, 0, 0}; 
-  int32 out_start[4] = {0, 0, 0, 0};
+  long blk_mem;
+  int blk_st;
+  sds_block_t in_blk, out_blk[MAX_NUM_SDS];
   char tmp_str[MAX_PATH_LENGTH];
   void *data_in, *data_out, *attr_val = NULL;
   sds_t in_sds_info, out_sds_info[MAX_NUM_SDS];
@@ -573,46 +581,26 @@ if (if_cnt == 1)
     if ((data_out = (void *)calloc(ndata_out, out_sds_info[0].data_size)) == NULL)
       fprintf(stderr, "Cannot allocate memory for data_out in unpack_sds\n");
 
-    if ((data_in != NULL) && (data_out != NULL))
+    /* share the block memory budget among the input and output SDS */
+    blk_mem = SDS_BLOCK_MEM_TOTAL/(bn_cnt + 1);
+    if (blk_mem > SDS_BLOCK_MEM_SIZE) blk_mem = SDS_BLOCK_MEM_SIZE;
+    blk_st = open_sds_block(&in_sds_info, &in_blk, 'R', 1, blk_mem);
+    for (i=0; i<bn_cnt; i++)
     {
-      if (rank == 2)
-      {
-        in_edge[0] = out_edge[0] = 1;
-	in_edge[1] = out_edge[1] = in_sds_info.dim_size[1];
-	nrow = in_sds_info.dim_size[0];
-      }
-      else if (rank > 2)
-      {
-	nrow = (bsq == 1) ? in_sds_info.dim_size[rank-2] : in_sds_info.dim_size[0];
-	for (i=0; i<rank; i++)
-	  in_edge[i] = out_edge[i] = in_sds_info.dim_size[i];
-	if ((n == -1) && (m == -1))
-	{
-	  if (bsq == 0) in_edge[0] = out_edge[0] = 1;
-	  else in_edge[rank-2] = out_edge[rank-2] = 1;
-	}
-	else
-	{
-	  out_edge[0] = 1;
-	  out_edge[1] = out_dim_size[1];
-	  if (bsq == 0) in_edge[0] = 1;
-	  else in_edge[rank-2] = 1;
-	}
-      }
+      out_blk[i].buf = NULL;
+      if ((blk_st != -1) && (out_sds_info[i].sds_id != -1))
+        blk_st = open_sds_block(&out_sds_info[i], &out_blk[i], 'W', 1, blk_mem);
+    }
+
+    if ((data_in != NULL) && (data_out != NULL) && (blk_st != -1))
+    {
+      nrow = in_blk.nrows;
 
       compute_sds_start_offset(&in_sds_info, n, m, &st_c, &offset);
 
       for (irow=0; irow<nrow; irow++)
       {
-	if ((rank == 2) || (in_sds_info.dim_size[0] > in_sds_info.dim_size[rank-1]))
-	  in_start[0] = irow;
-	else
-	  in_start[rank-2] = irow;
-	if ((rank>2) && (n == -1) && (m == -1) && (in_sds_info.dim_size[rank-1]>in_sds_info.dim_size[0]))
-	  out_start[rank-2] = irow;
-        else 
-	  out_start[0] = irow;
-        if (SDreaddata(in_sds_info.sds_id, in_start, NULL, in_edge, data_in) == FAIL)
+        if (read_sds_block_rows(&in_blk, irow, 1, data_in) == -1)
 	{
 	  fprintf(stderr, "Cannot read data line from SDS %s in unpack_sds\n", in_sds_info.name);
 	  break;
@@ -620,11 +608,17 @@ if (if_cnt == 1)
 	for (i=0; i<bn_cnt; i++)
         {
           unpack_bits(data_in, data_out, &in_sds_info, nbit[i], bn_arr[i], ndata_out, st_c, offset);
-          if (SDwritedata(out_sds_info[i].sds_id, out_start, NULL, out_edge, data_out) == FAIL)
-	    fprintf(stderr, "Cannot write data line to SDS %s in unpack_sds\n", out_sds_info[i].name);
+          if (out_blk[i].buf != NULL)
+            if (write_sds_block_rows(&out_blk[i], irow, 1, data_out) == -1)
+	      fprintf(stderr, "Cannot write data line to SDS %s in unpack_sds\n", out_sds_info[i].name);
 	}
       }
     }
+    if (in_blk.buf != NULL) close_sds_block(&in_blk);
+    for (i=0; i<bn_cnt; i++)
+      if (out_blk[i].buf != NULL)
+        if (close_sds_block(&out_blk[i]) == -1)
+	  fprintf(stderr, "Cannot write data line to SDS %s in unpack_sds\n", out_sds_info[i].name);
     if (data_in != NULL) free(data_in);
     if (data_out != NULL) free(data_out);
     if (attr_val != NULL) free(attr_val);
@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "unpack_stats.h"
+
+/* Number of values of a quality field, which is at most 4 bits */
+#define STATS_MAX_VALUES 16
+
+/******************************************************************************
+MODULE:  init_qa_stats
+
+PURPOSE:  Allocate the zeroed histograms of the unpack threads.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Error allocating the histograms
+SUCCESS         Processing was successful
+
+NOTES:
+******************************************************************************/
+short init_qa_stats
+(
+    Qa_stats_t *stats,    /* O: statistics */
+    int nworkers          /* I: number of unpack threads */
+)
+{
+    char FUNC_NAME[] = "init_qa_stats"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+
+    stats->nworkers = nworkers;
+    stats->hist = (uint32 *) calloc ((size_t) nworkers * UNPACK_LUT_SIZE,
+        sizeof (uint32));
+    if (stats->hist == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the QA statistics");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  add_qa_stats
+
+PURPOSE:  Count QA values into the histogram of an unpack thread.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void add_qa_stats
+(
+    Qa_stats_t *stats,    /* I/O: statistics */
+    int worker,           /* I: index of the unpack thread */
+    uint16 *qa_buf,       /* I: QA values */
+    long npix             /* I: number of QA values */
+)
+{
+    uint32 *hist = &stats->hist[(size_t) worker * UNPACK_LUT_SIZE];
+    long pix;                /* looping variable */
+
+    for (pix = 0; pix < npix; pix++)
+        hist[qa_buf[pix]]++;
+}
+
+
+/******************************************************************************
+MODULE:  get_stats_filename
+
+PURPOSE:  Name the statistics sidecar after the output, without its .tif
+extension, followed by an underscore, the kind of sidecar and the extension
+of the format.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void get_stats_filename
+(
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    char *kind,           /* I: kind of sidecar, stats or estimate */
+    int format,           /* I: OUT_STATS_* format of the statistics */
+    char statsfile[STR_SIZE]  /* O: statistics sidecar filename */
+)
+{
+    int len;                 /* length of the output name to keep */
+
+    len = strlen (qa_outfile);
+    if (len > 4 && (!strcasecmp (&qa_outfile[len-4], ".tif")))
+        len -= 4;
+    else if (len > 5 && (!strcasecmp (&qa_outfile[len-5], ".tiff")))
+        len -= 5;
+    snprintf (statsfile, STR_SIZE, "%.*s_%s.%s", len, qa_outfile, kind,
+        (format == OUT_STATS_CSV) ? "csv" : "json");
+}
+
+
+/******************************************************************************
+MODULE:  write_json_string
+
+PURPOSE:  Write a string as a quoted JSON string.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void write_json_string
+(
+    FILE *fp,             /* I: statistics file pointer */
+    const char *str       /* I: string to write */
+)
+{
+    fputc ('"', fp);
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '"' || *str == '\\')
+            fputc ('\\', fp);
+        fputc (*str, fp);
+    }
+    fputc ('"', fp);
+}
+
+
+/******************************************************************************
+MODULE:  write_csv_string
+
+PURPOSE:  Write a string as a CSV field, quoted when it holds a comma, a
+quote or a line end.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void write_csv_string
+(
+    FILE *fp,             /* I: statistics file pointer */
+    const char *str       /* I: string to write */
+)
+{
+    if (strpbrk (str, ",\"\r\n") == NULL)
+    {
+        fputs (str, fp);
+        return;
+    }
+
+    fputc ('"', fp);
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '"')
+            fputc ('"', fp);
+        fputc (*str, fp);
+    }
+    fputc ('"', fp);
+}
+
+
+/******************************************************************************
+MODULE:  write_qa_stats
+
+PURPOSE:  Merge the histograms of the unpack threads, derive the pixel counts
+of each value of each quality field and write them to the statistics
+sidecar.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           Error writing the statistics
+SUCCESS         Processing was successful
+
+NOTES:
+1. For each field the pixels at or above its confidence level are also
+   counted as flagged, as in the combined mask.  Fields without a confidence
+   level are flagged for any nonzero value.
+2. The percentages of the fill field are of all the pixels.  Those of the
+   other fields are of the valid (non-fill) pixels.
+******************************************************************************/
+short write_qa_stats
+(
+    Qa_stats_t *stats,    /* I: statistics */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Confidence_t *qa_conf,  /* I: confidence level of each quality field */
+    char *qa_infile,      /* I: input QA filename */
+    char *statsfile,      /* I: statistics sidecar filename */
+    int format            /* I: OUT_STATS_* format of the statistics */
+)
+{
+    char FUNC_NAME[] = "write_qa_stats"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    const Qa_field_desc_t *desc;  /* description of the current field */
+    double *hist = NULL;     /* merged histogram */
+    double count[UNPACK_MAX_FIELDS][STATS_MAX_VALUES];
+                             /* pixels with each value of each field */
+    double flagged;          /* pixels flagged in the current field */
+    double total = 0.0;      /* number of pixels */
+    double fill = 0.0;       /* number of fill pixels */
+    double valid;            /* number of valid pixels */
+    double pct_base;         /* pixels the percentages are of */
+    long qa_val;             /* current QA value */
+    int i;                   /* looping variable */
+    int worker;              /* looping variable for the unpack threads */
+    int val;                 /* current field value */
+    int conf;                /* confidence level of the current field */
+    bool first = true;       /* first field written */
+    bool is_fill;            /* current QA value is fill */
+    FILE *fp = NULL;         /* statistics file pointer */
+
+    hist = (double *) calloc (UNPACK_LUT_SIZE, sizeof (double));
+    if (hist == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for the QA statistics");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    for (worker = 0; worker < stats->nworkers; worker++)
+        for (qa_val = 0; qa_val < UNPACK_LUT_SIZE; qa_val++)
+            hist[qa_val] += stats->hist[(size_t) worker * UNPACK_LUT_SIZE +
+                qa_val];
+
+    /* Count the pixels with each value of each field, fill pixels only
+       counting in the fill field */
+    memset (count, 0, sizeof (count));
+    for (qa_val = 0; qa_val < UNPACK_LUT_SIZE; qa_val++)
+    {
+        if (hist[qa_val] == 0.0)
+            continue;
+        total += hist[qa_val];
+        is_fill = false;
+        if (layout->fill_field >= 0)
+        {
+            desc = &layout->field[layout->fill_field];
+            is_fill = ((qa_val >> desc->shift) & desc->mask) != 0;
+        }
+        for (i = 0; i < layout->nfields; i++)
+        {
+            if (is_fill && i != layout->fill_field)
+                continue;
+            desc = &layout->field[i];
+            val = (qa_val >> desc->shift) & desc->mask &
+                (STATS_MAX_VALUES - 1);
+            count[i][val] += hist[qa_val];
+        }
+    }
+    free (hist);
+    if (layout->fill_field >= 0)
+        fill = count[layout->fill_field][1];
+    valid = total - fill;
+
+    fp = fopen (statsfile, "w");
+    if (fp == NULL)
+    {
+        sprintf (errmsg, "Error opening the QA statistics file %s",
+            statsfile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (format == OUT_STATS_JSON)
+    {
+        fprintf (fp, "{\n  \"qa_file\": ");
+        write_json_string (fp, qa_infile);
+        fprintf (fp, ",\n  \"product\": ");
+        write_json_string (fp, layout->product);
+        fprintf (fp, ",\n  \"total_pixels\": %.0f,\n  \"fill_pixels\": %.0f,"
+            "\n  \"valid_pixels\": %.0f,\n  \"fields\": [", total, fill,
+            valid);
+    }
+    else
+        fprintf (fp, "field,value,pixels,percent\n"
+            "all,total,%.0f,100.000\nall,valid,%.0f,%.3f\n", total, valid,
+            (total > 0.0) ? 100.0 * valid / total : 0.0);
+
+    for (i = 0; i < layout->nfields; i++)
+    {
+        desc = &layout->field[i];
+        if (desc->name == NULL)
+            continue;
+        pct_base = (i == layout->fill_field) ? total : valid;
+        conf = (qa_conf[i] == UNDEFINED) ? 1 : qa_conf[i];
+        flagged = 0.0;
+        for (val = conf; val <= desc->mask; val++)
+            flagged += count[i][val];
+
+        if (format == OUT_STATS_JSON)
+        {
+            fprintf (fp, "%s\n    {\"name\": ", first ? "" : ",");
+            write_json_string (fp, desc->name);
+            fprintf (fp, ", \"counts\": [");
+            for (val = 0; val <= desc->mask; val++)
+                fprintf (fp, "%s%.0f", (val > 0) ? ", " : "", count[i][val]);
+            fprintf (fp, "], \"percents\": [");
+            for (val = 0; val <= desc->mask; val++)
+                fprintf (fp, "%s%.3f", (val > 0) ? ", " : "",
+                    (pct_base > 0.0) ? 100.0 * count[i][val] / pct_base : 0.0);
+            fprintf (fp, "], \"flagged_at\": %d, \"flagged\": %.0f, "
+                "\"flagged_percent\": %.3f}", conf, flagged,
+                (pct_base > 0.0) ? 100.0 * flagged / pct_base : 0.0);
+        }
+        else
+        {
+            for (val = 0; val <= desc->mask; val++)
+                fprintf (fp, "%s,%d,%.0f,%.3f\n", desc->name, val,
+                    count[i][val], (pct_base > 0.0) ? 100.0 * count[i][val] /
+                    pct_base : 0.0);
+            fprintf (fp, "%s,flagged,%.0f,%.3f\n", desc->name, flagged,
+                (pct_base > 0.0) ? 100.0 * flagged / pct_base : 0.0);
+        }
+        first = false;
+    }
+
+    if (format == OUT_STATS_JSON)
+        fprintf (fp, "\n  ]\n}\n");
+
+    if (fclose (fp) != 0)
+    {
+        sprintf (errmsg, "Error writing the QA statistics file %s",
+            statsfile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  free_qa_stats
+
+PURPOSE:  Free the histograms of the unpack threads.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void free_qa_stats
+(
+    Qa_stats_t *stats     /* I/O: statistics */
+)
+{
+    free (stats->hist);
+    stats->hist = NULL;
+}
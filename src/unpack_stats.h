@@ -0,0 +1,69 @@
+#ifndef _UNPACK_STATS_H_
+#define _UNPACK_STATS_H_
+
+#include <stdio.h>
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+#include "unpack_layout.h"
+
+/* Pixel statistics of a QA band, gathered as a histogram of the 16-bit QA
+   values while it is unpacked.  Each unpack thread counts into its own
+   histogram, so the counts need no locking.  The field counts are derived
+   from the merged histogram when the statistics are written. */
+typedef struct
+{
+    int nworkers;         /* number of unpack threads counting */
+    uint32 *hist;         /* UNPACK_LUT_SIZE counts per unpack thread */
+} Qa_stats_t;
+
+short init_qa_stats
+(
+    Qa_stats_t *stats,    /* O: statistics */
+    int nworkers          /* I: number of unpack threads */
+);
+
+void add_qa_stats
+(
+    Qa_stats_t *stats,    /* I/O: statistics */
+    int worker,           /* I: index of the unpack thread */
+    uint16 *qa_buf,       /* I: QA values */
+    long npix             /* I: number of QA values */
+);
+
+void get_stats_filename
+(
+    char *qa_outfile,     /* I: output QA filename or base filename */
+    char *kind,           /* I: kind of sidecar, stats or estimate */
+    int format,           /* I: OUT_STATS_* format of the statistics */
+    char statsfile[STR_SIZE]  /* O: statistics sidecar filename */
+);
+
+void write_json_string
+(
+    FILE *fp,             /* I: statistics file pointer */
+    const char *str       /* I: string to write */
+);
+
+void write_csv_string
+(
+    FILE *fp,             /* I: statistics file pointer */
+    const char *str       /* I: string to write */
+);
+
+short write_qa_stats
+(
+    Qa_stats_t *stats,    /* I: statistics */
+    const Qa_layout_t *layout,  /* I: bit layout of the QA band */
+    Confidence_t *qa_conf,  /* I: confidence level of each quality field */
+    char *qa_infile,      /* I: input QA filename */
+    char *statsfile,      /* I: statistics sidecar filename */
+    int format            /* I: OUT_STATS_* format of the statistics */
+);
+
+void free_qa_stats
+(
+    Qa_stats_t *stats     /* I/O: statistics */
+);
+
+#endif
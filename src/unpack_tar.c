@@ -0,0 +1,645 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "unpack_tar.h"
+
+#if defined (WIN32) || defined (_WIN32)
+#define tar_fseek _fseeki64
+#else
+#define tar_fseek fseeko
+#endif
+
+/* A member of a tar bundle read as a file.  Members of compressed bundles are
+   decompressed into memory.  Members of uncompressed bundles are read in
+   place from the bundle. */
+typedef struct Tar_member_s
+{
+    char *path;           /* bundle:member path the member was opened as */
+    char bundle[STR_SIZE];  /* bundle filename */
+    uint64 offset;        /* offset of the data in an uncompressed bundle */
+    uint64 size;          /* size of the member */
+    uint8 *data;          /* data of the member of a compressed bundle, NULL
+                             if read in place */
+    int nrefs;            /* number of open tiff files using the member */
+    struct Tar_member_s *next;  /* next member opened */
+} Tar_member_t;
+
+/* One open tiff file reading a member */
+typedef struct
+{
+    Tar_member_t *member; /* member read */
+    FILE *fp;             /* bundle file pointer (if read in place) */
+    uint64 pos;           /* current position in the member */
+} Tar_handle_t;
+
+/* Members in use, shared by the tiff files opened on the same member so a
+   compressed bundle is only decompressed once however often the member is
+   opened, e.g. by each unpack thread */
+static Tar_member_t *open_members = NULL;
+static pthread_mutex_t open_members_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/******************************************************************************
+MODULE:  split_tar_path
+
+PURPOSE:  Split a bundle.tar:member, bundle.tar.gz:member or bundle.tgz:member
+path into the bundle filename and the member name.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The path names a member of a bundle
+false           The path is a plain filename
+
+NOTES:
+******************************************************************************/
+static bool split_tar_path
+(
+    char *path,           /* I: input path */
+    char bundle[STR_SIZE],  /* O: bundle filename */
+    char **member         /* O: member name, within path */
+)
+{
+    static const char *suffix[] = {".tar:", ".tar.gz:", ".tgz:"};
+    char *colon;             /* current colon in the path */
+    int len;                 /* length of the current suffix */
+    int i;                   /* looping variable */
+
+    for (colon = strchr (path, ':'); colon != NULL;
+        colon = strchr (colon + 1, ':'))
+    {
+        for (i = 0; i < (int) (sizeof (suffix) / sizeof (suffix[0])); i++)
+        {
+            len = strlen (suffix[i]) - 1;
+            if (colon - path < len || strncasecmp (colon - len, suffix[i],
+                len) != 0 || colon - path >= STR_SIZE)
+                continue;
+            snprintf (bundle, STR_SIZE, "%.*s", (int) (colon - path), path);
+            *member = colon + 1;
+            return (true);
+        }
+    }
+
+    return (false);
+}
+
+
+/******************************************************************************
+MODULE:  parse_tar_size
+
+PURPOSE:  Parse the size field of a tar header, octal or, for large members,
+GNU base-256.
+
+RETURN VALUE:
+Type = uint64
+Value           Description
+-----           -----------
+n               Size in bytes
+
+NOTES:
+******************************************************************************/
+static uint64 parse_tar_size
+(
+    const uint8 *field    /* I: 12-byte size field */
+)
+{
+    uint64 size = 0;         /* parsed size */
+    int i;                   /* looping variable */
+
+    if (field[0] & 0x80)
+    {
+        for (i = 1; i < 12; i++)
+            size = (size << 8) | field[i];
+        return (size);
+    }
+
+    for (i = 0; i < 12 && field[i] == ' '; i++)
+        ;
+    for (; i < 12 && field[i] >= '0' && field[i] <= '7'; i++)
+        size = (size << 3) | (field[i] - '0');
+    return (size);
+}
+
+
+/******************************************************************************
+MODULE:  find_tar_member
+
+PURPOSE:  Scan the headers of a tar bundle, compressed with gzip or not, for a
+member and either record where its data is in an uncompressed bundle or
+decompress it into memory.
+
+RETURN VALUE:
+Type = short
+Value           Description
+-----           -----------
+ERROR           The bundle couldn't be read or doesn't hold the member
+SUCCESS         Processing was successful
+
+NOTES:
+1. zlib reads uncompressed bundles as they are, so both kinds are scanned the
+   same way.  The data of the other members is skipped, not read.
+2. GNU long names are followed.  The path records of pax headers are not.
+3. A leading ./ is ignored in the member names.
+******************************************************************************/
+static short find_tar_member
+(
+    char *member_name,    /* I: member to find */
+    Tar_member_t *member  /* I/O: member, with its bundle filename set */
+)
+{
+    char FUNC_NAME[] = "find_tar_member"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    uint8 header[TAR_BLOCK_SIZE];  /* current header */
+    char name[STR_SIZE];     /* name of the current member */
+    char *long_name = NULL;  /* GNU long name of the next member */
+    uint64 size;             /* size of the current member */
+    uint64 padded;           /* size padded to whole blocks */
+    uint64 nread;            /* bytes of the member read */
+    int nbytes;              /* bytes read at once */
+    int i;                   /* looping variable */
+    short status = ERROR;    /* return status */
+    gzFile gz;               /* bundle, possibly compressed */
+
+    if (!strncmp (member_name, "./", 2))
+        member_name += 2;
+
+    gz = gzopen (member->bundle, "rb");
+    if (gz == NULL)
+    {
+        sprintf (errmsg, "Error opening the tar bundle %s", member->bundle);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    gzbuffer (gz, 128 * 1024);
+
+    while (gzread (gz, header, TAR_BLOCK_SIZE) == TAR_BLOCK_SIZE)
+    {
+        /* The archive ends with zero blocks */
+        for (i = 0; i < TAR_BLOCK_SIZE && header[i] == 0; i++)
+            ;
+        if (i == TAR_BLOCK_SIZE)
+            break;
+
+        size = parse_tar_size (&header[124]);
+        padded = (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE *
+            TAR_BLOCK_SIZE;
+
+        /* Read the long name of the next member */
+        if (header[156] == 'L' && size < STR_SIZE)
+        {
+            free (long_name);
+            long_name = (char *) calloc (padded + 1, 1);
+            if (long_name == NULL || gzread (gz, long_name, padded) !=
+                (int) padded)
+                break;
+            continue;
+        }
+
+        if (long_name != NULL)
+            snprintf (name, STR_SIZE, "%s", long_name);
+        else if (!strncmp ((char *) &header[257], "ustar", 5) &&
+            header[345] != '\0')
+            snprintf (name, STR_SIZE, "%.155s/%.100s", &header[345],
+                header);
+        else
+            snprintf (name, STR_SIZE, "%.100s", header);
+        free (long_name);
+        long_name = NULL;
+
+        if ((header[156] == '0' || header[156] == '\0') &&
+            !strcmp (!strncmp (name, "./", 2) ? &name[2] : name,
+            member_name))
+        {
+            member->size = size;
+            if (gzdirect (gz))
+            {
+                /* Read the member in place from the bundle */
+                member->offset = gztell (gz);
+                status = SUCCESS;
+                break;
+            }
+
+            member->data = (uint8 *) malloc (size > 0 ? size : 1);
+            if (member->data == NULL)
+            {
+                sprintf (errmsg, "Error allocating memory for %s from %s",
+                    member_name, member->bundle);
+                error_handler (true, FUNC_NAME, errmsg);
+                gzclose (gz);
+                return (ERROR);
+            }
+            for (nread = 0; nread < size; nread += nbytes)
+            {
+                nbytes = (size - nread > (1 << 30)) ? (1 << 30) :
+                    (int) (size - nread);
+                if (gzread (gz, &member->data[nread], nbytes) != nbytes)
+                    break;
+            }
+            if (nread == size)
+                status = SUCCESS;
+            else
+            {
+                free (member->data);
+                member->data = NULL;
+            }
+            break;
+        }
+
+        /* Skip the data of the member */
+        if (padded > 0 && gzseek (gz, (z_off_t) padded, SEEK_CUR) == -1)
+            break;
+    }
+    free (long_name);
+    gzclose (gz);
+
+    if (status != SUCCESS)
+    {
+        sprintf (errmsg, "Error reading %s from the tar bundle %s",
+            member_name, member->bundle);
+        error_handler (true, FUNC_NAME, errmsg);
+    }
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  get_tar_member
+
+PURPOSE:  Get a member in use by its path, or else find it in its bundle and
+add it to the members in use.
+
+RETURN VALUE:
+Type = Tar_member_t *
+Value           Description
+-----           -----------
+NULL            Error reading the member
+Tar_member_t *  Member, with a reference taken for the caller
+
+NOTES:
+1. The bundle is scanned without holding the lock, so batch jobs can read
+   their bundles at the same time.
+******************************************************************************/
+static Tar_member_t *get_tar_member
+(
+    char *path,           /* I: bundle:member path */
+    char *bundle,         /* I: bundle filename */
+    char *member_name     /* I: member name */
+)
+{
+    char FUNC_NAME[] = "get_tar_member"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    Tar_member_t *member;    /* member in use or found */
+    Tar_member_t *found;     /* member found in the bundle */
+
+    pthread_mutex_lock (&open_members_lock);
+    for (member = open_members; member != NULL; member = member->next)
+        if (!strcmp (member->path, path))
+            break;
+    if (member != NULL)
+        member->nrefs++;
+    pthread_mutex_unlock (&open_members_lock);
+    if (member != NULL)
+        return (member);
+
+    found = (Tar_member_t *) calloc (1, sizeof (Tar_member_t));
+    if (found == NULL || (found->path = strdup (path)) == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for %s", path);
+        error_handler (true, FUNC_NAME, errmsg);
+        free (found);
+        return (NULL);
+    }
+    snprintf (found->bundle, STR_SIZE, "%s", bundle);
+    if (find_tar_member (member_name, found) != SUCCESS)
+    {
+        free (found->path);
+        free (found);
+        return (NULL);
+    }
+
+    /* Another thread may have found the member meanwhile */
+    pthread_mutex_lock (&open_members_lock);
+    for (member = open_members; member != NULL; member = member->next)
+        if (!strcmp (member->path, path))
+            break;
+    if (member == NULL)
+    {
+        member = found;
+        member->next = open_members;
+        open_members = member;
+        found = NULL;
+    }
+    member->nrefs++;
+    pthread_mutex_unlock (&open_members_lock);
+
+    if (found != NULL)
+    {
+        free (found->data);
+        free (found->path);
+        free (found);
+    }
+    return (member);
+}
+
+
+/******************************************************************************
+MODULE:  release_tar_member
+
+PURPOSE:  Drop a reference to a member, freeing it when no tiff file uses it.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void release_tar_member
+(
+    Tar_member_t *member  /* I: member */
+)
+{
+    Tar_member_t **prev;     /* link to the current member */
+
+    pthread_mutex_lock (&open_members_lock);
+    if (--member->nrefs > 0)
+    {
+        pthread_mutex_unlock (&open_members_lock);
+        return;
+    }
+    for (prev = &open_members; *prev != NULL; prev = &(*prev)->next)
+    {
+        if (*prev == member)
+        {
+            *prev = member->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock (&open_members_lock);
+
+    free (member->data);
+    free (member->path);
+    free (member);
+}
+
+
+/******************************************************************************
+MODULE:  tar_read_proc, tar_write_proc, tar_seek_proc, tar_close_proc,
+         tar_size_proc, tar_map_proc, tar_unmap_proc
+
+PURPOSE:  libtiff client procedures reading a tar member as a file.
+
+RETURN VALUE:
+As the libtiff client procedures.
+
+NOTES:
+1. Members decompressed into memory are also handed to libtiff as mapped,
+   so their uncompressed strips are used without another copy.
+******************************************************************************/
+static tsize_t tar_read_proc
+(
+    thandle_t fd,         /* I: tar handle */
+    tdata_t buf,          /* O: data read */
+    tsize_t size          /* I: number of bytes to read */
+)
+{
+    Tar_handle_t *handle = (Tar_handle_t *) fd;
+    Tar_member_t *member = handle->member;
+    size_t nbytes;           /* bytes read */
+
+    if (handle->pos >= member->size || size <= 0)
+        return (0);
+    if ((uint64) size > member->size - handle->pos)
+        size = (tsize_t) (member->size - handle->pos);
+
+    if (member->data != NULL)
+    {
+        memcpy (buf, &member->data[handle->pos], size);
+        nbytes = size;
+    }
+    else
+        nbytes = fread (buf, 1, size, handle->fp);
+    handle->pos += nbytes;
+    return ((tsize_t) nbytes);
+}
+
+static tsize_t tar_write_proc
+(
+    thandle_t fd,         /* I: tar handle */
+    tdata_t buf,          /* I: data to write */
+    tsize_t size          /* I: number of bytes to write */
+)
+{
+    (void) fd;
+    (void) buf;
+    (void) size;
+    return (0);
+}
+
+static toff_t tar_seek_proc
+(
+    thandle_t fd,         /* I: tar handle */
+    toff_t off,           /* I: offset */
+    int whence            /* I: SEEK_SET, SEEK_CUR or SEEK_END */
+)
+{
+    Tar_handle_t *handle = (Tar_handle_t *) fd;
+    uint64 pos;              /* new position */
+
+    if (whence == SEEK_CUR)
+        pos = handle->pos + off;
+    else if (whence == SEEK_END)
+        pos = handle->member->size + off;
+    else
+        pos = off;
+
+    if (handle->member->data == NULL && tar_fseek (handle->fp,
+        handle->member->offset + pos, SEEK_SET) != 0)
+        return ((toff_t) -1);
+    handle->pos = pos;
+    return ((toff_t) pos);
+}
+
+static int tar_close_proc
+(
+    thandle_t fd          /* I: tar handle */
+)
+{
+    Tar_handle_t *handle = (Tar_handle_t *) fd;
+
+    if (handle->fp != NULL)
+        fclose (handle->fp);
+    release_tar_member (handle->member);
+    free (handle);
+    return (0);
+}
+
+static toff_t tar_size_proc
+(
+    thandle_t fd          /* I: tar handle */
+)
+{
+    return ((toff_t) ((Tar_handle_t *) fd)->member->size);
+}
+
+static int tar_map_proc
+(
+    thandle_t fd,         /* I: tar handle */
+    tdata_t *base,        /* O: start of the member in memory */
+    toff_t *size          /* O: size of the member */
+)
+{
+    Tar_handle_t *handle = (Tar_handle_t *) fd;
+
+    if (handle->member->data == NULL)
+        return (0);
+    *base = handle->member->data;
+    *size = handle->member->size;
+    return (1);
+}
+
+static void tar_unmap_proc
+(
+    thandle_t fd,         /* I: tar handle */
+    tdata_t base,         /* I: start of the member in memory */
+    toff_t size           /* I: size of the member */
+)
+{
+    (void) fd;
+    (void) base;
+    (void) size;
+}
+
+
+/******************************************************************************
+MODULE:  open_qa_tiff
+
+PURPOSE:  Open an input QA file for reading, either a GeoTIFF file or a
+GeoTIFF member of a Landsat tar bundle named as bundle.tar:member,
+bundle.tar.gz:member or bundle.tgz:member.
+
+RETURN VALUE:
+Type = TIFF *
+Value           Description
+-----           -----------
+NULL            Error opening the file or member
+TIFF *          tiff file pointer, to be closed with XTIFFClose
+
+NOTES:
+1. A member is read through libtiff client procedures, so the bundle is
+   never extracted.  A member of an uncompressed bundle is read in place; a
+   member of a compressed bundle is decompressed into memory once and shared
+   by all the tiff files open on it.
+******************************************************************************/
+TIFF *open_qa_tiff
+(
+    char *infile          /* I: input filename, or bundle.tar[.gz]:member */
+)
+{
+    char FUNC_NAME[] = "open_qa_tiff"; /* function name */
+    char errmsg[STR_SIZE];   /* error message */
+    char bundle[STR_SIZE];   /* bundle filename */
+    char *member_name;       /* member name */
+    Tar_handle_t *handle;    /* handle of the member */
+    TIFF *fp_tiff;           /* tiff file pointer */
+
+    if (!split_tar_path (infile, bundle, &member_name))
+        return (XTIFFOpen (infile, "r"));
+
+    handle = (Tar_handle_t *) calloc (1, sizeof (Tar_handle_t));
+    if (handle == NULL)
+    {
+        sprintf (errmsg, "Error allocating memory for %s", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (NULL);
+    }
+    handle->member = get_tar_member (infile, bundle, member_name);
+    if (handle->member == NULL)
+    {
+        free (handle);
+        return (NULL);
+    }
+
+    if (handle->member->data == NULL)
+    {
+        handle->fp = fopen (bundle, "rb");
+        if (handle->fp == NULL || tar_fseek (handle->fp,
+            handle->member->offset, SEEK_SET) != 0)
+        {
+            sprintf (errmsg, "Error opening the tar bundle %s", bundle);
+            error_handler (true, FUNC_NAME, errmsg);
+            tar_close_proc ((thandle_t) handle);
+            return (NULL);
+        }
+    }
+
+    /* The close procedure is only called by XTIFFClose, not when the open
+       fails */
+    fp_tiff = XTIFFClientOpen (infile, "r", (thandle_t) handle, tar_read_proc,
+        tar_write_proc, tar_seek_proc, tar_close_proc, tar_size_proc,
+        tar_map_proc, tar_unmap_proc);
+    if (fp_tiff == NULL)
+    {
+        sprintf (errmsg, "Error opening %s as a TIFF file", infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        tar_close_proc ((thandle_t) handle);
+    }
+    return (fp_tiff);
+}
+
+
+/******************************************************************************
+MODULE:  get_qa_basename
+
+PURPOSE:  Get the name of the QA file without its directory, the member name
+for a member of a bundle.
+
+RETURN VALUE:
+Type = char *
+Value           Description
+-----           -----------
+char *          Basename, within infile
+
+NOTES:
+******************************************************************************/
+char *get_qa_basename
+(
+    char *infile          /* I: input filename, or bundle.tar[.gz]:member */
+)
+{
+    char bundle[STR_SIZE];   /* bundle filename */
+    char *name;              /* file or member name */
+    char *slash;             /* last slash of the name */
+
+    if (!split_tar_path (infile, bundle, &name))
+        name = infile;
+    slash = strrchr (name, '/');
+    return ((slash != NULL) ? slash + 1 : name);
+}
+
+
+/******************************************************************************
+MODULE:  is_tar_member
+
+PURPOSE:  Tell whether the QA filename names a member of a tar bundle.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The file is a member of a tar bundle
+false           The file is a plain file
+
+NOTES:
+******************************************************************************/
+bool is_tar_member
+(
+    char *infile          /* I: input filename, or bundle.tar[.gz]:member */
+)
+{
+    char bundle[STR_SIZE];   /* bundle filename */
+    char *name;              /* member name */
+
+    return (split_tar_path (infile, bundle, &name));
+}
@@ -0,0 +1,30 @@
+#ifndef _UNPACK_TAR_H_
+#define _UNPACK_TAR_H_
+
+#include "xtiffio.h"
+#include "bool.h"
+#include "error_handler.h"
+
+#ifndef STR_SIZE
+#define STR_SIZE 1024
+#endif
+
+/* Size of a tar header and of the blocks the member data is padded to */
+#define TAR_BLOCK_SIZE 512
+
+TIFF *open_qa_tiff
+(
+    char *infile          /* I: input filename, or bundle.tar[.gz]:member */
+);
+
+char *get_qa_basename
+(
+    char *infile          /* I: input filename, or bundle.tar[.gz]:member */
+);
+
+bool is_tar_member
+(
+    char *infile          /* I: input filename, or bundle.tar[.gz]:member */
+);
+
+#endif